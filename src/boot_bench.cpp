@@ -0,0 +1,291 @@
+// -----------------------------------------------------------
+// boot_bench.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Boot-time benchmark
+// -----------------------------------------------------------
+
+#include "boot_bench.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "log.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+const char* const BootBench::DEFAULT_PHASES =
+    "post=console:Starting up the system,"
+    "menu=console:System Maintenance Menu,"
+    "kernel=pc:a800000000000000-a8000000ffffffff,"
+    "login=console:login:";
+
+static uint64_t wall_ns()
+{
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+BootBench::BootBench()
+{
+}
+
+BootBench::~BootBench()
+{
+    if (perf_fd >= 0)
+        ::close(perf_fd);
+}
+
+// -----------------------------------------------------------
+// Milestone spec
+// -----------------------------------------------------------
+bool BootBench::parse(const std::string& spec, std::vector<Milestone>& out)
+{
+    out.clear();
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos)
+            end = spec.size();
+        const std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty())
+            continue;
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos || eq == 0) {
+            Log::err() << "[BOOT] Bad milestone '" << item << "' (want name=console:... or name=pc:lo-hi)\n";
+            return false;
+        }
+
+        Milestone m;
+        m.name = item.substr(0, eq);
+        const std::string what = item.substr(eq + 1);
+
+        if (what.compare(0, 8, "console:") == 0 && what.size() > 8) {
+            m.console = true;
+            m.text = what.substr(8);
+        } else if (what.compare(0, 3, "pc:") == 0) {
+            m.console = false;
+            char* dash = nullptr;
+            m.lo = std::strtoull(what.c_str() + 3, &dash, 16);
+            if (!dash || *dash != '-') {
+                Log::err() << "[BOOT] Bad PC range in '" << item << "'\n";
+                return false;
+            }
+            m.hi = std::strtoull(dash + 1, nullptr, 16);
+            m.text = what.substr(3);
+        } else {
+            Log::err() << "[BOOT] Bad milestone '" << item << "'\n";
+            return false;
+        }
+        out.push_back(m);
+    }
+    return !out.empty();
+}
+
+// -----------------------------------------------------------
+// Measurement
+// -----------------------------------------------------------
+BootBench::Mark BootBench::mark() const
+{
+    Mark m;
+    m.wall_ns = wall_ns();
+    m.guest   = sched->now();
+
+    uint64_t v;
+    if (perf_fd >= 0 && ::read(perf_fd, &v, sizeof(v)) == (ssize_t)sizeof(v))
+        m.host = (int64_t)v;
+    return m;
+}
+
+bool BootBench::start(const std::vector<Milestone>& p, uint64_t timeout_cycles,
+                      std::function<void()> done_cb)
+{
+    if (!cpu || !sched || p.empty())
+        return false;
+
+    phases  = p;
+    on_done = std::move(done_cb);
+    next    = 0;
+    done    = false;
+
+    max_pattern = 0;
+    for (const Milestone& m : phases)
+        if (m.console && m.text.size() > max_pattern)
+            max_pattern = m.text.size();
+    console_tail.clear();
+
+#ifdef __linux__
+    // User-space instructions retired by this (the CPU) thread
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    perf_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf_fd < 0)
+        Log::err() << "[BOOT] Host instruction counter unavailable (perf_event_paranoid?)\n";
+#endif
+
+    marks.clear();
+    marks.push_back(mark());
+    deadline = sched->now() + timeout_cycles;
+
+    sched->schedule(POLL_CYCLES, [this]() { poll(); });
+
+    Log::out() << "[BOOT] Benchmark started: " << phases.size() << " milestones\n";
+    return true;
+}
+
+void BootBench::on_console(uint8_t c)
+{
+    if (done || max_pattern == 0)
+        return;
+
+    console_tail.push_back((char)c);
+    if (console_tail.size() > 2 * max_pattern)
+        console_tail.erase(0, console_tail.size() - max_pattern);
+
+    const Milestone& m = phases[next];
+    if (m.console && console_tail.size() >= m.text.size() &&
+        console_tail.compare(console_tail.size() - m.text.size(), m.text.size(), m.text) == 0)
+        reach();
+}
+
+void BootBench::poll()
+{
+    if (done)
+        return;
+
+    const Milestone& m = phases[next];
+    if (!m.console) {
+        const uint64_t pc = cpu->getPC();
+        if (pc >= m.lo && pc <= m.hi)
+            reach();
+    }
+    if (done)
+        return;
+
+    if (sched->now() >= deadline) {
+        Log::out() << "[BOOT] Time limit reached before '" << phases[next].name << "'\n";
+        finish();
+        return;
+    }
+    sched->schedule(POLL_CYCLES, [this]() { poll(); });
+}
+
+void BootBench::reach()
+{
+    marks.push_back(mark());
+    const Mark& a = marks[marks.size() - 2];
+    const Mark& b = marks.back();
+    char line[128];
+    std::snprintf(line, sizeof(line), "[BOOT] %-10s %9.1f ms  %13llu guest instr\n",
+                  phases[next].name.c_str(), (b.wall_ns - a.wall_ns) / 1e6,
+                  (unsigned long long)(b.guest - a.guest));
+    Log::out() << line;
+
+    if (++next == phases.size())
+        finish();
+    else
+        console_tail.clear();
+}
+
+void BootBench::finish()
+{
+    end  = marks.size() == phases.size() + 1 ? marks.back() : mark();
+    done = true;
+    if (on_done)
+        on_done();
+}
+
+// -----------------------------------------------------------
+// Report
+// -----------------------------------------------------------
+static std::string json_str(const std::string& s)
+{
+    std::string o = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            o += '\\';
+            o += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            o += buf;
+        } else {
+            o += c;
+        }
+    }
+    return o + "\"";
+}
+
+static std::string json_host(int64_t a, int64_t b)
+{
+    return (a < 0 || b < 0) ? "null" : std::to_string(b - a);
+}
+
+bool BootBench::write_json(const std::string& path) const
+{
+    if (marks.empty())
+        return false;
+
+    std::ofstream out(path);
+    if (!out) {
+        Log::err() << "[BOOT] Cannot write " << path << "\n";
+        return false;
+    }
+
+    // Phases never reached are listed with "reached": false
+    const Mark& first = marks.front();
+    const Mark  last  = done ? end : mark();
+    char num[64];
+
+    out << "{\n  \"racer_boot_bench\": 1,\n";
+    out << "  \"completed\": " << (next == phases.size() ? "true" : "false") << ",\n";
+    out << "  \"host_instructions_scope\": \"emulator thread, user space\",\n";
+
+    std::snprintf(num, sizeof(num), "%.3f", (last.wall_ns - first.wall_ns) / 1e6);
+    out << "  \"total\": { \"wall_ms\": " << num
+        << ", \"guest_instructions\": " << (last.guest - first.guest)
+        << ", \"host_instructions\": " << json_host(first.host, last.host) << " },\n";
+
+    out << "  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const Milestone& m = phases[i];
+        out << (i ? ",\n" : "\n") << "    { \"name\": " << json_str(m.name)
+            << ", \"milestone\": " << json_str((m.console ? "console:" : "pc:") + m.text);
+
+        if (i + 1 >= marks.size()) {
+            out << ", \"reached\": false }";
+            continue;
+        }
+
+        const Mark& a = marks[i];
+        const Mark& b = marks[i + 1];
+        const double ms = (b.wall_ns - a.wall_ns) / 1e6;
+        const uint64_t guest = b.guest - a.guest;
+
+        std::snprintf(num, sizeof(num), "%.3f", ms);
+        out << ", \"reached\": true, \"wall_ms\": " << num
+            << ", \"guest_instructions\": " << guest
+            << ", \"host_instructions\": " << json_host(a.host, b.host);
+        std::snprintf(num, sizeof(num), "%.2f", ms > 0 ? guest / (ms * 1e3) : 0.0);
+        out << ", \"guest_mips\": " << num;
+        std::snprintf(num, sizeof(num), "%.3f", (b.wall_ns - first.wall_ns) / 1e6);
+        out << ", \"at_wall_ms\": " << num << " }";
+    }
+    out << "\n  ]\n}\n";
+
+    Log::out() << "[BOOT] Report written to " << path << "\n";
+    return true;
+}
@@ -0,0 +1,92 @@
+// -----------------------------------------------------------
+// boot_bench.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Boot-time benchmark: wall time, guest and host instructions
+// per boot phase
+//
+//   - A phase ends at a milestone: a console string (watched on
+//     the UART transmit path) or the PC entering an address range
+//     (polled from the scheduler every POLL_CYCLES)
+//   - Milestones are taken strictly in order; the first phase
+//     starts at reset
+//   - Host instructions come from perf_event_open on the
+//     emulator thread; null in the report when not permitted
+//   - Stops the run once the last milestone is reached or the
+//     guest-time limit expires, and writes a JSON report
+//
+// Milestone spec: comma-separated name=console:<text> or
+// name=pc:<lo hex>-<hi hex>, e.g.
+//   post=console:Starting up the system,kernel=pc:a800000000000000-a8000000ffffffff
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class CPU;
+class Scheduler;
+
+class BootBench {
+public:
+    // PROM power-on to IRIX login
+    static const char* const DEFAULT_PHASES;
+
+    static constexpr uint64_t POLL_CYCLES = 1950;   // 10 us of guest time
+
+    struct Milestone {
+        std::string name;
+        bool        console = true;     // else PC range
+        std::string text;
+        uint64_t    lo = 0, hi = 0;
+    };
+
+    static bool parse(const std::string& spec, std::vector<Milestone>& out);
+
+    BootBench();
+    ~BootBench();
+
+    void attach_cpu(CPU* c) { cpu = c; }
+    void attach_scheduler(Scheduler* s) { sched = s; }
+
+    // on_done runs (on the CPU thread) when the last milestone is
+    // reached or after timeout_cycles of guest time
+    bool start(const std::vector<Milestone>& phases, uint64_t timeout_cycles,
+               std::function<void()> on_done);
+
+    // UART transmit tap
+    void on_console(uint8_t c);
+
+    bool finished() const { return done; }
+    bool write_json(const std::string& path) const;
+
+private:
+    struct Mark {
+        uint64_t wall_ns = 0;
+        uint64_t guest   = 0;       // instructions (one per cycle)
+        int64_t  host    = -1;      // -1 = no counter
+    };
+
+    CPU*       cpu   = nullptr;
+    Scheduler* sched = nullptr;
+
+    std::vector<Milestone> phases;
+    std::vector<Mark>      marks;   // marks[0] = start, marks[i+1] = phase i done
+    Mark     end;                   // when finished (last milestone or time limit)
+    size_t   next     = 0;
+    uint64_t deadline = 0;
+    bool     done     = false;
+    std::function<void()> on_done;
+
+    std::string console_tail;       // last bytes, for pattern matching
+    size_t      max_pattern = 0;
+
+    int perf_fd = -1;
+
+    Mark mark() const;
+    void poll();
+    void reach();
+    void finish();
+};
@@ -7,6 +7,7 @@
 
 #include "cp0.h"
 #include "cpu.h"
+#include "log.h"
 
 CP0::CP0() {}
 CP0::~CP0() {}
@@ -24,7 +25,7 @@ void CP0::reset() {
 
     prid = 0x00000000;     // placeholder (R10000 PRID later)
 
-    std::cout << "[CP0] Reset complete.\n";
+    Log::out() << "[CP0] Reset complete.\n";
 }
 
 void CP0::attach_cpu(CPU* c) {
@@ -52,7 +53,7 @@ uint64_t CP0::read_reg(uint32_t idx) const {
         case 14: return epc;
         case 15: return prid;
         default:
-            std::cerr << "[CP0] Warning: unimplemented register read " << idx << "\n";
+            RLOG_FIRST(CP0, Warn, 8, "unimplemented register read %llu", idx);
             return 0;
     }
 }
@@ -74,8 +75,7 @@ void CP0::write_reg(uint32_t idx, uint64_t value) {
         case 13: cause     = value; break;
         case 14: epc       = value; break;
         default:
-            std::cerr << "[CP0] Warning: unimplemented register write " 
-                      << idx << " = 0x" << std::hex << value << std::dec << "\n";
+            RLOG_FIRST(CP0, Warn, 8, "unimplemented register write %llu = 0x%llx", idx, value);
             break;
     }
 }
@@ -93,9 +93,17 @@ void CP0::raise_exception(uint32_t code, uint64_t badaddr) {
     // Set EXL bit (bit 1)
     status |= (1 << 1);
 
-    std::cerr << "[CP0] Exception " << code 
-              << " at PC=0x" << std::hex << epc 
-              << " badaddr=0x" << badaddr << std::dec << "\n";
+    // Routine for the guest (TLB refills, syscalls): debug only
+    RLOG(CP0, Debug, "Exception %llu at PC=0x%llx badaddr=0x%llx", code, epc, badaddr);
+}
+
+// -----------------------------------------------------------
+// set_interrupt_pending() - hardware interrupt lines
+// -----------------------------------------------------------
+void CP0::set_interrupt_pending(uint32_t line, bool pending) {
+    uint64_t bit = 1ULL << (8 + (line & 7));
+    if (pending) cause |= bit;
+    else         cause &= ~bit;
 }
 
 // -----------------------------------------------------------
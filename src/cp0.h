@@ -37,6 +37,9 @@ public:
     // Exception handling (minimal)
     void raise_exception(uint32_t code, uint64_t badaddr);
 
+    // External interrupt lines: sets/clears Cause.IP[line] (bits 8..15)
+    void set_interrupt_pending(uint32_t line, bool pending);
+
     // State queries
     bool is_tlb_enabled() const;
 
@@ -3,11 +3,12 @@
 // Part 1 — Includes, CPU State, Constructor, Reset
 // -----------------------------------------------------------
 
-#include <iostream>
 #include <cstring>
 #include "cpu.h"
 #include "mmu.h"
 #include "cp0.h"
+#include "log.h"
+#include "perf_counters.h"
 
 // -----------------------------------------------------------
 // CPU Constructor
@@ -64,8 +65,10 @@ void CPU::connect(MMU* m, CP0* c)
 // -----------------------------------------------------------
 void CPU::decode_and_execute(uint32_t instr)
 {
+    PROFILE_INSN(profile, instr);
+
     // Implemented fully in Part 2 / 3 / 4
-    std::cerr << "[CPU] ERROR: decode_and_execute called before implementation.\n";
+    Log::err() << "[CPU] ERROR: decode_and_execute called before implementation.\n";
 }
 
 // -----------------------------------------------------------
@@ -85,13 +88,9 @@ void CPU::init_decode_tables()
 // Part 2 — Decode Tables + Initialization
 // -----------------------------------------------------------
 
-// Function type for instruction handlers
-typedef void (*InstrFunc)(CPU*, uint32_t);
-
-// Primary opcode tables
-static InstrFunc OPC_MAIN[64];
-static InstrFunc OPC_SPECIAL[64];
-static InstrFunc OPC_REGIMM[32];
+// Opcode tables are CPU members (opc_main, opc_special,
+// opc_regimm; InstrFunc is in cpu.h), so every machine in the
+// process decodes through its own copy
 
 // Helper extract macros
 #define OP(instr)     (((instr) >> 26) & 0x3F)
@@ -137,14 +136,17 @@ static void instr_SLL(CPU*, uint32_t);
 static void instr_SRL(CPU*, uint32_t);
 static void instr_SRA(CPU*, uint32_t);
 
+// COP0 (Part 11)
+static void instr_COP0_extended(CPU*, uint32_t);
+
 // -----------------------------------------------------------
 // Unimplemented instruction handler
 // -----------------------------------------------------------
 static void instr_UNIMP(CPU* c, uint32_t instr)
 {
-    std::cerr << "[CPU] Unimplemented instruction opcode=0x"
-              << std::hex << instr << std::dec
-              << " at PC=0x" << std::hex << c->pc << std::dec << "\n";
+    PROFILE_UNIMP(c->exec_profile(), instr);
+    RLOG_FIRST(CPU, Warn, 16, "Unimplemented instruction opcode=0x%llx at PC=0x%llx",
+               instr, c->pc);
 }
 
 // -----------------------------------------------------------
@@ -154,52 +156,57 @@ void CPU::init_decode_tables()
 {
     // Fill all entries with unimplemented handler
     for (int i = 0; i < 64; i++)
-        OPC_MAIN[i] = instr_UNIMP;
+        opc_main[i] = instr_UNIMP;
 
     for (int i = 0; i < 64; i++)
-        OPC_SPECIAL[i] = instr_UNIMP;
+        opc_special[i] = instr_UNIMP;
 
     for (int i = 0; i < 32; i++)
-        OPC_REGIMM[i] = instr_UNIMP;
+        opc_regimm[i] = instr_UNIMP;
 
     // -------------------------------------------------------
     // MAIN opcodes
     // -------------------------------------------------------
-    OPC_MAIN[0x02] = instr_J;
-    OPC_MAIN[0x03] = instr_JAL;
-    OPC_MAIN[0x04] = instr_BEQ;
-    OPC_MAIN[0x05] = instr_BNE;
-    OPC_MAIN[0x08] = instr_ADDIU;
-    OPC_MAIN[0x09] = instr_ADDIU;
-    OPC_MAIN[0x0A] = instr_SLTI;
-    OPC_MAIN[0x0B] = instr_SLTIU;
-    OPC_MAIN[0x0F] = instr_LUI;
-
-    OPC_MAIN[0x20] = instr_LB;
-    OPC_MAIN[0x23] = instr_LW;
-    OPC_MAIN[0x28] = instr_SB;
-    OPC_MAIN[0x2B] = instr_SW;
+    opc_main[0x02] = instr_J;
+    opc_main[0x03] = instr_JAL;
+    opc_main[0x04] = instr_BEQ;
+    opc_main[0x05] = instr_BNE;
+    opc_main[0x08] = instr_ADDIU;
+    opc_main[0x09] = instr_ADDIU;
+    opc_main[0x0A] = instr_SLTI;
+    opc_main[0x0B] = instr_SLTIU;
+    opc_main[0x0F] = instr_LUI;
+
+    opc_main[0x20] = instr_LB;
+    opc_main[0x23] = instr_LW;
+    opc_main[0x28] = instr_SB;
+    opc_main[0x2B] = instr_SW;
 
     // -------------------------------------------------------
     // SPECIAL opcodes (funct field)
     // -------------------------------------------------------
-    OPC_SPECIAL[0x08] = instr_JR;
-    OPC_SPECIAL[0x0C] = instr_SYSCALL;
-    OPC_SPECIAL[0x20] = instr_ADDU;
-    OPC_SPECIAL[0x24] = instr_AND;
-    OPC_SPECIAL[0x25] = instr_OR;
-    OPC_SPECIAL[0x26] = instr_XOR;
-    OPC_SPECIAL[0x27] = instr_NOR;
-
-    OPC_SPECIAL[0x00] = instr_SLL;
-    OPC_SPECIAL[0x02] = instr_SRL;
-    OPC_SPECIAL[0x03] = instr_SRA;
+    opc_special[0x08] = instr_JR;
+    opc_special[0x0C] = instr_SYSCALL;
+    opc_special[0x20] = instr_ADDU;
+    opc_special[0x24] = instr_AND;
+    opc_special[0x25] = instr_OR;
+    opc_special[0x26] = instr_XOR;
+    opc_special[0x27] = instr_NOR;
+
+    opc_special[0x00] = instr_SLL;
+    opc_special[0x02] = instr_SRL;
+    opc_special[0x03] = instr_SRA;
 
     // -------------------------------------------------------
     // REGIMM opcodes (PROM uses BLTZ/BGEZ later)
     // Will be implemented in Part 5
     // -------------------------------------------------------
 
+    // -------------------------------------------------------
+    // COP0: MFC0/MTC0/ERET and the TLB ops (Parts 9 and 11)
+    // -------------------------------------------------------
+    opc_main[0x10] = instr_COP0_extended;
+
     // end Part 2
 }
 
@@ -262,6 +269,11 @@ void CPU::store16_be(uint64_t addr, uint16_t val)
 
 void CPU::raise_exception(int code)
 {
+    PROFILE_EXC(profile, code);
+    TRACE_EXC(tracer, code, pc);
+    if (perf)
+        perf->exceptions[code & 31].add();
+
     // Set CP0 Cause and EPC
     if (cp0)
         cp0->raise_exception(code, pc);
@@ -450,6 +462,7 @@ static void instr_LW(CPU* c, uint32_t ins)
 {
     uint64_t addr = c->regs[RS(ins)] + SE16(IMM(ins));
     c->regs[RT(ins)] = c->load32_be(addr);
+    TRACE_LOAD(c->tracer, addr, (uint32_t)c->regs[RT(ins)], 4);
 }
 
 static void instr_LB(CPU* c, uint32_t ins)
@@ -457,6 +470,7 @@ static void instr_LB(CPU* c, uint32_t ins)
     uint64_t addr = c->regs[RS(ins)] + SE16(IMM(ins));
     int8_t v = (int8_t)c->load8(addr);
     c->regs[RT(ins)] = (int64_t)v;
+    TRACE_LOAD(c->tracer, addr, (uint8_t)v, 1);
 }
 
 
@@ -466,12 +480,14 @@ static void instr_LB(CPU* c, uint32_t ins)
 static void instr_SW(CPU* c, uint32_t ins)
 {
     uint64_t addr = c->regs[RS(ins)] + SE16(IMM(ins));
+    TRACE_STORE(c->tracer, addr, (uint32_t)c->regs[RT(ins)], 4);
     c->store32_be(addr, (uint32_t)c->regs[RT(ins)]);
 }
 
 static void instr_SB(CPU* c, uint32_t ins)
 {
     uint64_t addr = c->regs[RS(ins)] + SE16(IMM(ins));
+    TRACE_STORE(c->tracer, addr, (uint8_t)c->regs[RT(ins)], 1);
     c->store8(addr, (uint8_t)c->regs[RT(ins)]);
 }
 
@@ -689,6 +705,7 @@ void CPU::stepOnce()
 {
     // Fetch next instruction
     uint32_t ins = load32_be(pc);
+    TRACE_INSN(tracer, pc, ins);
 
     // The instruction after this one
     uint64_t oldPC   = pc;
@@ -702,6 +719,7 @@ void CPU::stepOnce()
 
     // Enforce register $0 = 0
     regs[0] = 0;
+    TRACE_RETIRE(tracer, ins, regs);
 
     // ------------------------------------------
     // Handle delayed branch slot
@@ -721,10 +739,12 @@ void CPU::stepOnce()
 
         // Execute delay slot instruction (one instruction)
         uint32_t delayIns = load32_be(oldPC + 4);
+        TRACE_INSN(tracer, oldPC + 4, delayIns);
         decode_and_execute(delayIns);
 
         // Enforce $0 again
         regs[0] = 0;
+        TRACE_RETIRE(tracer, delayIns, regs);
 
         // Now jump to branch target
         pc     = branchTarget;
@@ -839,6 +859,11 @@ bool CPU::hiloBusy() const
 
 void CPU::handle_exception(int code)
 {
+    PROFILE_EXC(profile, code);
+    TRACE_EXC(tracer, code, pc);
+    if (perf)
+        perf->exceptions[code & 31].add();
+
     // CP0 must calculate EPC
     if (cp0)
         cp0->raise_exception(code, pc);
@@ -907,7 +932,7 @@ static void instr_COP0(CPU* c, uint32_t ins)
             return;
         } else {
             // No CP0 connected; treat like NOP or raise exception
-            std::cerr << "[CPU] ERET executed but CP0 missing\n";
+            RLOG_FIRST(CPU, Error, 1, "ERET executed but CP0 missing");
             return;
         }
     }
@@ -920,7 +945,7 @@ static void instr_COP0(CPU* c, uint32_t ins)
     if (rs == 0x00) {
         // MFC0: move from CP0 register rd -> GPR rt
         if (!c->cp0) {
-            std::cerr << "[CPU] MFC0 but CP0 missing\n";
+            RLOG_FIRST(CPU, Error, 1, "MFC0 but CP0 missing");
             c->regs[rt] = 0;
             return;
         }
@@ -932,7 +957,7 @@ static void instr_COP0(CPU* c, uint32_t ins)
     if (rs == 0x04) {
         // MTC0: move GPR rt -> CP0 register rd
         if (!c->cp0) {
-            std::cerr << "[CPU] MTC0 but CP0 missing\n";
+            RLOG_FIRST(CPU, Error, 1, "MTC0 but CP0 missing");
             return;
         }
         c->cp0->write_reg(rd, c->regs[rt]);
@@ -940,29 +965,10 @@ static void instr_COP0(CPU* c, uint32_t ins)
     }
 
     // Unhandled COP0 sub-op: log and ignore
-    std::cerr << "[CPU] Unhandled COP0 ins rs=0x" << std::hex << rs
-              << " rt=0x" << rt << " rd=0x" << rd << " ins=0x"
-              << ins << std::dec << "\n";
-}
-
-
-// Patch the primary table entry for COP0 (opcode 0x10).
-// We do this here so init_decode_tables() doesn't have to know about COP0
-// (but if init_decode_tables() runs again, it will be overridden by it).
-static void ensure_cop0_mapped()
-{
-    // primary_table is defined in Part 6
-    extern instr_func primary_table[];
-    primary_table[0x10] = instr_COP0;
+    RLOG_FIRST(CPU, Warn, 8, "Unhandled COP0 ins rs=0x%llx rt=0x%llx rd=0x%llx ins=0x%llx",
+               rs, rt, rd, ins);
 }
 
-// Make sure COP0 is mapped at CPU construction time.
-// We add a small shim: if init_decode_tables already called, ensure mapping here.
-// If CPU constructor calls init_decode_tables (it does), calling this function
-// again will simply overwrite primary_table[0x10] -> instr_COP0.
-struct _EnsureCOP0Mapped {
-    _EnsureCOP0Mapped() { ensure_cop0_mapped(); }
-} _ensure_cop0_mapped_instance;
 
 
 // -----------------------------------------------------------
@@ -993,8 +999,13 @@ struct _EnsureCOP0Mapped {
 // -----------------------------------------------------------
 void CPU::enter_exception(int code, uint64_t badPC)
 {
+    PROFILE_EXC(profile, code);
+    TRACE_EXC(tracer, code, badPC);
+    if (perf)
+        perf->exceptions[code & 31].add();
+
     if (!cp0) {
-        std::cerr << "[CPU] enter_exception() but CP0 missing\n";
+        Log::err() << "[CPU] enter_exception() but CP0 missing\n";
         return;
     }
 
@@ -1111,7 +1122,7 @@ void CPU::address_error()
 static void instr_TLBR(CPU* c)
 {
     if (!c->mmu || !c->cp0) {
-        std::cerr << "[CPU] TLBR but MMU/CP0 missing\n";
+        Log::err() << "[CPU] TLBR but MMU/CP0 missing\n";
         return;
     }
     c->mmu->tlbr(c->cp0); // read TLB into CP0.EntryHi/EntryLo registers
@@ -1120,7 +1131,7 @@ static void instr_TLBR(CPU* c)
 static void instr_TLBWI(CPU* c)
 {
     if (!c->mmu || !c->cp0) {
-        std::cerr << "[CPU] TLBWI but MMU/CP0 missing\n";
+        Log::err() << "[CPU] TLBWI but MMU/CP0 missing\n";
         return;
     }
     c->mmu->tlbwi(c->cp0); // write CP0.EntryHi/EntryLo into TLB index
@@ -1129,7 +1140,7 @@ static void instr_TLBWI(CPU* c)
 static void instr_TLBWR(CPU* c)
 {
     if (!c->mmu || !c->cp0) {
-        std::cerr << "[CPU] TLBWR but MMU/CP0 missing\n";
+        Log::err() << "[CPU] TLBWR but MMU/CP0 missing\n";
         return;
     }
     c->mmu->tlbwr(c->cp0); // write CP0.EntryHi/EntryLo into TLB random slot
@@ -1138,7 +1149,7 @@ static void instr_TLBWR(CPU* c)
 static void instr_TLBP(CPU* c)
 {
     if (!c->mmu || !c->cp0) {
-        std::cerr << "[CPU] TLBP but MMU/CP0 missing\n";
+        Log::err() << "[CPU] TLBP but MMU/CP0 missing\n";
         return;
     }
     c->mmu->tlbp(c->cp0); // probe TLB and set Index
@@ -1169,21 +1180,7 @@ static void instr_COP0_extended(CPU* c, uint32_t ins)
     instr_COP0(c, ins);
 }
 
-
-// -----------------------------------------------------------
-// Hook extended COP0 handler into primary opcode table
-// -----------------------------------------------------------
-static void ensure_cop0_extended()
-{
-    extern instr_func primary_table[];
-    primary_table[0x10] = instr_COP0_extended;
-}
-
-// Auto-run mapping on startup
-struct _EnsureCOP0Ext {
-    _EnsureCOP0Ext() { ensure_cop0_extended(); }
-} _ensure_cop0extended_instance;
-
+// instr_COP0_extended is mapped at opcode 0x10 by init_decode_tables()
 
 
 // -----------------------------------------------------------
@@ -1264,7 +1261,7 @@ bool CPU::translate_address(uint64_t vaddr, uint64_t& paddr, bool write)
     // Otherwise use MMU TLB translation
     if (!mmu)
     {
-        std::cerr << "[CPU] MMU missing for mapped address\n";
+        Log::err() << "[CPU] MMU missing for mapped address\n";
         return false;
     }
 
@@ -1443,18 +1440,16 @@ void CPU::connect_all(MMU* m, CP0* c, Memory* memptr)
 // -----------------------------------------------------------
 void CPU::run(uint64_t instr_count)
 {
-    std::cout << "[Racer][CPU] Starting run: " << instr_count << " instructions\n";
     for (uint64_t i = 0; i < instr_count; ++i)
     {
         step_with_exceptions();
 
         // Optional: allow external break/halt points in future
         if (halted) {
-            std::cout << "[Racer][CPU] halted at PC=0x" << std::hex << pc << std::dec << "\n";
+            Log::out() << "[Racer][CPU] halted at PC=0x" << std::hex << pc << std::dec << "\n";
             break;
         }
     }
-    std::cout << "[Racer][CPU] Run complete. cycles=" << cycles << "\n";
 }
 
 // -----------------------------------------------------------
@@ -1462,30 +1457,32 @@ void CPU::run(uint64_t instr_count)
 // -----------------------------------------------------------
 void CPU::dump_regs()
 {
-    std::cout << "[Racer][CPU] Register file dump:\n";
+    Log::out() << "[Racer][CPU] Register file dump:\n";
     for (int i = 0; i < 32; i += 4)
     {
-        printf("r%02d: 0x%016llx  r%02d: 0x%016llx  r%02d: 0x%016llx  r%02d: 0x%016llx\n",
-               i,  (unsigned long long)regs[i],
-               i+1,(unsigned long long)regs[i+1],
-               i+2,(unsigned long long)regs[i+2],
-               i+3,(unsigned long long)regs[i+3]);
+        char line[128];
+        snprintf(line, sizeof(line), "r%02d: 0x%016llx  r%02d: 0x%016llx  r%02d: 0x%016llx  r%02d: 0x%016llx\n",
+                 i,  (unsigned long long)regs[i],
+                 i+1,(unsigned long long)regs[i+1],
+                 i+2,(unsigned long long)regs[i+2],
+                 i+3,(unsigned long long)regs[i+3]);
+        Log::out() << line;
     }
-    std::cout << "HI: 0x" << std::hex << hi << "  LO: 0x" << lo << std::dec << "\n";
-    std::cout << "PC: 0x" << std::hex << pc << "  nextPC: 0x" << nextPC << std::dec << "\n";
+    Log::out() << "HI: 0x" << std::hex << hi << "  LO: 0x" << lo << std::dec << "\n";
+    Log::out() << "PC: 0x" << std::hex << pc << "  nextPC: 0x" << nextPC << std::dec << "\n";
 }
 
 void CPU::dump_state()
 {
-    std::cout << "[Racer][CPU] State dump:\n";
+    Log::out() << "[Racer][CPU] State dump:\n";
     dump_regs();
     if (cp0) {
-        std::cout << "[Racer][CPU] CP0 registers (partial):\n";
-        std::cout << " Status: 0x" << std::hex << cp0->read_reg(12) << std::dec << "\n";
-        std::cout << " Cause : 0x" << std::hex << cp0->read_reg(13) << std::dec << "\n";
-        std::cout << " EPC   : 0x" << std::hex << cp0->read_reg(14) << std::dec << "\n";
+        Log::out() << "[Racer][CPU] CP0 registers (partial):\n";
+        Log::out() << " Status: 0x" << std::hex << cp0->read_reg(12) << std::dec << "\n";
+        Log::out() << " Cause : 0x" << std::hex << cp0->read_reg(13) << std::dec << "\n";
+        Log::out() << " EPC   : 0x" << std::hex << cp0->read_reg(14) << std::dec << "\n";
     } else {
-        std::cout << "[Racer][CPU] CP0 not attached\n";
+        Log::out() << "[Racer][CPU] CP0 not attached\n";
     }
 }
 
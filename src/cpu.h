@@ -10,11 +10,18 @@
 #pragma once
 #include <cstdint>
 #include <iostream>
+#include "profile.h"
+#include "trace.h"
 
 // Forward declarations to avoid circular includes
 class MMU;
 class CP0;
 class Memory;
+struct PerfEvents;
+class CPU;
+
+// Instruction handler (cpu.cpp)
+typedef void (*InstrFunc)(CPU*, uint32_t);
 
 // -----------------------------------------------------------
 // CPU class
@@ -28,6 +35,9 @@ public:
     void reset();
     void stepOnce_mmu();
 
+    // Execute up to 'instr_count' instructions (stops if halted)
+    void run(uint64_t instr_count);
+
     // Attach subsystems
     void attach_mmu(MMU *m);
     void attach_cp0(CP0 *c);
@@ -45,6 +55,15 @@ public:
     bool is_halted() const;
     void halt() { halted = true; }
 
+    // Opcode / exception counters (live only with -DRACER_PROFILE)
+    ExecProfile& exec_profile() { return profile; }
+
+    // Binary trace sink (used only with -DRACER_TRACE); nullptr = off
+    void attach_tracer(Tracer* t) { tracer = t; }
+
+    // Live counters (see perf_counters.h); nullptr = off
+    void attach_perf(PerfEvents* p) { perf = p; }
+
 private:
     // General-purpose registers (MIPS64 has 32)
     uint64_t regs[32];
@@ -64,4 +83,14 @@ private:
     MMU *mmu = nullptr;
     CP0 *cp0 = nullptr;
     Memory *mem = nullptr;
+
+    // Decode tables, filled by init_decode_tables(). Owned by each
+    // CPU: machines in one process share no mutable state.
+    InstrFunc opc_main[64];
+    InstrFunc opc_special[64];
+    InstrFunc opc_regimm[32];
+
+    ExecProfile profile;
+    Tracer*     tracer = nullptr;
+    PerfEvents* perf   = nullptr;
 };
@@ -0,0 +1,321 @@
+// -----------------------------------------------------------
+// block_backend.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// io_uring / thread-pool block backends
+// -----------------------------------------------------------
+
+#include "block_backend.h"
+#include "cow_image.h"
+#include "../log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(RACER_USE_URING) && defined(__linux__) && __has_include(<liburing.h>)
+#define RACER_HAVE_URING 1
+#include <liburing.h>
+#endif
+
+// Open the image and find its size; shared by both engines
+static int open_image(const std::string& path, bool read_only, uint64_t& size)
+{
+    int fd = ::open(path.c_str(), read_only ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        Log::err() << "[BLK] Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        Log::err() << "[BLK] fstat " << path << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return -1;
+    }
+
+    off_t end = lseek(fd, 0, SEEK_END);   // also works for block devices
+    size = end > 0 ? (uint64_t)end : (uint64_t)st.st_size;
+    return fd;
+}
+
+// Complete a request synchronously (thread pool worker)
+static void do_request(int fd, BlockRequest* r)
+{
+    switch (r->op)
+    {
+    case BlockRequest::Op::Read:
+    {
+        uint32_t done = 0;
+        while (done < r->length) {
+            ssize_t n = pread(fd, r->buf + done, r->length - done, (off_t)(r->offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) { r->result = -errno; return; }
+            if (n == 0) {
+                // Past end of image: reads as zeros
+                std::memset(r->buf + done, 0, r->length - done);
+                break;
+            }
+            done += (uint32_t)n;
+        }
+        r->result = r->length;
+        return;
+    }
+
+    case BlockRequest::Op::Write:
+    {
+        uint32_t done = 0;
+        while (done < r->length) {
+            ssize_t n = pwrite(fd, r->buf + done, r->length - done, (off_t)(r->offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { r->result = n < 0 ? -errno : -EIO; return; }
+            done += (uint32_t)n;
+        }
+        r->result = done;
+        return;
+    }
+
+    case BlockRequest::Op::Flush:
+        r->result = (fdatasync(fd) == 0) ? 0 : -errno;
+        return;
+    }
+}
+
+// -----------------------------------------------------------
+// Thread pool: workers run execute(), finished requests go to a
+// done list the emulator thread drains in reap()
+// -----------------------------------------------------------
+ThreadPoolBackend::~ThreadPoolBackend()
+{
+    stop_workers();
+}
+
+void ThreadPoolBackend::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        quitting = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers)
+        t.join();
+    workers.clear();
+}
+
+bool ThreadPoolBackend::submit(BlockRequest* r)
+{
+    if (read_only() && r->op == BlockRequest::Op::Write) {
+        r->result = -EROFS;
+        std::lock_guard<std::mutex> lk(mtx);
+        finished.push_back(r);
+        outstanding++;
+        return true;
+    }
+
+    // Started here rather than in the constructor so no worker can
+    // call execute() before the subclass is fully constructed
+    if (workers.empty()) {
+        for (int i = 0; i < NUM_WORKERS; i++)
+            workers.emplace_back(&ThreadPoolBackend::worker, this, Log::context());
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        queue.push_back(r);
+        outstanding++;
+    }
+    cv.notify_one();
+    return true;
+}
+
+size_t ThreadPoolBackend::reap(std::vector<BlockRequest*>& done)
+{
+    std::lock_guard<std::mutex> lk(mtx);
+    size_t n = finished.size();
+    done.insert(done.end(), finished.begin(), finished.end());
+    finished.clear();
+    outstanding -= (uint32_t)n;
+    return n;
+}
+
+void ThreadPoolBackend::worker(const char* log_name)
+{
+    Log::Context log_ctx(log_name);
+    for (;;) {
+        BlockRequest* r;
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [this] { return quitting || !queue.empty(); });
+            if (queue.empty())
+                return;         // quitting, and every queued write is done
+            r = queue.front();
+            queue.pop_front();
+        }
+
+        execute(r);
+
+        std::lock_guard<std::mutex> lk(mtx);
+        finished.push_back(r);
+    }
+}
+
+// Plain image file or block device
+class RawFileBackend : public ThreadPoolBackend {
+public:
+    RawFileBackend(int f, uint64_t sz, bool ro) : fd(f), bytes(sz), ro(ro) {}
+
+    ~RawFileBackend() override
+    {
+        stop_workers();
+        ::close(fd);
+    }
+
+    uint64_t    size() const override      { return bytes; }
+    bool        read_only() const override { return ro; }
+    const char* kind() const override      { return "thread pool"; }
+
+protected:
+    void execute(BlockRequest* r) override { do_request(fd, r); }
+
+private:
+    int      fd;
+    uint64_t bytes;
+    bool     ro;
+};
+
+#ifdef RACER_HAVE_URING
+// -----------------------------------------------------------
+// io_uring: submission and completion both happen on the
+// emulator thread; no helper threads, no locks
+// -----------------------------------------------------------
+class UringBackend : public BlockBackend {
+public:
+    UringBackend(int f, uint64_t sz, bool ro) : fd(f), bytes(sz), ro(ro) {}
+
+    ~UringBackend() override
+    {
+        // Drain so the kernel is done with our buffers
+        while (outstanding) {
+            struct io_uring_cqe* cqe;
+            if (io_uring_wait_cqe(&ring, &cqe) != 0)
+                break;
+            io_uring_cqe_seen(&ring, cqe);
+            outstanding--;
+        }
+        if (ring_ok)
+            io_uring_queue_exit(&ring);
+        ::close(fd);
+    }
+
+    bool init()
+    {
+        ring_ok = io_uring_queue_init(QUEUE_DEPTH, &ring, 0) == 0;
+        return ring_ok;
+    }
+
+    uint64_t    size() const override      { return bytes; }
+    bool        read_only() const override { return ro; }
+    const char* kind() const override      { return "io_uring"; }
+    uint32_t    in_flight() const override { return outstanding; }
+
+    bool submit(BlockRequest* r) override
+    {
+        if (ro && r->op == BlockRequest::Op::Write) {
+            r->result = -EROFS;
+            rejected.push_back(r);
+            return true;
+        }
+
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe) {
+            io_uring_submit(&ring);
+            sqe = io_uring_get_sqe(&ring);
+            if (!sqe)
+                return false;
+        }
+
+        switch (r->op)
+        {
+        case BlockRequest::Op::Read:
+            io_uring_prep_read(sqe, fd, r->buf, r->length, r->offset);
+            break;
+        case BlockRequest::Op::Write:
+            io_uring_prep_write(sqe, fd, r->buf, r->length, r->offset);
+            break;
+        case BlockRequest::Op::Flush:
+            io_uring_prep_fsync(sqe, fd, IORING_FSYNC_DATASYNC);
+            break;
+        }
+        io_uring_sqe_set_data(sqe, r);
+        io_uring_submit(&ring);
+        outstanding++;
+        return true;
+    }
+
+    size_t reap(std::vector<BlockRequest*>& done) override
+    {
+        size_t n = rejected.size();
+        done.insert(done.end(), rejected.begin(), rejected.end());
+        rejected.clear();
+
+        struct io_uring_cqe* cqe;
+        while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+            BlockRequest* r = (BlockRequest*)io_uring_cqe_get_data(cqe);
+            r->result = cqe->res;
+
+            // Short read at end of image reads as zeros
+            if (r->op == BlockRequest::Op::Read && cqe->res >= 0 && (uint32_t)cqe->res < r->length) {
+                std::memset(r->buf + cqe->res, 0, r->length - cqe->res);
+                r->result = r->length;
+            }
+
+            io_uring_cqe_seen(&ring, cqe);
+            outstanding--;
+            done.push_back(r);
+            n++;
+        }
+        return n;
+    }
+
+private:
+    static constexpr unsigned QUEUE_DEPTH = 64;
+
+    int      fd;
+    uint64_t bytes;
+    bool     ro;
+    bool     ring_ok = false;
+    struct io_uring ring;
+    uint32_t outstanding = 0;
+    std::vector<BlockRequest*> rejected;
+};
+#endif
+
+// -----------------------------------------------------------
+// Factory
+// -----------------------------------------------------------
+BlockBackend* BlockBackend::open(const std::string& path, bool read_only)
+{
+    if (CowImage::is_overlay(path))
+        return CowImage::open(path, read_only);
+
+    uint64_t size = 0;
+    int fd = open_image(path, read_only, size);
+    if (fd < 0)
+        return nullptr;
+
+#ifdef RACER_HAVE_URING
+    UringBackend* u = new UringBackend(fd, size, read_only);
+    if (u->init())
+        return u;
+
+    // Kernel without io_uring (or blocked by seccomp): fall back.
+    // The fd is needed again, so reopen rather than share it.
+    delete u;
+    fd = open_image(path, read_only, size);
+    if (fd < 0)
+        return nullptr;
+#endif
+
+    return new RawFileBackend(fd, size, read_only);
+}
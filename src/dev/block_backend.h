@@ -0,0 +1,92 @@
+// -----------------------------------------------------------
+// block_backend.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Asynchronous host storage for emulated disks
+//
+//   - submit() queues a read/write/flush and returns at once
+//   - reap() collects finished requests without blocking; the
+//     emulator thread calls it from scheduler events, so guest
+//     execution never waits on host I/O
+//   - Linux io_uring when built with -DRACER_USE_URING (and
+//     -luring), otherwise a small pread/pwrite thread pool
+//   - Copy-on-write overlays (cow_image.h) are recognised by
+//     open() and served on top of their read-only base image
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct BlockRequest {
+    enum class Op { Read, Write, Flush };
+
+    Op       op     = Op::Read;
+    uint64_t offset = 0;          // bytes into the image
+    uint32_t length = 0;
+    uint8_t* buf    = nullptr;    // owned by the submitter until reaped
+    int64_t  result = 0;          // bytes transferred or -errno
+    void*    user   = nullptr;
+};
+
+class BlockBackend {
+public:
+    virtual ~BlockBackend() {}
+
+    virtual uint64_t    size() const = 0;
+    virtual bool        read_only() const = 0;
+    virtual const char* kind() const = 0;
+
+    // Emulator thread only
+    virtual bool   submit(BlockRequest* r) = 0;
+    virtual size_t reap(std::vector<BlockRequest*>& done) = 0;
+
+    // Requests submitted but not yet reaped
+    virtual uint32_t in_flight() const = 0;
+
+    // Open an image file with the best available engine.
+    // Returns nullptr (after printing why) on failure.
+    static BlockBackend* open(const std::string& path, bool read_only);
+};
+
+// -----------------------------------------------------------
+// Worker pool engine: each request is carried out synchronously
+// by execute() on one of a few host threads, finished requests
+// wait on a done list for reap(). Raw image files use it as is;
+// formats layered on files (cow_image.h) subclass it.
+// -----------------------------------------------------------
+class ThreadPoolBackend : public BlockBackend {
+public:
+    ~ThreadPoolBackend() override;
+
+    bool     submit(BlockRequest* r) override;
+    size_t   reap(std::vector<BlockRequest*>& done) override;
+    uint32_t in_flight() const override { return outstanding; }
+
+protected:
+    // Worker thread; must set r->result
+    virtual void execute(BlockRequest* r) = 0;
+
+    // Run what is still queued, then join the workers. Subclass
+    // destructors call this before tearing down anything execute()
+    // uses.
+    void stop_workers();
+
+private:
+    static constexpr int NUM_WORKERS = 4;
+
+    std::vector<std::thread>   workers;      // started on first submit
+    std::mutex                 mtx;
+    std::condition_variable    cv;
+    std::deque<BlockRequest*>  queue;
+    std::vector<BlockRequest*> finished;
+    uint32_t                   outstanding = 0;
+    bool                       quitting = false;
+
+    void worker(const char* log_name);
+};
@@ -0,0 +1,108 @@
+// -----------------------------------------------------------
+// cdrom_image.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// mmap-backed ISO image with sequential readahead
+// -----------------------------------------------------------
+
+#include "cdrom_image.h"
+#include "../log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+CDROMImage::CDROMImage() {}
+
+CDROMImage::~CDROMImage()
+{
+    close();
+}
+
+bool CDROMImage::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Log::err() << "[CDROM] Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        Log::err() << "[CDROM] Empty or unreadable image: " << path << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);   // the mapping keeps the file referenced
+    if (m == MAP_FAILED) {
+        Log::err() << "[CDROM] mmap " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    map        = (const uint8_t*)m;
+    map_size   = (uint64_t)st.st_size;
+    image_path = path;
+
+    // Random access until proven otherwise (e.g. directory lookups)
+    madvise((void*)map, map_size, MADV_RANDOM);
+
+    Log::out() << "[CDROM] " << path << ": " << sectors() << " sectors ("
+               << map_size / (1024 * 1024) << " MB), mapped read-only\n";
+    return true;
+}
+
+void CDROMImage::close()
+{
+    if (map) {
+        munmap((void*)map, map_size);
+        map = nullptr;
+    }
+    map_size = 0;
+    last_end = seq_run = advised_end = 0;
+}
+
+const uint8_t* CDROMImage::access(uint64_t offset, uint64_t len)
+{
+    if (!map || offset > map_size || len > map_size - offset)
+        return nullptr;
+
+    if (offset == last_end) {
+        seq_run += len;
+        if (seq_run >= SEQ_TRIGGER)
+            readahead(offset + len);
+    } else {
+        seq_run = len;
+        advised_end = 0;
+    }
+    last_end = offset + len;
+
+    return map + offset;
+}
+
+// -----------------------------------------------------------
+// readahead() - keep a window in front of a sequential reader.
+// Advice is issued in WINDOW/2 steps so a stream of small reads
+// costs one madvise per few MB, not one per command.
+// -----------------------------------------------------------
+void CDROMImage::readahead(uint64_t from)
+{
+    const uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+
+    if (advised_end > from + WINDOW / 2)
+        return;
+
+    uint64_t start = std::max(from, advised_end) & ~(page - 1);
+    uint64_t end   = std::min(from + WINDOW, map_size);
+    if (start >= end)
+        return;
+
+    madvise((void*)(map + start), (size_t)(end - start), MADV_WILLNEED);
+    advised_end = end;
+}
@@ -0,0 +1,54 @@
+// -----------------------------------------------------------
+// cdrom_image.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Read-only ISO image for the SCSI CD-ROM target
+//
+//   - The whole image is mmap()ed read-only; READ commands copy
+//     straight from the mapping into guest RAM, no bounce buffer
+//   - Sequential access (inst reading packages) is detected and
+//     the kernel is asked to read ahead with MADV_WILLNEED, so
+//     page faults are mostly served from the page cache
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+class CDROMImage {
+public:
+    static constexpr uint32_t SECTOR_SIZE = 2048;
+
+    CDROMImage();
+    ~CDROMImage();
+
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t size() const    { return map_size; }
+    uint64_t sectors() const { return map_size / SECTOR_SIZE; }
+    const std::string& path() const { return image_path; }
+
+    // Pointer into the mapping for [offset, offset + len); records
+    // the access for readahead. nullptr if out of range.
+    const uint8_t* access(uint64_t offset, uint64_t len);
+
+private:
+    std::string    image_path;
+    const uint8_t* map      = nullptr;
+    uint64_t       map_size = 0;
+
+    // ---- readahead
+    // A read that starts where the previous one ended extends the
+    // sequential run; once the run is long enough, keep WINDOW
+    // bytes ahead of the reader advised.
+    static constexpr uint64_t SEQ_TRIGGER = 256 * 1024;
+    static constexpr uint64_t WINDOW      = 8 * 1024 * 1024;
+
+    uint64_t last_end     = 0;
+    uint64_t seq_run      = 0;
+    uint64_t advised_end  = 0;
+
+    void readahead(uint64_t from);
+};
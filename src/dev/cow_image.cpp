@@ -0,0 +1,494 @@
+// -----------------------------------------------------------
+// cow_image.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Copy-on-write overlay disk images
+// -----------------------------------------------------------
+
+#include "cow_image.h"
+#include "../log.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char COW_MAGIC[8] = { 'R', 'A', 'C', 'E', 'R', 'C', 'O', 'W' };
+
+// pread the whole range; past end of file reads as zeros.
+// Returns 0 or -errno.
+static int pread_full(int fd, uint8_t* buf, uint64_t len, uint64_t off)
+{
+    uint64_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, buf + done, len - done, (off_t)(off + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -errno;
+        if (n == 0) {
+            std::memset(buf + done, 0, len - done);
+            break;
+        }
+        done += (uint64_t)n;
+    }
+    return 0;
+}
+
+static int pwrite_full(int fd, const uint8_t* buf, uint64_t len, uint64_t off)
+{
+    uint64_t done = 0;
+    while (done < len) {
+        ssize_t n = pwrite(fd, buf + done, len - done, (off_t)(off + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n < 0 ? -errno : -EIO;
+        done += (uint64_t)n;
+    }
+    return 0;
+}
+
+static bool file_size(int fd, uint64_t& size, int64_t& mtime)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return false;
+    off_t end = lseek(fd, 0, SEEK_END);   // also works for block devices
+    size  = end > 0 ? (uint64_t)end : (uint64_t)st.st_size;
+    mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+// Empty the table and drop every private cluster. Truncating to
+// the table start first turns the old table into a hole.
+static bool reset_overlay(int fd, const CowHeader& h)
+{
+    if (ftruncate(fd, (off_t)h.table_offset) != 0 ||
+        ftruncate(fd, (off_t)h.data_offset) != 0)
+        return false;
+    return fsync(fd) == 0;
+}
+
+// -----------------------------------------------------------
+// Metadata
+// -----------------------------------------------------------
+bool CowImage::is_overlay(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char magic[8];
+    bool yes = pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) &&
+               std::memcmp(magic, COW_MAGIC, sizeof(magic)) == 0;
+    ::close(fd);
+    return yes;
+}
+
+bool CowImage::read_metadata(int fd, CowHeader& h, std::vector<uint64_t>& tbl)
+{
+    if (pread_full(fd, (uint8_t*)&h, sizeof(h), 0) != 0 ||
+        std::memcmp(h.magic, COW_MAGIC, sizeof(h.magic)) != 0) {
+        Log::err() << "[COW] Not an overlay image\n";
+        return false;
+    }
+    if (h.version != VERSION || h.cluster_bits < 12 || h.cluster_bits > 24) {
+        Log::err() << "[COW] Unsupported overlay (version " << h.version
+                   << ", cluster bits " << h.cluster_bits << ")\n";
+        return false;
+    }
+
+    const uint64_t cs = 1ull << h.cluster_bits;
+    if (h.table_entries != (h.virtual_size + cs - 1) / cs ||
+        h.data_offset < h.table_offset + h.table_entries * sizeof(uint64_t)) {
+        Log::err() << "[COW] Corrupt overlay header\n";
+        return false;
+    }
+    h.base_path[sizeof(h.base_path) - 1] = 0;
+
+    tbl.resize(h.table_entries);
+    if (pread_full(fd, (uint8_t*)tbl.data(), h.table_entries * sizeof(uint64_t), h.table_offset) != 0) {
+        Log::err() << "[COW] Cannot read cluster table: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------
+// Open: header + table in, base opened read-only. No data is
+// read or copied, so this takes milliseconds for any disk size.
+// -----------------------------------------------------------
+CowImage* CowImage::open(const std::string& path, bool read_only)
+{
+    int fd = ::open(path.c_str(), read_only ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        Log::err() << "[COW] Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    CowImage* img = new CowImage();
+    img->cow_fd = fd;
+    img->ro     = read_only;
+    if (!read_metadata(fd, img->hdr, img->table)) {
+        delete img;
+        return nullptr;
+    }
+
+    const CowHeader& h = img->hdr;
+    img->base_fd = ::open(h.base_path, O_RDONLY);
+    if (img->base_fd < 0) {
+        Log::err() << "[COW] Cannot open base " << h.base_path << ": " << std::strerror(errno) << "\n";
+        delete img;
+        return nullptr;
+    }
+
+    uint64_t bsize = 0, osize = 0;
+    int64_t  bmtime = 0, omtime = 0;
+    if (!file_size(img->base_fd, bsize, bmtime) || !file_size(fd, osize, omtime)) {
+        Log::err() << "[COW] fstat: " << std::strerror(errno) << "\n";
+        delete img;
+        return nullptr;
+    }
+    if (bsize != h.base_size) {
+        Log::err() << "[COW] Base " << h.base_path << " is " << bsize << " bytes, overlay expects "
+                   << h.base_size << "; refusing to use it\n";
+        delete img;
+        return nullptr;
+    }
+    if (bmtime != h.base_mtime)
+        Log::err() << "[COW] Warning: base " << h.base_path << " modified since the overlay was created\n";
+
+    img->cluster_size = 1ull << h.cluster_bits;
+    img->alloc_end = std::max<uint64_t>(h.data_offset,
+                                        (osize + img->cluster_size - 1) & ~(img->cluster_size - 1));
+    img->page_dirty.assign((h.table_entries + PAGE_ENTRIES - 1) / PAGE_ENTRIES, 0);
+
+    uint64_t priv = 0;
+    for (uint64_t e : img->table)
+        priv += e != 0;
+
+    Log::out() << "[COW] " << path << ": overlay on " << h.base_path << ", "
+               << priv << " of " << h.table_entries << " clusters private"
+               << (read_only ? ", read-only" : "") << "\n";
+    return img;
+}
+
+CowImage::~CowImage()
+{
+    stop_workers();
+
+    if (cow_fd >= 0 && !ro) {
+        std::lock_guard<std::mutex> lk(alloc_mtx);
+        if (flush_metadata() != 0 || fdatasync(cow_fd) != 0)
+            Log::err() << "[COW] Flush on close failed: " << std::strerror(errno) << "\n";
+    }
+    if (cow_fd >= 0)
+        ::close(cow_fd);
+    if (base_fd >= 0)
+        ::close(base_fd);
+}
+
+// -----------------------------------------------------------
+// I/O (worker threads)
+// -----------------------------------------------------------
+uint64_t CowImage::lookup(uint64_t cluster)
+{
+    std::lock_guard<std::mutex> lk(meta_mtx);
+    return table[cluster];
+}
+
+void CowImage::execute(BlockRequest* r)
+{
+    switch (r->op)
+    {
+    case BlockRequest::Op::Read:
+        r->result = do_read(r->offset, r->length, r->buf);
+        return;
+
+    case BlockRequest::Op::Write:
+        r->result = do_write(r->offset, r->length, r->buf);
+        return;
+
+    case BlockRequest::Op::Flush:
+    {
+        std::lock_guard<std::mutex> lk(alloc_mtx);
+        int err = flush_metadata();
+        if (err == 0 && fdatasync(cow_fd) != 0)
+            err = -errno;
+        r->result = err;
+        return;
+    }
+    }
+}
+
+int64_t CowImage::do_read(uint64_t offset, uint32_t length, uint8_t* buf)
+{
+    if (offset > hdr.virtual_size || length > hdr.virtual_size - offset)
+        return -EINVAL;
+
+    const uint64_t end = offset + length;
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        const uint64_t first = pos >> hdr.cluster_bits;
+        const uint64_t src   = lookup(first);
+
+        // Extend over following clusters that continue the same
+        // file range: untouched clusters are contiguous in the
+        // base, copied ones are often contiguous in the overlay
+        uint64_t run_end = std::min(end, (first + 1) << hdr.cluster_bits);
+        while (run_end < end) {
+            const uint64_t c = run_end >> hdr.cluster_bits;
+            const uint64_t e = lookup(c);
+            if (src == 0 ? e != 0 : e != src + (c - first) * cluster_size)
+                break;
+            run_end = std::min(end, (c + 1) << hdr.cluster_bits);
+        }
+
+        const uint64_t in_off = pos & (cluster_size - 1);
+        int err = src == 0
+            ? pread_full(base_fd, buf + (pos - offset), run_end - pos, pos)
+            : pread_full(cow_fd,  buf + (pos - offset), run_end - pos, src + in_off);
+        if (err)
+            return err;
+        pos = run_end;
+    }
+    return length;
+}
+
+int64_t CowImage::do_write(uint64_t offset, uint32_t length, const uint8_t* buf)
+{
+    if (offset > hdr.virtual_size || length > hdr.virtual_size - offset)
+        return -EINVAL;
+
+    const uint64_t end = offset + length;
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        const uint64_t c      = pos >> hdr.cluster_bits;
+        const uint32_t in_off = (uint32_t)(pos & (cluster_size - 1));
+        const uint32_t n      = (uint32_t)std::min<uint64_t>(cluster_size - in_off, end - pos);
+        const uint8_t* src    = buf + (pos - offset);
+
+        const uint64_t dst = lookup(c);
+        int err = dst ? pwrite_full(cow_fd, src, n, dst + in_off)
+                      : (int)copy_up(c, in_off, n, src);
+        if (err)
+            return err;
+        pos += n;
+    }
+    return length;
+}
+
+// First write to a cluster: build the private copy (base data
+// merged with the new bytes) and append it to the overlay
+int64_t CowImage::copy_up(uint64_t cluster, uint32_t in_off, uint32_t len, const uint8_t* buf)
+{
+    std::lock_guard<std::mutex> lk(alloc_mtx);
+
+    // Another worker may have copied it while we waited
+    const uint64_t existing = lookup(cluster);
+    if (existing)
+        return pwrite_full(cow_fd, buf, len, existing + in_off);
+
+    std::vector<uint8_t> data(cluster_size);
+    if (len < cluster_size) {
+        const uint64_t base_off = cluster << hdr.cluster_bits;
+        const uint64_t avail = std::min<uint64_t>(cluster_size, hdr.base_size - base_off);
+        int err = pread_full(base_fd, data.data(), avail, base_off);
+        if (err)
+            return err;
+    }
+    std::memcpy(data.data() + in_off, buf, len);
+
+    const uint64_t dst = alloc_end;
+    int err = pwrite_full(cow_fd, data.data(), cluster_size, dst);
+    if (err)
+        return err;
+    alloc_end += cluster_size;
+
+    {
+        std::lock_guard<std::mutex> mlk(meta_mtx);
+        table[cluster] = dst;
+    }
+
+    const uint32_t page = (uint32_t)(cluster / PAGE_ENTRIES);
+    if (!page_dirty[page]) {
+        page_dirty[page] = 1;
+        dirty_pages.push_back(page);
+    }
+    if (++unflushed >= META_BATCH)
+        return flush_metadata();
+    return 0;
+}
+
+// -----------------------------------------------------------
+// flush_metadata() - write back changed table pages. The data
+// they point at is synced first, so a crash can lose recent
+// allocations but never expose a table entry to garbage.
+// -----------------------------------------------------------
+int CowImage::flush_metadata()
+{
+    if (dirty_pages.empty())
+        return 0;
+
+    if (fdatasync(cow_fd) != 0)
+        return -errno;
+
+    uint64_t page_buf[PAGE_ENTRIES];
+    for (uint32_t page : dirty_pages) {
+        const uint64_t first = (uint64_t)page * PAGE_ENTRIES;
+        const uint64_t count = std::min<uint64_t>(PAGE_ENTRIES, hdr.table_entries - first);
+        {
+            std::lock_guard<std::mutex> lk(meta_mtx);
+            std::memcpy(page_buf, &table[first], count * sizeof(uint64_t));
+        }
+        int err = pwrite_full(cow_fd, (const uint8_t*)page_buf, count * sizeof(uint64_t),
+                              hdr.table_offset + first * sizeof(uint64_t));
+        if (err)
+            return err;
+        page_dirty[page] = 0;
+    }
+    dirty_pages.clear();
+    unflushed = 0;
+    return 0;
+}
+
+// -----------------------------------------------------------
+// Offline operations
+// -----------------------------------------------------------
+bool CowImage::create(const std::string& overlay, const std::string& base, uint32_t cluster_bits)
+{
+    if (cluster_bits < 12 || cluster_bits > 24) {
+        Log::err() << "[COW] Cluster size must be 4 KB .. 16 MB\n";
+        return false;
+    }
+
+    char abs_base[PATH_MAX];
+    if (!realpath(base.c_str(), abs_base)) {
+        Log::err() << "[COW] Cannot resolve " << base << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    CowHeader h = {};
+    if (std::strlen(abs_base) >= sizeof(h.base_path)) {
+        Log::err() << "[COW] Base path too long\n";
+        return false;
+    }
+
+    int bfd = ::open(abs_base, O_RDONLY);
+    if (bfd < 0) {
+        Log::err() << "[COW] Cannot open " << abs_base << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    uint64_t bsize = 0;
+    int64_t  bmtime = 0;
+    bool ok = file_size(bfd, bsize, bmtime);
+    ::close(bfd);
+    if (!ok || bsize == 0) {
+        Log::err() << "[COW] Base image is empty or unreadable\n";
+        return false;
+    }
+
+    const uint64_t cs = 1ull << cluster_bits;
+    std::memcpy(h.magic, COW_MAGIC, sizeof(h.magic));
+    h.version       = VERSION;
+    h.cluster_bits  = cluster_bits;
+    h.virtual_size  = bsize;
+    h.base_size     = bsize;
+    h.base_mtime    = bmtime;
+    h.table_offset  = sizeof(CowHeader);
+    h.table_entries = (bsize + cs - 1) / cs;
+    h.data_offset   = (h.table_offset + h.table_entries * sizeof(uint64_t) + cs - 1) & ~(cs - 1);
+    std::strcpy(h.base_path, abs_base);
+
+    int fd = ::open(overlay.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        Log::err() << "[COW] Cannot create " << overlay << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // The table is left as a hole: all zeros, all clusters in the base
+    ok = pwrite_full(fd, (const uint8_t*)&h, sizeof(h), 0) == 0 &&
+         ftruncate(fd, (off_t)h.data_offset) == 0 &&
+         fsync(fd) == 0;
+    ::close(fd);
+    if (!ok) {
+        Log::err() << "[COW] Writing " << overlay << ": " << std::strerror(errno) << "\n";
+        unlink(overlay.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CowImage::commit(const std::string& overlay)
+{
+    int fd = ::open(overlay.c_str(), O_RDWR);
+    if (fd < 0) {
+        Log::err() << "[COW] Cannot open " << overlay << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    CowHeader h;
+    std::vector<uint64_t> tbl;
+    if (!read_metadata(fd, h, tbl)) {
+        ::close(fd);
+        return false;
+    }
+
+    int bfd = ::open(h.base_path, O_RDWR);
+    if (bfd < 0) {
+        Log::err() << "[COW] Cannot open base " << h.base_path << " for writing: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    const uint64_t cs = 1ull << h.cluster_bits;
+    std::vector<uint8_t> data(cs);
+    uint64_t copied = 0;
+    bool ok = true;
+
+    for (uint64_t c = 0; c < h.table_entries && ok; c++) {
+        if (!tbl[c])
+            continue;
+        const uint64_t off = c * cs;
+        const uint64_t len = std::min(cs, h.virtual_size - off);
+        ok = pread_full(fd, data.data(), len, tbl[c]) == 0 &&
+             pwrite_full(bfd, data.data(), len, off) == 0;
+        copied++;
+    }
+    ok = ok && fdatasync(bfd) == 0;
+
+    // The base now carries this overlay's data: empty the overlay
+    // and record the new base timestamp so it opens cleanly again
+    uint64_t bsize = 0;
+    int64_t  bmtime = 0;
+    if (ok && file_size(bfd, bsize, bmtime)) {
+        h.base_mtime = bmtime;
+        ok = pwrite_full(fd, (const uint8_t*)&h, sizeof(h), 0) == 0 && reset_overlay(fd, h);
+    }
+    ::close(bfd);
+    ::close(fd);
+
+    if (!ok) {
+        Log::err() << "[COW] Commit failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    Log::out() << "[COW] Committed " << copied << " clusters into " << h.base_path << "\n";
+    return true;
+}
+
+bool CowImage::discard(const std::string& overlay)
+{
+    int fd = ::open(overlay.c_str(), O_RDWR);
+    if (fd < 0) {
+        Log::err() << "[COW] Cannot open " << overlay << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    CowHeader h;
+    std::vector<uint64_t> tbl;
+    bool ok = read_metadata(fd, h, tbl) && reset_overlay(fd, h);
+    ::close(fd);
+    return ok;
+}
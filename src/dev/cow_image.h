@@ -0,0 +1,105 @@
+// -----------------------------------------------------------
+// cow_image.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Copy-on-write overlay on a shared, read-only base disk image
+//
+//   - The overlay file holds a header naming the base image, a
+//     cluster table (one uint64 per cluster: 0 = still in the
+//     base, else the overlay offset of its private copy) and
+//     the private clusters, appended as they are first written
+//   - The table is loaded whole at open, so starting an instance
+//     costs one small read, not a copy of the base
+//   - Reads of clusters nobody has written go straight to the
+//     base file, coalesced into one pread per contiguous run
+//   - Table updates are batched: changed table pages are written
+//     after the data they point at is synced, on SYNCHRONIZE
+//     CACHE, every META_BATCH allocations and at close
+//
+// Overlays are in host byte order. tools/cow_tool.cpp creates,
+// inspects, commits and discards them offline.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include "block_backend.h"
+
+struct CowHeader {
+    char     magic[8];          // "RACERCOW"
+    uint32_t version;
+    uint32_t cluster_bits;      // cluster size = 1 << cluster_bits
+    uint64_t virtual_size;      // guest-visible size (= base size)
+    uint64_t base_size;         // checked at open
+    int64_t  base_mtime;        // warned about at open
+    uint64_t table_offset;
+    uint64_t table_entries;
+    uint64_t data_offset;       // first cluster, cluster aligned
+    char     base_path[4032];   // absolute, NUL terminated
+};
+static_assert(sizeof(CowHeader) == 4096, "CowHeader must be one page");
+
+class CowImage : public ThreadPoolBackend {
+public:
+    static constexpr uint32_t VERSION         = 1;
+    static constexpr uint32_t DEFAULT_CLUSTER_BITS = 16;   // 64 KB
+
+    ~CowImage() override;
+
+    uint64_t    size() const override      { return hdr.virtual_size; }
+    bool        read_only() const override { return ro; }
+    const char* kind() const override      { return "cow overlay"; }
+
+    // Overlay file starts with the magic
+    static bool is_overlay(const std::string& path);
+
+    // Open overlay + base. nullptr (after printing why) on failure.
+    static CowImage* open(const std::string& path, bool read_only);
+
+    // ---- offline operations (the image must not be in use)
+    static bool create(const std::string& overlay, const std::string& base,
+                       uint32_t cluster_bits = DEFAULT_CLUSTER_BITS);
+    // Write every private cluster back into the base, then empty
+    // the overlay
+    static bool commit(const std::string& overlay);
+    // Drop every private cluster
+    static bool discard(const std::string& overlay);
+    // Header + table of an open overlay fd
+    static bool read_metadata(int fd, CowHeader& h, std::vector<uint64_t>& table);
+
+protected:
+    void execute(BlockRequest* r) override;
+
+private:
+    static constexpr uint32_t TABLE_PAGE  = 4096;         // write-back unit
+    static constexpr uint32_t PAGE_ENTRIES = TABLE_PAGE / sizeof(uint64_t);
+    static constexpr uint32_t META_BATCH  = 256;          // allocations per table flush
+
+    CowImage() {}
+
+    CowHeader hdr = {};
+    bool      ro = false;
+    int       base_fd = -1;
+    int       cow_fd  = -1;
+    uint64_t  cluster_size = 0;
+
+    // table is read by every worker; meta_mtx guards it and is
+    // only held for lookups and updates, never across I/O
+    std::vector<uint64_t> table;
+    std::mutex            meta_mtx;
+
+    // Allocation (copy-up) and table write-back are serialised
+    std::mutex            alloc_mtx;
+    uint64_t              alloc_end = 0;
+    std::vector<uint8_t>  page_dirty;
+    std::vector<uint32_t> dirty_pages;
+    uint32_t              unflushed = 0;             // allocations since last flush
+
+    uint64_t lookup(uint64_t cluster);
+    int64_t  do_read(uint64_t offset, uint32_t length, uint8_t* buf);
+    int64_t  do_write(uint64_t offset, uint32_t length, const uint8_t* buf);
+    int64_t  copy_up(uint64_t cluster, uint32_t in_off, uint32_t len, const uint8_t* buf);
+    int      flush_metadata();   // alloc_mtx held
+};
@@ -0,0 +1,100 @@
+// -----------------------------------------------------------
+// dirty_tiles.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Bitmap of changed framebuffer tiles, one 64-bit word per
+// row of tiles. Produced by Framebuffer::collect_dirty() and
+// consumed by display / capture paths.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct DirtyTiles {
+    uint32_t tile_w  = 0;   // tile size in pixels
+    uint32_t tile_h  = 0;
+    uint32_t tiles_x = 0;   // <= 64
+    uint32_t tiles_y = 0;
+    uint32_t width   = 0;   // framebuffer size in pixels
+    uint32_t height  = 0;
+
+    std::vector<uint64_t> rows;   // bit tx of rows[ty] = tile dirty
+
+    void resize(uint32_t w, uint32_t h, uint32_t tw, uint32_t th)
+    {
+        width   = w;
+        height  = h;
+        tile_w  = tw;
+        tile_h  = th;
+        tiles_x = (w + tw - 1) / tw;
+        tiles_y = (h + th - 1) / th;
+        rows.assign(tiles_y, 0);
+    }
+
+    void clear() { for (auto& r : rows) r = 0; }
+
+    void mark(uint32_t tx, uint32_t ty) { rows[ty] |= (1ULL << tx); }
+
+    void mark_all()
+    {
+        uint64_t full = (tiles_x >= 64) ? ~0ULL : ((1ULL << tiles_x) - 1);
+        for (auto& r : rows) r = full;
+    }
+
+    bool test(uint32_t tx, uint32_t ty) const { return (rows[ty] >> tx) & 1; }
+
+    bool any() const
+    {
+        for (auto r : rows)
+            if (r) return true;
+        return false;
+    }
+
+    void merge(const DirtyTiles& o)
+    {
+        for (size_t i = 0; i < rows.size() && i < o.rows.size(); i++)
+            rows[i] |= o.rows[i];
+    }
+
+    // Visit dirty areas as pixel rectangles (x, y, w, h).
+    // Horizontal runs of tiles are merged, and a run that repeats
+    // on consecutive tile rows is extended downwards, so a full
+    // redraw becomes a single rectangle.
+    template <typename Fn>
+    void for_each_rect(Fn&& fn) const
+    {
+        std::vector<uint64_t> left(rows);
+
+        for (uint32_t ty = 0; ty < tiles_y; ty++)
+        {
+            while (left[ty])
+            {
+                uint32_t x0 = (uint32_t)__builtin_ctzll(left[ty]);
+                uint32_t x1 = x0;
+                while (x1 + 1 < tiles_x && ((left[ty] >> (x1 + 1)) & 1))
+                    x1++;
+
+                uint64_t run = (x1 - x0 + 1 >= 64) ? ~0ULL
+                             : (((1ULL << (x1 - x0 + 1)) - 1) << x0);
+
+                uint32_t y1 = ty;
+                while (y1 + 1 < tiles_y && (left[y1 + 1] & run) == run)
+                    y1++;
+
+                for (uint32_t y = ty; y <= y1; y++)
+                    left[y] &= ~run;
+
+                uint32_t px = x0 * tile_w;
+                uint32_t py = ty * tile_h;
+                uint32_t pw = (x1 + 1) * tile_w;
+                uint32_t ph = (y1 + 1) * tile_h;
+                if (pw > width)  pw = width;
+                if (ph > height) ph = height;
+
+                fn(px, py, pw - px, ph - py);
+            }
+        }
+    }
+};
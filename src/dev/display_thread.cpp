@@ -0,0 +1,194 @@
+// -----------------------------------------------------------
+// display_thread.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Render thread + triple-buffered frame hand-off
+// -----------------------------------------------------------
+
+#include "display_thread.h"
+#include "sdl_display.h"
+#include "../log.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+DisplayThread::DisplayThread() {}
+
+DisplayThread::~DisplayThread()
+{
+    stop();
+}
+
+// -----------------------------------------------------------
+// start() - spawn render thread, wait until SDL is up
+// -----------------------------------------------------------
+bool DisplayThread::start(uint32_t w, uint32_t h)
+{
+    if (running.load())
+        return true;
+
+    init_done = false;
+    init_ok   = false;
+    quit.store(false);
+    running.store(true);
+
+    render_thread = std::thread(&DisplayThread::render_loop, this, w, h, Log::context());
+
+    std::unique_lock<std::mutex> lk(mtx);
+    cv.wait(lk, [this] { return init_done; });
+
+    if (!init_ok) {
+        lk.unlock();
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void DisplayThread::stop()
+{
+    if (running.exchange(false)) {
+        cv.notify_one();
+        render_thread.join();
+    }
+}
+
+// -----------------------------------------------------------
+// Producer side
+// -----------------------------------------------------------
+// Slots are sized on the first publish, before the consumer has
+// acquired anything. The framebuffer size is fixed once attached.
+void DisplayThread::prepare_slots(const Framebuffer& fb)
+{
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        FrameSnapshot& s = frames.slot(i);
+        if (s.width == fb.width() && s.height == fb.height())
+            continue;
+
+        s.width  = fb.width();
+        s.height = fb.height();
+        s.pitch  = fb.pitch();
+        s.pixels.assign((size_t)s.pitch * s.height, 0);
+        s.upload.resize(s.width, s.height, Framebuffer::TILE_W, Framebuffer::TILE_H);
+
+        // New slot contents are unrelated to the framebuffer
+        stale[i].resize(s.width, s.height, Framebuffer::TILE_W, Framebuffer::TILE_H);
+        stale[i].mark_all();
+    }
+
+    if (pending.tiles_y == 0)
+        pending.resize(fb.width(), fb.height(), Framebuffer::TILE_W, Framebuffer::TILE_H);
+}
+
+void DisplayThread::copy_tiles(const Framebuffer& fb, FrameSnapshot& dst, const DirtyTiles& tiles)
+{
+    const uint8_t* src = fb.data();
+    const uint32_t pitch = fb.pitch();
+
+    tiles.for_each_rect([&](uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+        size_t off = (size_t)y * pitch + (size_t)x * 4;
+        size_t len = (size_t)w * 4;
+
+        if (len == pitch) {
+            std::memcpy(&dst.pixels[off], src + off, (size_t)h * pitch);
+            return;
+        }
+        for (uint32_t row = 0; row < h; row++, off += pitch)
+            std::memcpy(&dst.pixels[off], src + off, len);
+    });
+}
+
+// -----------------------------------------------------------
+// publish() - called at guest VBLANK on the emulator thread
+// -----------------------------------------------------------
+// Cost is proportional to what changed: an idle screen costs a
+// single compare. The slot being filled may be up to two frames
+// old, so it gets its own stale tiles refreshed as well.
+// -----------------------------------------------------------
+void DisplayThread::publish(Framebuffer& fb)
+{
+    if (!running.load(std::memory_order_relaxed))
+        return;
+
+    // A cursor move alone publishes a frame with no tiles to upload
+    if (!fb.has_changes(cursor) && fb.cursor_serial() == cursor_seen)
+        return;
+
+    prepare_slots(fb);
+    fb.collect_dirty(cursor, changed);
+
+    const uint32_t b = frames.back_index();
+    FrameSnapshot& s = frames.back();
+
+    for (uint32_t i = 0; i < 3; i++)
+        stale[i].merge(changed);
+
+    copy_tiles(fb, s, stale[b]);
+    stale[b].clear();
+
+    // Everything the consumer might not have uploaded yet
+    pending.merge(changed);
+    s.upload.clear();
+    s.upload.merge(pending);
+
+    s.cursor.copy_from(fb.hw_cursor());
+    cursor_seen = fb.cursor_serial();
+
+    s.format   = fb.format();
+    s.sequence = ++sequence;
+
+    // If the previous frame was consumed, the consumer is at
+    // least that current, so only this frame's changes remain
+    // outstanding. If it was dropped, keep accumulating.
+    if (!frames.publish()) {
+        pending.clear();
+        pending.merge(changed);
+    }
+
+    cv.notify_one();
+}
+
+// -----------------------------------------------------------
+// Render thread
+// -----------------------------------------------------------
+void DisplayThread::render_loop(uint32_t w, uint32_t h, const char* log_name)
+{
+    Log::Context log_ctx(log_name);
+
+    // SDL window/renderer must live on the thread that uses them
+    SDLDisplay display;
+    bool ok = display.init(w, h);
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        init_done = true;
+        init_ok   = ok;
+    }
+    cv.notify_all();
+
+    if (!ok)
+        return;
+
+    while (running.load())
+    {
+        bool q = false;
+        display.process_events(q);
+        if (q)
+            quit.store(true);
+
+        bool shown = false;
+        if (frames.acquire())
+            shown = display.present(frames.front());
+        else
+            shown = display.refresh();
+
+        if (shown)
+            presented.fetch_add(1, std::memory_order_relaxed);
+
+        // Sleep until the next VBLANK (or a few ms for window events)
+        std::unique_lock<std::mutex> lk(mtx);
+        cv.wait_for(lk, std::chrono::milliseconds(4),
+                    [this] { return frames.pending() || !running.load(); });
+    }
+}
@@ -0,0 +1,71 @@
+// -----------------------------------------------------------
+// display_thread.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Presents the framebuffer on its own thread.
+//
+//   - The emulator calls publish() at guest VBLANK; it copies
+//     the tiles changed since the last VBLANK into a triple
+//     buffer slot and returns. It never waits for the host.
+//   - The render thread owns the SDL window, uploads and
+//     presents the newest frame, and handles window events.
+//     vsync, window size and compositor latency only affect
+//     this thread.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "framebuffer.h"
+#include "frame_snapshot.h"
+#include "triple_buffer.h"
+
+class DisplayThread {
+public:
+    DisplayThread();
+    ~DisplayThread();
+
+    // Start the render thread and open the window.
+    // Returns false if the display could not be initialized.
+    bool start(uint32_t w, uint32_t h);
+    void stop();
+
+    // Emulator thread, at guest VBLANK
+    void publish(Framebuffer& fb);
+
+    // User closed the window / pressed ESC
+    bool quit_requested() const { return quit.load(std::memory_order_relaxed); }
+
+    uint64_t frames_published() const { return sequence; }
+    uint64_t frames_presented() const { return presented.load(std::memory_order_relaxed); }
+
+private:
+    // ---- Producer (emulator thread) state
+    TripleBuffer<FrameSnapshot> frames;
+    DirtyTiles               stale[3];   // per slot: tiles older than fb
+    DirtyTiles               changed;    // this VBLANK's changes
+    DirtyTiles               pending;    // changes the consumer may not have seen
+    Framebuffer::DirtyCursor cursor;
+    uint64_t                 sequence = 0;
+    uint64_t                 cursor_seen = 0;   // Framebuffer::cursor_serial()
+
+    void prepare_slots(const Framebuffer& fb);
+    void copy_tiles(const Framebuffer& fb, FrameSnapshot& dst, const DirtyTiles& tiles);
+
+    // ---- Render thread
+    std::thread             render_thread;
+    std::atomic<bool>       running{false};
+    std::atomic<bool>       quit{false};
+    std::atomic<uint64_t>   presented{0};
+    std::mutex              mtx;
+    std::condition_variable cv;
+
+    // start() handshake
+    bool init_done = false;
+    bool init_ok   = false;
+
+    void render_loop(uint32_t w, uint32_t h, const char* log_name);
+};
@@ -0,0 +1,378 @@
+// -----------------------------------------------------------
+// ethernet.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Descriptor-ring Ethernet controller
+// -----------------------------------------------------------
+
+#include "ethernet.h"
+#include "../scheduler.h"
+#include "../dma.h"
+#include "../log.h"
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+
+static std::atomic<uint32_t> instances{0};
+
+Ethernet::Ethernet()
+{
+    // SGI OUI; the rest differs per process and per machine in the
+    // process (64 before the low bits wrap) so local instances on
+    // one link do not clash. The guest may override.
+    const uint32_t n  = instances.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t id = ((uint32_t)getpid() << 6) + n;
+    const uint8_t m[6] = { 0x08, 0x00, 0x69, (uint8_t)(id >> 16), (uint8_t)(id >> 8), (uint8_t)id };
+    std::copy(m, m + 6, mac);
+
+    frame.resize(NetBackend::MAX_FRAME);
+}
+
+Ethernet::~Ethernet()
+{
+    if (sched) {
+        if (tx_event)  sched->cancel(tx_event);
+        if (rx_event)  sched->cancel(rx_event);
+        if (irq_event) sched->cancel(irq_event);
+    }
+    delete backend;
+}
+
+void Ethernet::attach_backend(NetBackend* b)
+{
+    delete backend;
+    backend = b;
+    if (b)
+        Log::out() << "[NET] Ethernet backend: " << b->kind() << "\n";
+    schedule_rx();
+}
+
+uint64_t Ethernet::now() const
+{
+    return sched ? sched->now() : 0;
+}
+
+void Ethernet::update_irq()
+{
+    bool level = (status & (ST_RX_INT | ST_TX_INT | ST_DMA_ERR)) && (ctrl & CTRL_IRQ_EN);
+    if (level == irq_asserted)
+        return;
+
+    irq_asserted = level;
+    if (irq_cb)
+        irq_cb(level);
+}
+
+void Ethernet::reset()
+{
+    if (sched) {
+        if (tx_event)  sched->cancel(tx_event);
+        if (rx_event)  sched->cancel(rx_event);
+        if (irq_event) sched->cancel(irq_event);
+    }
+    tx_event = rx_event = irq_event = 0;
+    tx_batch = 0;
+    pending = pending_bits = 0;
+
+    ctrl   = 0;
+    status = 0;
+    tx = Ring();
+    rx = Ring();
+    rx_stalled = false;
+    rx_frames = tx_frames = rx_drops = 0;
+    update_irq();
+}
+
+// -----------------------------------------------------------
+// Guest register access
+// -----------------------------------------------------------
+uint32_t Ethernet::read_reg(uint32_t offset)
+{
+    switch (offset)
+    {
+    case REG_CTRL:       return ctrl;
+    case REG_STATUS:     return status | (backend ? ST_LINK : 0);
+    case REG_MAC_HI:     return ((uint32_t)mac[0] << 8) | mac[1];
+    case REG_MAC_LO:     return ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) |
+                                ((uint32_t)mac[4] << 8) | mac[5];
+    case REG_TX_RING:    return (uint32_t)tx.base;
+    case REG_TX_RING_HI: return (uint32_t)(tx.base >> 32);
+    case REG_TX_SIZE:    return tx.size;
+    case REG_TX_HEAD:    return tx.head;
+    case REG_TX_TAIL:    return tx.tail;
+    case REG_RX_RING:    return (uint32_t)rx.base;
+    case REG_RX_RING_HI: return (uint32_t)(rx.base >> 32);
+    case REG_RX_SIZE:    return rx.size;
+    case REG_RX_HEAD:    return rx.head;
+    case REG_RX_TAIL:    return rx.tail;
+    case REG_COALESCE:   return coalesce;
+    case REG_RX_FRAMES:  return rx_frames;
+    case REG_TX_FRAMES:  return tx_frames;
+    case REG_RX_DROPS:   return rx_drops;
+    }
+    return 0;
+}
+
+void Ethernet::write_reg(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_CTRL:
+        if (value & CTRL_RESET) {
+            reset();
+            return;
+        }
+        ctrl = value;
+        update_irq();
+        kick_tx();
+        schedule_rx();
+        return;
+
+    case REG_STATUS:
+        status &= ~(value & (ST_RX_INT | ST_TX_INT | ST_DMA_ERR));
+        update_irq();
+        return;
+
+    case REG_MAC_HI:
+        mac[0] = (uint8_t)(value >> 8);
+        mac[1] = (uint8_t)value;
+        return;
+
+    case REG_MAC_LO:
+        mac[2] = (uint8_t)(value >> 24);
+        mac[3] = (uint8_t)(value >> 16);
+        mac[4] = (uint8_t)(value >> 8);
+        mac[5] = (uint8_t)value;
+        return;
+
+    // Ring geometry may only change while the ring is idle
+    case REG_TX_RING:    if (!tx_event) tx.base = (tx.base & ~0xFFFFFFFFULL) | value; return;
+    case REG_TX_RING_HI: if (!tx_event) tx.base = (tx.base & 0xFFFFFFFFULL) | ((uint64_t)value << 32); return;
+    case REG_TX_SIZE:    if (!tx_event) { tx.size = value; tx.head = tx.tail = 0; } return;
+    case REG_RX_RING:    rx.base = (rx.base & ~0xFFFFFFFFULL) | value; rx_reprogrammed(); return;
+    case REG_RX_RING_HI: rx.base = (rx.base & 0xFFFFFFFFULL) | ((uint64_t)value << 32); rx_reprogrammed(); return;
+    case REG_RX_SIZE:    rx.size = value; rx.head = rx.tail = 0; rx_reprogrammed(); return;
+
+    case REG_TX_TAIL:
+        if (tx.valid()) {
+            tx.tail = value & (tx.size - 1);
+            kick_tx();
+        }
+        return;
+
+    case REG_RX_TAIL:
+        if (rx.valid())
+            rx.tail = value & (rx.size - 1);
+        return;
+
+    case REG_COALESCE:
+        coalesce = value;
+        return;
+    }
+}
+
+// -----------------------------------------------------------
+// fetch() - descriptors [first, first + count) of a ring into
+// descs, one DMA per contiguous run (two if the ring wraps)
+// -----------------------------------------------------------
+bool Ethernet::fetch(const Ring& r, uint32_t first, uint32_t count)
+{
+    descs.resize((size_t)count * 4);
+
+    const uint32_t run = std::min(count, r.size - first);
+    bool ok = dma->read_be32(r.desc(first), descs.data(), (size_t)run * 4);
+    if (ok && run < count)
+        ok = dma->read_be32(r.desc(0), descs.data() + (size_t)run * 4, (size_t)(count - run) * 4);
+
+    if (!ok) {
+        RLOG_FIRST(DEV, Warn, 8, "Ethernet descriptor ring outside RAM @ 0x%llx", r.base);
+        status |= ST_DMA_ERR;
+        update_irq();
+    }
+    return ok;
+}
+
+// -----------------------------------------------------------
+// Transmit: a doorbell sends everything queued at that moment
+// as one batch. Completion (status write-back, TX_HEAD) comes
+// when the last frame would have left the wire.
+// -----------------------------------------------------------
+void Ethernet::kick_tx()
+{
+    if (!(ctrl & CTRL_TX_EN) || tx_event || !dma || !tx.valid() || tx.queued() == 0)
+        return;
+    start_tx();
+}
+
+void Ethernet::start_tx()
+{
+    const uint32_t n = tx.queued();
+    if (!fetch(tx, tx.head, n))
+        return;
+
+    tx_status.resize(n);
+    uint64_t bytes = 0;
+    uint32_t i = 0;
+    for (; i < n; i++) {
+        const uint32_t* d = &descs[(size_t)i * 4];
+        const uint64_t addr = ((uint64_t)d[0] << 32) | d[1];
+        const uint32_t len  = d[2] & 0xFFFF;
+
+        if (len == 0 || len > NetBackend::MAX_FRAME || !dma->read(addr, frame.data(), len)) {
+            tx_status[i] = DESC_DONE | DESC_ERROR;
+            continue;
+        }
+        // No backend: the cable is unplugged and the frame is lost.
+        // Host full: stop here, the rest goes out on a later try.
+        if (backend && !backend->send(frame.data(), len))
+            break;
+        tx_status[i] = DESC_DONE | len;
+        bytes += len;
+    }
+
+    if (i == 0) {
+        if (sched) {
+            tx_event = sched->schedule(TX_RETRY_CYCLES, [this]() {
+                tx_event = 0;
+                kick_tx();
+            });
+        }
+        return;
+    }
+
+    tx_batch = i;
+    tx_bytes += bytes;
+    const uint64_t cost = TX_SETUP_CYCLES + bytes * CYCLES_PER_BYTE;
+    tx_free_at = std::max(now(), tx_free_at) + cost;
+
+    if (!sched) {
+        finish_tx();
+        return;
+    }
+    tx_event = sched->schedule_at(tx_free_at, [this]() {
+        tx_event = 0;
+        finish_tx();
+    });
+}
+
+void Ethernet::finish_tx()
+{
+    uint32_t sent = 0;
+    for (uint32_t i = 0; i < tx_batch; i++) {
+        const uint32_t st = tx_status[i];
+        dma->write_be32(tx.desc((tx.head + i) & (tx.size - 1)) + 12, &st, 1);
+        if (!(st & DESC_ERROR))
+            sent++;
+    }
+
+    tx.head = (tx.head + tx_batch) & (tx.size - 1);
+    tx_frames += sent;
+    completed(ST_TX_INT, tx_batch);
+    tx_batch = 0;
+
+    kick_tx();
+}
+
+// -----------------------------------------------------------
+// Receive: polled on the emulator timeline. Each poll fills as
+// many posted buffers as the backend has frames; frames that
+// find the ring full wait in the host (socket buffer, file).
+// -----------------------------------------------------------
+void Ethernet::schedule_rx()
+{
+    if (rx_event || rx_stalled || !sched || !backend || !(ctrl & CTRL_RX_EN))
+        return;
+
+    rx_event = sched->schedule(RX_POLL_CYCLES, [this]() {
+        rx_event = 0;
+        poll_rx();
+    });
+}
+
+void Ethernet::poll_rx()
+{
+    if (!backend || !dma || !(ctrl & CTRL_RX_EN))
+        return;
+
+    const uint32_t n = rx.valid() ? rx.queued() : 0;
+    if (n && !fetch(rx, rx.head, n)) {
+        rx_stalled = true;      // until the guest moves the ring
+        return;
+    }
+    if (n) {
+        uint32_t filled = 0;
+        while (filled < n) {
+            const size_t len = backend->recv(frame.data(), frame.size());
+            if (len == 0)
+                break;
+
+            const uint32_t* d = &descs[(size_t)filled * 4];
+            const uint64_t addr = ((uint64_t)d[0] << 32) | d[1];
+            const uint32_t cap  = d[2] & 0xFFFF;
+            if (len > cap) {
+                rx_drops++;           // buffer too small; keep the descriptor
+                continue;
+            }
+
+            const bool ok = dma->write(addr, frame.data(), len);
+            const uint32_t st = ok ? DESC_DONE | (uint32_t)len : DESC_DONE | DESC_ERROR;
+            if (ok)
+                rx_bytes += len;
+            dma->write_be32(rx.desc((rx.head + filled) & (rx.size - 1)) + 12, &st, 1);
+            filled++;
+        }
+
+        rx.head = (rx.head + filled) & (rx.size - 1);
+        rx_frames += filled;
+        completed(ST_RX_INT, filled);
+    }
+
+    schedule_rx();
+}
+
+// New ring geometry: a ring that faulted may be usable again
+void Ethernet::rx_reprogrammed()
+{
+    rx_stalled = false;
+    schedule_rx();
+}
+
+// -----------------------------------------------------------
+// Interrupt coalescing
+// -----------------------------------------------------------
+void Ethernet::completed(uint32_t bit, uint32_t n)
+{
+    if (n == 0)
+        return;
+
+    pending += n;
+    pending_bits |= bit;
+
+    const uint32_t frames = coalesce & 0xFFFF;
+    if (frames <= 1 || pending >= frames || !sched) {
+        raise();
+        return;
+    }
+
+    if (!irq_event) {
+        uint64_t us = coalesce >> 16;
+        if (!us)
+            us = DEFAULT_COALESCE_US;
+        irq_event = sched->schedule(us * CYCLES_PER_US, [this]() {
+            irq_event = 0;
+            raise();
+        });
+    }
+}
+
+void Ethernet::raise()
+{
+    if (irq_event && sched) {
+        sched->cancel(irq_event);
+        irq_event = 0;
+    }
+    status |= pending_bits;
+    pending = 0;
+    pending_bits = 0;
+    update_irq();
+}
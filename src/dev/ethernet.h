@@ -0,0 +1,160 @@
+// -----------------------------------------------------------
+// ethernet.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// MACE Ethernet controller with descriptor rings
+//
+//   - Transmit and receive rings live in guest RAM; the guest
+//     produces (TX_TAIL / RX_TAIL doorbells), the controller
+//     consumes and advances TX_HEAD / RX_HEAD
+//   - One doorbell sends every descriptor queued so far: the
+//     descriptors are fetched in one DMA per contiguous run,
+//     frames go to the host backend back to back. If the host
+//     side is full the batch stops there and is retried.
+//   - Receive is polled from the emulator timeline and fills as
+//     many posted buffers as frames are waiting
+//   - Interrupts are coalesced: raised after COALESCE frames or
+//     COALESCE microseconds after the first unreported one
+//
+// Descriptor (16 bytes, big-endian words):
+//   0  buffer address, high      2  TX: frame length / RX: buffer size
+//   1  buffer address, low       3  status, written by the controller:
+//                                   DESC_DONE | DESC_ERROR | length
+//
+// Register block lives at MACE + 0x70000 (see emulator.cpp).
+// Like the SCSI controller this is an emulator-defined interface,
+// not a model of the MACE MAC110.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "net_backend.h"
+
+class Scheduler;
+class DmaEngine;
+
+class Ethernet {
+public:
+    // Register offsets (relative to the controller block)
+    static constexpr uint32_t REG_CTRL      = 0x00;
+    static constexpr uint32_t REG_STATUS    = 0x04;  // R: status, W: ack bits
+    static constexpr uint32_t REG_MAC_HI    = 0x08;  // bytes 0..1 in bits 15..0
+    static constexpr uint32_t REG_MAC_LO    = 0x0C;  // bytes 2..5
+    static constexpr uint32_t REG_TX_RING   = 0x10;  // guest physical, low
+    static constexpr uint32_t REG_TX_RING_HI = 0x14;
+    static constexpr uint32_t REG_TX_SIZE   = 0x18;  // entries, power of two
+    static constexpr uint32_t REG_TX_HEAD   = 0x1C;  // R: next descriptor to send
+    static constexpr uint32_t REG_TX_TAIL   = 0x20;  // W: doorbell, first unqueued descriptor
+    static constexpr uint32_t REG_RX_RING   = 0x24;
+    static constexpr uint32_t REG_RX_RING_HI = 0x28;
+    static constexpr uint32_t REG_RX_SIZE   = 0x2C;
+    static constexpr uint32_t REG_RX_HEAD   = 0x30;  // R: next descriptor to fill
+    static constexpr uint32_t REG_RX_TAIL   = 0x34;  // W: first descriptor not posted
+    static constexpr uint32_t REG_COALESCE  = 0x38;  // frames in 15..0, microseconds in 31..16
+    static constexpr uint32_t REG_RX_FRAMES = 0x40;  // R: counters
+    static constexpr uint32_t REG_TX_FRAMES = 0x44;
+    static constexpr uint32_t REG_RX_DROPS  = 0x48;
+    static constexpr uint32_t REG_BLOCK     = 0x100;
+
+    // REG_CTRL bits
+    static constexpr uint32_t CTRL_RX_EN  = 1u << 0;
+    static constexpr uint32_t CTRL_TX_EN  = 1u << 1;
+    static constexpr uint32_t CTRL_IRQ_EN = 1u << 2;
+    static constexpr uint32_t CTRL_RESET  = 1u << 31;  // self clearing
+
+    // REG_STATUS bits
+    static constexpr uint32_t ST_RX_INT   = 1u << 0;   // sticky, write 1 to clear
+    static constexpr uint32_t ST_TX_INT   = 1u << 1;   // sticky, write 1 to clear
+    static constexpr uint32_t ST_DMA_ERR  = 1u << 2;   // sticky, write 1 to clear
+    static constexpr uint32_t ST_LINK     = 1u << 8;
+
+    // Descriptor status word
+    static constexpr uint32_t DESC_DONE   = 1u << 31;
+    static constexpr uint32_t DESC_ERROR  = 1u << 30;
+    static constexpr uint32_t DESC_SIZE   = 16;
+    static constexpr uint32_t MAX_RING    = 4096;
+
+    Ethernet();
+    ~Ethernet();
+
+    void attach_scheduler(Scheduler* s) { sched = s; }
+    void attach_dma(DmaEngine* d) { dma = d; }
+    void set_irq_callback(std::function<void(bool)> cb) { irq_cb = std::move(cb); }
+
+    // Takes ownership; nullptr = cable unplugged
+    void attach_backend(NetBackend* b);
+
+    // Guest MMIO access (CPU thread only)
+    uint32_t read_reg(uint32_t offset);
+    void     write_reg(uint32_t offset, uint32_t value);
+
+    // Frame bytes to / from the host since power-on (the guest
+    // visible frame counters reset with the controller)
+    uint64_t bytes_sent() const     { return tx_bytes; }
+    uint64_t bytes_received() const { return rx_bytes; }
+
+private:
+    struct Ring {
+        uint64_t base = 0;
+        uint32_t size = 0;
+        uint32_t head = 0;
+        uint32_t tail = 0;
+
+        bool     valid() const { return size && !(size & (size - 1)) && size <= MAX_RING; }
+        uint32_t queued() const { return (tail - head) & (size - 1); }
+        uint64_t desc(uint32_t i) const { return base + (uint64_t)i * DESC_SIZE; }
+    };
+
+    NetBackend* backend = nullptr;
+    Scheduler*  sched   = nullptr;
+    DmaEngine*  dma     = nullptr;
+    std::function<void(bool)> irq_cb;
+
+    // ---- registers
+    uint32_t ctrl     = 0;
+    uint32_t status   = 0;
+    uint8_t  mac[6]   = {};
+    uint32_t coalesce = 0;
+    Ring     tx, rx;
+    uint32_t rx_frames = 0, tx_frames = 0, rx_drops = 0;
+    uint64_t rx_bytes = 0, tx_bytes = 0;
+    bool     irq_asserted = false;
+
+    // ---- timing
+    uint64_t tx_event   = 0;        // batch on the wire (completes at tx_free_at) or retry
+    uint64_t tx_free_at = 0;
+    uint32_t tx_batch   = 0;        // descriptors in that batch
+    uint64_t rx_event   = 0;        // next receive poll
+    bool     rx_stalled = false;    // ring faulted (ST_DMA_ERR), not polled
+    uint64_t irq_event  = 0;        // coalescing timer
+    uint32_t pending     = 0;       // completions not yet interrupted
+    uint32_t pending_bits = 0;
+
+    std::vector<uint32_t> descs;    // fetched descriptor words
+    std::vector<uint32_t> tx_status; // per descriptor of the batch on the wire
+    std::vector<uint8_t>  frame;    // bounce buffer for one frame
+
+    // Timing model (CPU cycles at 195 MHz)
+    static constexpr uint64_t TX_SETUP_CYCLES = 2000;    // doorbell to first bit
+    static constexpr uint64_t TX_RETRY_CYCLES = 3900;    // host full: try again in 20 us
+    static constexpr uint64_t CYCLES_PER_BYTE = 2;       // ~100 MB/s wire
+    static constexpr uint64_t RX_POLL_CYCLES  = 19500;   // look for frames every 100 us
+    static constexpr uint64_t CYCLES_PER_US   = 195;
+    static constexpr uint32_t DEFAULT_COALESCE_US = 50;  // timer when COALESCE gives none
+
+    uint64_t now() const;
+    void     reset();
+    bool     fetch(const Ring& r, uint32_t first, uint32_t count);
+    void     kick_tx();
+    void     start_tx();
+    void     finish_tx();
+    void     schedule_rx();
+    void     poll_rx();
+    void     rx_reprogrammed();
+    void     completed(uint32_t bit, uint32_t n);
+    void     raise();
+    void     update_irq();
+};
@@ -0,0 +1,120 @@
+// -----------------------------------------------------------
+// fb_shm.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Shared-memory framebuffer export (writer side)
+// -----------------------------------------------------------
+
+#include "fb_shm.h"
+#include "../log.h"
+#include <new>
+#include <unistd.h>
+
+static size_t page_align(size_t n)
+{
+    const size_t pg = (size_t)sysconf(_SC_PAGESIZE);
+    return (n + pg - 1) & ~(pg - 1);
+}
+
+FramebufferExport::FramebufferExport() {}
+
+FramebufferExport::~FramebufferExport()
+{
+    close();
+}
+
+// -----------------------------------------------------------
+// open() - create segment, move framebuffer pixels into it
+// -----------------------------------------------------------
+bool FramebufferExport::open(const std::string& name, Framebuffer& fb)
+{
+    close();
+
+    const uint32_t tiles_x = (fb.width()  + Framebuffer::TILE_W - 1) / Framebuffer::TILE_W;
+    const uint32_t tiles_y = (fb.height() + Framebuffer::TILE_H - 1) / Framebuffer::TILE_H;
+    if (tiles_x > 64 || tiles_y > FB_SHM_MAX_TILE_ROWS) {
+        Log::err() << "[FBSHM] Framebuffer too large to export\n";
+        return false;
+    }
+
+    const size_t tile_seq_off = 4096;
+    const size_t pixel_off    = page_align(tile_seq_off + (size_t)tiles_x * tiles_y * 4);
+    const size_t total        = page_align(pixel_off + fb.size());
+
+    if (!seg.create(name, total, "FBSHM"))
+        return false;
+    base = (uint8_t*)seg.data();
+
+    hdr = new (base) FbShmHeader();
+    hdr->magic           = FB_SHM_MAGIC;
+    hdr->version         = FB_SHM_VERSION;
+    hdr->width           = fb.width();
+    hdr->height          = fb.height();
+    hdr->pitch           = fb.pitch();
+    hdr->format          = (uint32_t)fb.format();
+    hdr->tile_w          = Framebuffer::TILE_W;
+    hdr->tile_h          = Framebuffer::TILE_H;
+    hdr->tiles_x         = tiles_x;
+    hdr->tiles_y         = tiles_y;
+    hdr->tile_seq_offset = (uint32_t)tile_seq_off;
+    hdr->pixel_offset    = (uint32_t)pixel_off;
+    hdr->segment_size    = total;
+    hdr->writer_pid      = (uint32_t)getpid();
+    hdr->frame           = 0;
+    hdr->sequence.store(0, std::memory_order_release);
+
+    tile_seq = (uint32_t*)(base + tile_seq_off);
+
+    // From now on every guest pixel store lands in the segment
+    fb.use_external_storage(base + pixel_off);
+    owner = &fb;
+
+    Log::out() << "[FBSHM] Framebuffer exported as " << name
+               << " (" << total / 1024 << " KB)\n";
+    return true;
+}
+
+void FramebufferExport::close()
+{
+    if (owner) {
+        owner->use_external_storage(nullptr);   // copy back to private memory
+        owner = nullptr;
+    }
+
+    seg.close();
+    base = nullptr;
+    hdr  = nullptr;
+    tile_seq = nullptr;
+}
+
+// -----------------------------------------------------------
+// publish() - update frame metadata at VBLANK
+// Pixels are already in place; only header + tile stamps change.
+// -----------------------------------------------------------
+void FramebufferExport::publish(Framebuffer& fb, uint64_t frame)
+{
+    if (!hdr || !fb.has_changes(cursor))
+        return;
+
+    fb.collect_dirty(cursor, changed);
+
+    uint64_t seq = hdr->sequence.load(std::memory_order_relaxed);
+    hdr->sequence.store(seq + 1, std::memory_order_relaxed);     // odd: updating
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint32_t ty = 0; ty < changed.tiles_y; ty++) {
+        uint64_t bits = changed.rows[ty];
+        hdr->dirty[ty] = bits;
+
+        while (bits) {
+            uint32_t tx = (uint32_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+            tile_seq[ty * changed.tiles_x + tx] = (uint32_t)frame;
+        }
+    }
+
+    hdr->format = (uint32_t)fb.format();
+    hdr->frame  = frame;
+
+    hdr->sequence.store(seq + 2, std::memory_order_release);      // even: stable
+}
@@ -0,0 +1,86 @@
+// -----------------------------------------------------------
+// fb_shm.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Framebuffer export through POSIX shared memory
+//
+// The segment holds a small header followed by the live pixel
+// storage of the emulated framebuffer: Framebuffer writes go
+// straight into it, so exporting costs no copies. External
+// viewers / recorders map it read-only.
+//
+// Segment layout:
+//   [FbShmHeader]               fixed, 4 KB
+//   [uint32_t tile_seq[tiles]]  frame number each tile last changed
+//   [pixels]                    page aligned, 'pitch' bytes per line
+//
+// Consistency: 'sequence' is a seqlock. The emulator makes it odd
+// while updating header fields at VBLANK and even when done. Pixels
+// are live (not double-buffered), so a reader may see a frame that
+// is being drawn; it never sees torn metadata.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
+#include "framebuffer.h"
+#include "../shm_segment.h"
+
+static constexpr uint32_t FB_SHM_MAGIC   = 0x52464231;   // "RFB1"
+static constexpr uint32_t FB_SHM_VERSION = 1;
+static constexpr uint32_t FB_SHM_MAX_TILE_ROWS = 256;
+
+struct FbShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;             // bytes per scanline
+    uint32_t format;            // GuestPixelFormat
+    uint32_t tile_w;
+    uint32_t tile_h;
+    uint32_t tiles_x;           // <= 64
+    uint32_t tiles_y;           // <= FB_SHM_MAX_TILE_ROWS
+    uint32_t tile_seq_offset;   // from segment start
+    uint32_t pixel_offset;      // from segment start
+    uint64_t segment_size;
+    uint32_t writer_pid;
+    uint32_t reserved0;
+
+    std::atomic<uint64_t> sequence;   // seqlock, frame number * 2
+    uint64_t frame;                   // guest VBLANK count of last publish
+
+    // Tiles changed between the previous published frame and this one.
+    // Readers that skipped frames use tile_seq[] instead.
+    uint64_t dirty[FB_SHM_MAX_TILE_ROWS];
+};
+
+static_assert(sizeof(FbShmHeader) <= 4096, "FbShmHeader must fit in one page");
+
+class FramebufferExport {
+public:
+    FramebufferExport();
+    ~FramebufferExport();
+
+    // Create /dev/shm/<name> sized for fb and move fb's pixel
+    // storage into it. name must start with '/'.
+    bool open(const std::string& name, Framebuffer& fb);
+    void close();
+
+    // Emulator thread, at guest VBLANK
+    void publish(Framebuffer& fb, uint64_t frame);
+
+    const std::string& name() const { return seg.name(); }
+
+private:
+    ShmSegment   seg;
+    uint8_t*     base = nullptr;
+    FbShmHeader* hdr  = nullptr;
+    uint32_t*    tile_seq = nullptr;
+    Framebuffer* owner = nullptr;
+
+    Framebuffer::DirtyCursor cursor;
+    DirtyTiles               changed;
+};
@@ -0,0 +1,30 @@
+// -----------------------------------------------------------
+// frame_snapshot.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// One published frame as handed from the emulator thread to a
+// display backend (see display_thread.h)
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "dirty_tiles.h"
+#include "pixel_convert.h"
+#include "hw_cursor.h"
+
+struct FrameSnapshot {
+    std::vector<uint8_t> pixels;     // guest byte order, 'pitch' bytes per line
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    uint32_t pitch  = 0;
+    GuestPixelFormat format = GuestPixelFormat::ARGB8888;
+
+    // Tiles that differ from the frame the consumer saw last
+    DirtyTiles upload;
+
+    // Cursor overlay at publish time (image copied only on change)
+    HwCursor cursor;
+
+    uint64_t sequence = 0;           // guest VBLANK count
+};
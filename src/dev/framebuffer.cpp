@@ -5,11 +5,22 @@
 // -----------------------------------------------------------
 
 #include "framebuffer.h"
+#include "raster2d.h"
+#include "raster3d.h"
+#include "../log.h"
 #include <cstring>
-#include <iostream>
 
-Framebuffer::Framebuffer() {}
-Framebuffer::~Framebuffer() {}
+Framebuffer::Framebuffer()
+{
+    raster2d  = new Raster2D(this);
+    raster3d_ = new Raster3D(this);
+}
+
+Framebuffer::~Framebuffer()
+{
+    delete raster3d_;
+    delete raster2d;
+}
 
 void Framebuffer::init(uint32_t w, uint32_t h)
 {
@@ -17,11 +28,37 @@ void Framebuffer::init(uint32_t w, uint32_t h)
     fb_height = h;
 
     size_t bytes = (size_t)w * (size_t)h * 4; // ARGB8888
-    pixels.resize(bytes);
-    std::memset(pixels.data(), 0, bytes);
+    own_pixels.assign(bytes, 0);
+    pixels    = own_pixels.data();
+    pix_bytes = bytes;
+
+    tiles_x = (w + TILE_W - 1) / TILE_W;
+    tiles_y = (h + TILE_H - 1) / TILE_H;
+    tile_stamp.assign((size_t)tiles_x * tiles_y, 0);
+    mark_all_dirty();
 
-    std::cout << "[FB] Framebuffer initialized "
-              << w << "x" << h << " (" << bytes/1024 << " KB)\n";
+    Log::out() << "[FB] Framebuffer initialized "
+               << w << "x" << h << " (" << bytes/1024 << " KB)\n";
+}
+
+// -----------------------------------------------------------
+// use_external_storage() - relocate pixels (shared memory export)
+// -----------------------------------------------------------
+void Framebuffer::use_external_storage(uint8_t* mem)
+{
+    if (mem == pixels)
+        return;
+
+    if (!mem) {
+        own_pixels.assign(pixels, pixels + pix_bytes);
+        pixels = own_pixels.data();
+        return;
+    }
+
+    std::memcpy(mem, pixels, pix_bytes);
+    pixels = mem;
+    own_pixels.clear();
+    own_pixels.shrink_to_fit();
 }
 
 // -----------------------------------------------------------
@@ -35,24 +72,121 @@ uint32_t Framebuffer::read_reg(uint32_t offset)
     case 0x0004: return crm_boardid;  // SI board type
     }
 
+    if (offset >= REG_CUR_CTRL && offset <= REG_CUR_DATA)
+        return cursor_read(offset);
+
+    if (offset >= Raster2D::REG_BASE && offset < Raster2D::REG_END)
+        return raster2d->read_reg(offset);
+
+    if (offset >= Raster3D::REG_BASE && offset < Raster3D::REG_END)
+        return raster3d_->read_reg(offset);
+
     return 0;
 }
 
 void Framebuffer::write_reg(uint32_t offset, uint32_t value)
 {
+    if (cursor_write(offset, value))
+        return;
+
+    if (offset >= Raster2D::REG_BASE && offset < Raster2D::REG_END) {
+        raster2d->write_reg(offset, value);
+        return;
+    }
+
+    if (offset >= Raster3D::REG_BASE && offset < Raster3D::REG_END) {
+        raster3d_->write_reg(offset, value);
+        return;
+    }
+
     // Future features:
     // - resolution change
     // - mode switching
-    // - cursor registers
     // For now ignore safely.
 }
 
+// -----------------------------------------------------------
+// Hardware cursor: overlay only, no pixel writes, no dirty tiles
+// -----------------------------------------------------------
+uint32_t Framebuffer::cursor_read(uint32_t offset) const
+{
+    switch (offset)
+    {
+    case REG_CUR_CTRL:   return cur.enabled ? 1 : 0;
+    case REG_CUR_POS:    return ((uint32_t)(cur.y & 0xFFFF) << 16) | (uint32_t)(cur.x & 0xFFFF);
+    case REG_CUR_HOT:    return (cur.hot_y << 16) | cur.hot_x;
+    case REG_CUR_COLOR1: return cur_color[0];
+    case REG_CUR_COLOR2: return cur_color[1];
+    case REG_CUR_COLOR3: return cur_color[2];
+    case REG_CUR_ADDR:   return cur_addr;
+    case REG_CUR_DATA:   return cur_bits[cur_addr];
+    }
+    return 0;
+}
+
+bool Framebuffer::cursor_write(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_CUR_CTRL:
+        cur.enabled = (value & 1) != 0;
+        break;
+
+    case REG_CUR_POS:
+        cur.x = (int16_t)(value & 0xFFFF);
+        cur.y = (int16_t)(value >> 16);
+        break;
+
+    case REG_CUR_HOT:
+        cur.hot_x = (value & 0xFFFF) % HwCursor::SIZE;
+        cur.hot_y = (value >> 16) % HwCursor::SIZE;
+        break;
+
+    case REG_CUR_COLOR1:
+    case REG_CUR_COLOR2:
+    case REG_CUR_COLOR3:
+        cur_color[(offset - REG_CUR_COLOR1) / 4] = value & 0x00FFFFFF;
+        for (uint32_t i = 0; i < HwCursor::SIZE * HwCursor::SIZE / 16; i++)
+            cursor_expand_word(i);
+        cur.image_gen++;
+        break;
+
+    case REG_CUR_ADDR:
+        cur_addr = value % (HwCursor::SIZE * HwCursor::SIZE / 16);
+        return true;
+
+    case REG_CUR_DATA:
+        cur_bits[cur_addr] = value;
+        cursor_expand_word(cur_addr);
+        cur_addr = (cur_addr + 1) % (HwCursor::SIZE * HwCursor::SIZE / 16);
+        cur.image_gen++;
+        break;
+
+    default:
+        return false;
+    }
+
+    cur_serial++;
+    return true;
+}
+
+void Framebuffer::cursor_expand_word(uint32_t index)
+{
+    uint32_t bits = cur_bits[index];
+    uint32_t* dst = &cur.image[index * 16];
+
+    for (uint32_t k = 0; k < 16; k++) {
+        uint32_t v = (bits >> (30 - k * 2)) & 3;
+        dst[k] = v ? (0xFF000000u | cur_color[v - 1]) : 0;
+    }
+}
+
 // -----------------------------------------------------------
 // Direct framebuffer read/write (PROM writes characters here)
 // -----------------------------------------------------------
 uint32_t Framebuffer::fb_read32(uint32_t offset)
 {
-    if (offset + 4 > pixels.size()) return 0;
+    if (offset + 4 > pix_bytes) return 0;
 
     return (pixels[offset + 0] << 24) |
            (pixels[offset + 1] << 16) |
@@ -62,10 +196,118 @@ uint32_t Framebuffer::fb_read32(uint32_t offset)
 
 void Framebuffer::fb_write32(uint32_t offset, uint32_t value)
 {
-    if (offset + 4 > pixels.size()) return;
+    if (offset + 4 > pix_bytes) return;
 
     pixels[offset + 0] = (value >> 24) & 0xFF;
     pixels[offset + 1] = (value >> 16) & 0xFF;
     pixels[offset + 2] = (value >>  8) & 0xFF;
     pixels[offset + 3] = (value >>  0) & 0xFF;
+
+    mark_dirty(offset);
+}
+
+// -----------------------------------------------------------
+// Bulk writes: one copy + one pass over the touched tiles
+// -----------------------------------------------------------
+void Framebuffer::fb_write_block(uint32_t offset, const uint8_t* src, uint32_t len)
+{
+    if ((uint64_t)offset + len > pix_bytes) return;
+
+    std::memcpy(&pixels[offset], src, len);
+    mark_dirty_range(offset, len);
+}
+
+void Framebuffer::fb_fill32(uint32_t offset, uint32_t value, uint32_t count)
+{
+    uint64_t len = (uint64_t)count * 4;
+    if ((uint64_t)offset + len > pix_bytes) return;
+
+    uint8_t be[4] = {
+        (uint8_t)(value >> 24), (uint8_t)(value >> 16),
+        (uint8_t)(value >>  8), (uint8_t)(value >>  0)
+    };
+
+    uint8_t* p = &pixels[offset];
+    for (uint32_t i = 0; i < count; i++, p += 4)
+        std::memcpy(p, be, 4);
+
+    mark_dirty_range(offset, (uint32_t)len);
+}
+
+// -----------------------------------------------------------
+// Dirty tracking
+// -----------------------------------------------------------
+void Framebuffer::mark_dirty_range(uint32_t offset, uint32_t len)
+{
+    if (len == 0) return;
+
+    uint32_t pitch_bytes = fb_width * 4;
+    uint32_t first = offset;
+    uint32_t last  = offset + len - 1;     // last byte written
+
+    uint32_t y0 = first / pitch_bytes;
+    uint32_t y1 = last  / pitch_bytes;
+
+    for (uint32_t y = y0; y <= y1; y++)
+    {
+        // Span of this scanline covered by the write
+        uint32_t line = y * pitch_bytes;
+        uint32_t xs = (y == y0) ? (first - line) / 4 : 0;
+        uint32_t xe = (y == y1) ? (last  - line) / 4 : fb_width - 1;
+
+        uint32_t* row = &tile_stamp[(y / TILE_H) * tiles_x];
+        for (uint32_t tx = xs / TILE_W; tx <= xe / TILE_W; tx++)
+            row[tx] = epoch;
+
+        // Whole tile rows in the middle of a big write: skip ahead
+        if (y != y0 && xs == 0 && xe == fb_width - 1) {
+            uint32_t tile_end = (y / TILE_H + 1) * TILE_H - 1;
+            if (tile_end < y1) y = tile_end;
+        }
+    }
+
+    last_write = epoch;
+}
+
+void Framebuffer::mark_dirty_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    if (w == 0 || h == 0) return;
+
+    uint32_t tx0 = x / TILE_W, tx1 = (x + w - 1) / TILE_W;
+    uint32_t ty0 = y / TILE_H, ty1 = (y + h - 1) / TILE_H;
+
+    for (uint32_t ty = ty0; ty <= ty1; ty++) {
+        uint32_t* row = &tile_stamp[ty * tiles_x];
+        for (uint32_t tx = tx0; tx <= tx1; tx++)
+            row[tx] = epoch;
+    }
+
+    last_write = epoch;
+}
+
+void Framebuffer::mark_all_dirty()
+{
+    for (auto& s : tile_stamp) s = epoch;
+    last_write = epoch;
+}
+
+void Framebuffer::collect_dirty(DirtyCursor& c, DirtyTiles& out)
+{
+    if (out.tiles_x != tiles_x || out.tiles_y != tiles_y)
+        out.resize(fb_width, fb_height, TILE_W, TILE_H);
+
+    out.clear();
+
+    if (has_changes(c)) {
+        for (uint32_t ty = 0; ty < tiles_y; ty++) {
+            const uint32_t* row = &tile_stamp[ty * tiles_x];
+            uint64_t bits = 0;
+            for (uint32_t tx = 0; tx < tiles_x; tx++)
+                if (row[tx] > c.seen) bits |= (1ULL << tx);
+            out.rows[ty] = bits;
+        }
+    }
+
+    // Writes from now on belong to a newer epoch than this cursor
+    c.seen = epoch++;
 }
@@ -7,14 +7,48 @@
 //   - 32-bit ARGB
 //   - MMIO mapped via emulator.cpp Part 2
 //   - PROM/IRIX will write directly to this buffer
+//   - Writes stamp the 64x16 tile they touch, so consumers
+//     (display, capture) only look at what changed
+//   - 2D raster engine (fill / copy / glyph expand) behind the
+//     register block, see raster2d.h
+//   - 3D command FIFO and software rasteriser, see raster3d.h
+//   - 64x64 2bpp hardware cursor kept as an overlay (hw_cursor.h);
+//     it never dirties framebuffer tiles
 // -----------------------------------------------------------
 
 #pragma once
 #include <cstdint>
 #include <vector>
+#include "dirty_tiles.h"
+#include "pixel_convert.h"
+#include "hw_cursor.h"
+
+class Raster2D;
+class Raster3D;
 
 class Framebuffer {
 public:
+    // Dirty tracking granularity. 64 pixel wide tiles keep a
+    // 1280 (up to 4096) pixel line of tiles in one mask word.
+    static constexpr uint32_t TILE_W = 64;
+    static constexpr uint32_t TILE_H = 16;
+
+    // Cursor registers
+    static constexpr uint32_t REG_CUR_CTRL   = 0x0100;  // bit 0: enable
+    static constexpr uint32_t REG_CUR_POS    = 0x0104;  // (y << 16) | x, signed 16-bit
+    static constexpr uint32_t REG_CUR_HOT    = 0x0108;  // (y << 16) | x
+    static constexpr uint32_t REG_CUR_COLOR1 = 0x010C;  // 0x00RRGGBB for pixel value 1
+    static constexpr uint32_t REG_CUR_COLOR2 = 0x0110;
+    static constexpr uint32_t REG_CUR_COLOR3 = 0x0114;
+    static constexpr uint32_t REG_CUR_ADDR   = 0x0118;  // image word index (0..255)
+    static constexpr uint32_t REG_CUR_DATA   = 0x011C;  // 16 pixels, 2 bits each, MSB first; auto-increments
+
+    // Per-consumer position in the write history. Each consumer
+    // (display, capture, ...) keeps its own cursor.
+    struct DirtyCursor {
+        uint32_t seen = 0;
+    };
+
     Framebuffer();
     ~Framebuffer();
 
@@ -22,25 +56,90 @@ public:
     void init(uint32_t w, uint32_t h);
 
     // Access raw pixel buffer
-    uint8_t* data() { return pixels.data(); }
-    uint32_t size() const { return pixels.size(); }
+    uint8_t* data() { return pixels; }
+    const uint8_t* data() const { return pixels; }
+    uint32_t size() const { return (uint32_t)pix_bytes; }
+
+    // Move pixel storage into caller-provided memory (e.g. a shared
+    // memory segment) of at least size() bytes. Current contents are
+    // copied; nullptr switches back to private storage.
+    void use_external_storage(uint8_t* mem);
 
     // MMIO access (GPU registers)
     uint32_t read_reg(uint32_t offset);
     void     write_reg(uint32_t offset, uint32_t value);
 
+    // 2D acceleration (registers at Raster2D::REG_BASE)
+    Raster2D& raster() { return *raster2d; }
+
+    // 3D pipeline (registers at Raster3D::REG_BASE)
+    Raster3D& raster3d() { return *raster3d_; }
+
     // Direct screen write (PROM/IRIX)
     void fb_write32(uint32_t offset, uint32_t value);
     uint32_t fb_read32(uint32_t offset);
 
+    // Bulk writes (DMA, block fills); bytes are guest order
+    void fb_write_block(uint32_t offset, const uint8_t* src, uint32_t len);
+    void fb_fill32(uint32_t offset, uint32_t value, uint32_t count);
+
+    // Dirty tracking
+    bool has_changes(const DirtyCursor& c) const { return last_write > c.seen; }
+    void collect_dirty(DirtyCursor& c, DirtyTiles& out);
+    void mark_all_dirty();
+    void mark_dirty_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+    // Cursor overlay; serial changes on any cursor register write
+    const HwCursor& hw_cursor() const { return cur; }
+    uint64_t cursor_serial() const { return cur_serial; }
+
     // Get dimensions
     uint32_t width()  const { return fb_width;  }
     uint32_t height() const { return fb_height; }
+    uint32_t pitch()  const { return fb_width * 4; }
+
+    // Layout of guest pixels in the buffer (display converts from this)
+    GuestPixelFormat format() const { return pix_format; }
 
 private:
-    std::vector<uint8_t> pixels;  // ARGB8888 framebuffer
+    std::vector<uint8_t> own_pixels;   // private storage
+    uint8_t* pixels    = nullptr;      // ARGB8888 framebuffer (own or external)
+    size_t   pix_bytes = 0;
     uint32_t fb_width  = 1280;
     uint32_t fb_height = 1024;
+    GuestPixelFormat pix_format = GuestPixelFormat::ARGB8888;
+    Raster2D* raster2d  = nullptr;
+    Raster3D* raster3d_ = nullptr;
+
+    // Dirty tracking: every write stamps its tile with the
+    // current epoch; collect_dirty() reports tiles stamped after
+    // the consumer's cursor and then opens a new epoch.
+    std::vector<uint32_t> tile_stamp;
+    uint32_t tiles_x    = 0;
+    uint32_t tiles_y    = 0;
+    uint32_t epoch      = 1;
+    uint32_t last_write = 0;
+
+    inline void mark_dirty(uint32_t offset)
+    {
+        uint32_t y = offset / (fb_width * 4);
+        uint32_t x = (offset >> 2) - y * fb_width;
+        tile_stamp[(y / TILE_H) * tiles_x + (x / TILE_W)] = epoch;
+        last_write = epoch;
+    }
+
+    void mark_dirty_range(uint32_t offset, uint32_t len);
+
+    // Hardware cursor
+    HwCursor cur;
+    uint32_t cur_bits[HwCursor::SIZE * HwCursor::SIZE / 16] = {};   // 2bpp source
+    uint32_t cur_color[3] = { 0, 0, 0 };
+    uint32_t cur_addr   = 0;
+    uint64_t cur_serial = 0;
+
+    void cursor_expand_word(uint32_t index);
+    bool cursor_write(uint32_t offset, uint32_t value);
+    uint32_t cursor_read(uint32_t offset) const;
 
     // Basic CRM registers (prom expects these)
     uint32_t crm_status  = 0x00000001; // present
@@ -0,0 +1,294 @@
+// -----------------------------------------------------------
+// headless_display.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Headless display: frame hashing and image capture
+// -----------------------------------------------------------
+
+#include "headless_display.h"
+#include "pixel_convert.h"
+#include "../log.h"
+#include <cstdio>
+#include <cstring>
+
+HeadlessDisplay::HeadlessDisplay() {}
+HeadlessDisplay::~HeadlessDisplay() {}
+
+// -----------------------------------------------------------
+// VBLANK: only does work for periodic capture / hash watches
+// -----------------------------------------------------------
+void HeadlessDisplay::on_vblank(uint64_t frame)
+{
+    if (!fb)
+        return;
+
+    if (watch_cb && fb->has_changes(hash_cursor)) {
+        if (frame_hash() == watch_value) {
+            auto cb = std::move(watch_cb);
+            watch_cb = nullptr;
+            cb(frame);
+        }
+    }
+
+    if (capture_every && (frame % capture_every) == 0) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/frame_%06llu.%s",
+                      (unsigned long long)frame,
+                      capture_fmt == ImageFormat::PNG ? "png" : "ppm");
+        capture(capture_dir + name, capture_fmt);
+    }
+}
+
+void HeadlessDisplay::set_periodic_capture(const std::string& dir, uint32_t every, ImageFormat fmt)
+{
+    capture_dir   = dir.empty() ? "." : dir;
+    capture_every = every;
+    capture_fmt   = fmt;
+}
+
+void HeadlessDisplay::watch_hash(uint64_t hash, std::function<void(uint64_t)> cb)
+{
+    watch_value = hash;
+    watch_cb    = std::move(cb);
+
+    // Screen may already be there
+    if (fb && frame_hash() == watch_value) {
+        auto f = std::move(watch_cb);
+        watch_cb = nullptr;
+        f(0);
+    }
+}
+
+// -----------------------------------------------------------
+// Frame hash
+// -----------------------------------------------------------
+// Each tile hashes its pixel rows; the frame hash is the XOR of
+// all tile hashes (each seeded with its tile index so identical
+// tiles in different places do not cancel). Re-hashing a dirty
+// tile updates the XOR in O(1).
+// -----------------------------------------------------------
+static inline uint64_t mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t HeadlessDisplay::hash_tile(uint32_t tx, uint32_t ty) const
+{
+    const uint32_t pitch = fb->pitch();
+    const uint32_t x0 = tx * Framebuffer::TILE_W;
+    const uint32_t y0 = ty * Framebuffer::TILE_H;
+    uint32_t w = Framebuffer::TILE_W, h = Framebuffer::TILE_H;
+    if (x0 + w > fb->width())  w = fb->width()  - x0;
+    if (y0 + h > fb->height()) h = fb->height() - y0;
+
+    uint64_t acc = mix64(((uint64_t)ty << 32) | tx);
+    const uint8_t* row = fb->data() + (size_t)y0 * pitch + (size_t)x0 * 4;
+
+    for (uint32_t y = 0; y < h; y++, row += pitch) {
+        const uint8_t* p = row;
+        size_t n = (size_t)w * 4;
+        for (; n >= 8; n -= 8, p += 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            acc = (acc ^ v) * 0x9E3779B97F4A7C15ULL;
+            acc ^= acc >> 29;
+        }
+        for (; n; n--, p++)
+            acc = (acc ^ *p) * 0x100000001B3ULL;
+    }
+
+    return mix64(acc);
+}
+
+uint64_t HeadlessDisplay::frame_hash()
+{
+    if (!fb)
+        return 0;
+
+    if (!fb->has_changes(hash_cursor))
+        return combined;
+
+    fb->collect_dirty(hash_cursor, hash_dirty);
+
+    if (tile_hash.size() != (size_t)hash_dirty.tiles_x * hash_dirty.tiles_y) {
+        // First call: every tile is dirty (cursor starts at 0)
+        tile_hash.assign((size_t)hash_dirty.tiles_x * hash_dirty.tiles_y, 0);
+        combined = 0;
+    }
+
+    for (uint32_t ty = 0; ty < hash_dirty.tiles_y; ty++) {
+        uint64_t bits = hash_dirty.rows[ty];
+        while (bits) {
+            uint32_t tx = (uint32_t)__builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            uint64_t& slot = tile_hash[(size_t)ty * hash_dirty.tiles_x + tx];
+            uint64_t  nh   = hash_tile(tx, ty);
+            combined ^= slot ^ nh;
+            slot = nh;
+        }
+    }
+
+    return combined;
+}
+
+// -----------------------------------------------------------
+// Capture
+// -----------------------------------------------------------
+bool HeadlessDisplay::capture(const std::string& path, ImageFormat fmt)
+{
+    if (!fb)
+        return false;
+
+    bool ok = (fmt == ImageFormat::PNG) ? write_png(path) : write_ppm(path);
+    if (!ok)
+        Log::err() << "[FB] Capture failed: " << path << "\n";
+    return ok;
+}
+
+void HeadlessDisplay::convert_row_rgb(uint32_t y, std::vector<uint32_t>& argb, uint8_t* rgb) const
+{
+    const uint32_t w = fb->width();
+    convert_row(fb->format(), fb->data() + (size_t)y * fb->pitch(), argb.data(), w);
+    fb->hw_cursor().composite_row(y, argb.data(), w);
+
+    for (uint32_t x = 0; x < w; x++) {
+        rgb[x * 3 + 0] = (uint8_t)(argb[x] >> 16);
+        rgb[x * 3 + 1] = (uint8_t)(argb[x] >>  8);
+        rgb[x * 3 + 2] = (uint8_t)(argb[x] >>  0);
+    }
+}
+
+bool HeadlessDisplay::write_ppm(const std::string& path) const
+{
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    const uint32_t w = fb->width(), h = fb->height();
+    std::fprintf(f, "P6\n%u %u\n255\n", w, h);
+
+    std::vector<uint32_t> argb(w);
+    std::vector<uint8_t>  rgb((size_t)w * 3);
+
+    for (uint32_t y = 0; y < h; y++) {
+        convert_row_rgb(y, argb, rgb.data());
+        std::fwrite(rgb.data(), 1, rgb.size(), f);
+    }
+
+    return std::fclose(f) == 0;
+}
+
+// -----------------------------------------------------------
+// Minimal PNG writer: zlib stream of stored (uncompressed)
+// deflate blocks, one per scanline. No external library.
+// -----------------------------------------------------------
+struct Crc32Table {
+    uint32_t v[256];
+
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            v[i] = c;
+        }
+    }
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* p, size_t n)
+{
+    // Built once, thread-safely: machines capture concurrently
+    static const Crc32Table table;
+    const uint32_t* t = table.v;
+
+    crc = ~crc;
+    while (n--)
+        crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_be32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >>  8); p[3] = (uint8_t)(v >>  0);
+}
+
+static void png_chunk(FILE* f, const char* type, const uint8_t* data, uint32_t len)
+{
+    uint8_t hdr[8];
+    put_be32(hdr, len);
+    std::memcpy(hdr + 4, type, 4);
+    std::fwrite(hdr, 1, 8, f);
+    if (len) std::fwrite(data, 1, len, f);
+
+    uint32_t crc = crc32_update(0, (const uint8_t*)type, 4);
+    crc = crc32_update(crc, data, len);
+    uint8_t c[4];
+    put_be32(c, crc);
+    std::fwrite(c, 1, 4, f);
+}
+
+bool HeadlessDisplay::write_png(const std::string& path) const
+{
+    const uint32_t w = fb->width(), h = fb->height();
+    const uint32_t line = w * 3 + 1;             // filter byte + RGB
+    if (line > 0xFFFF) return false;             // one stored block per line
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(sig, 1, 8, f);
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, w);
+    put_be32(ihdr + 4, h);
+    ihdr[8]  = 8;   // bit depth
+    ihdr[9]  = 2;   // colour type: truecolour
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // no interlace
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+
+    // zlib header + stored blocks + adler32
+    std::vector<uint8_t> z;
+    z.reserve(2 + (size_t)h * (line + 5) + 4);
+    z.push_back(0x78);
+    z.push_back(0x01);
+
+    std::vector<uint32_t> argb(w);
+    std::vector<uint8_t>  raw(line);
+    uint32_t a = 1, b = 0;
+
+    for (uint32_t y = 0; y < h; y++) {
+        raw[0] = 0;   // filter: none
+        convert_row_rgb(y, argb, raw.data() + 1);
+
+        z.push_back(y == h - 1 ? 1 : 0);        // BFINAL on last line
+        z.push_back((uint8_t)(line & 0xFF));
+        z.push_back((uint8_t)(line >> 8));
+        z.push_back((uint8_t)(~line & 0xFF));
+        z.push_back((uint8_t)((~line >> 8) & 0xFF));
+        z.insert(z.end(), raw.begin(), raw.end());
+
+        for (uint32_t i = 0; i < line; i++) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+
+    uint8_t ad[4];
+    put_be32(ad, (b << 16) | a);
+    z.insert(z.end(), ad, ad + 4);
+
+    png_chunk(f, "IDAT", z.data(), (uint32_t)z.size());
+    png_chunk(f, "IEND", nullptr, 0);
+
+    return std::fclose(f) == 0;
+}
@@ -0,0 +1,73 @@
+// -----------------------------------------------------------
+// headless_display.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Display backend for hosts without a screen (CI, farms)
+//
+//   - No per-frame work unless something was asked for
+//   - On-demand or periodic capture to PPM / PNG
+//   - Frame hash kept up to date incrementally from dirty
+//     tiles, so tests can wait for "screen reached state X"
+//     without diffing full images every frame
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "framebuffer.h"
+
+class HeadlessDisplay {
+public:
+    enum class ImageFormat { PPM, PNG };
+
+    HeadlessDisplay();
+    ~HeadlessDisplay();
+
+    void attach(Framebuffer* f) { fb = f; }
+
+    // Called by the emulator at guest VBLANK
+    void on_vblank(uint64_t frame);
+
+    // Hash of the current screen contents. Only tiles written
+    // since the previous call are re-hashed. The cursor overlay is
+    // not included (captures do composite it).
+    uint64_t frame_hash();
+
+    // Write the current screen to a file
+    bool capture(const std::string& path, ImageFormat fmt);
+
+    // Capture every 'every' VBLANKs into dir/frame_NNNNNN.{ppm,png}
+    // (every == 0 disables)
+    void set_periodic_capture(const std::string& dir, uint32_t every, ImageFormat fmt);
+
+    // Invoke cb at the first VBLANK whose frame hash equals 'hash'.
+    // One watch at a time; a new call replaces the old watch.
+    void watch_hash(uint64_t hash, std::function<void(uint64_t frame)> cb);
+    void clear_watch() { watch_cb = nullptr; }
+
+private:
+    Framebuffer* fb = nullptr;
+
+    // ---- incremental hash
+    Framebuffer::DirtyCursor hash_cursor;
+    DirtyTiles               hash_dirty;
+    std::vector<uint64_t>    tile_hash;     // per tile, mixed with tile index
+    uint64_t                 combined = 0;  // XOR of tile_hash[]
+
+    uint64_t hash_tile(uint32_t tx, uint32_t ty) const;
+
+    // ---- periodic capture
+    std::string capture_dir;
+    uint32_t    capture_every = 0;
+    ImageFormat capture_fmt   = ImageFormat::PPM;
+
+    // ---- hash watch
+    uint64_t watch_value = 0;
+    std::function<void(uint64_t)> watch_cb;
+
+    void convert_row_rgb(uint32_t y, std::vector<uint32_t>& argb, uint8_t* rgb) const;
+    bool write_ppm(const std::string& path) const;
+    bool write_png(const std::string& path) const;
+};
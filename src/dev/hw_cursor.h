@@ -0,0 +1,80 @@
+// -----------------------------------------------------------
+// hw_cursor.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Hardware cursor overlay state
+//
+// The cursor never touches framebuffer pixels. Display backends
+// composite it when presenting: moving it changes a few fields,
+// and the 64x64 image is only copied again when the guest loads
+// a new one (image_gen changes).
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+struct HwCursor {
+    static constexpr uint32_t SIZE = 64;
+
+    bool     enabled = false;
+    int32_t  x = 0, y = 0;            // hotspot position on screen
+    uint32_t hot_x = 0, hot_y = 0;
+
+    // Expanded image, host ARGB8888; alpha 0 = transparent
+    uint32_t image_gen = 0;
+    uint32_t image[SIZE * SIZE] = {};
+
+    int32_t left() const { return x - (int32_t)hot_x; }
+    int32_t top()  const { return y - (int32_t)hot_y; }
+
+    // Copy state; the image only when it differs
+    void copy_from(const HwCursor& o)
+    {
+        enabled = o.enabled;
+        x = o.x;
+        y = o.y;
+        hot_x = o.hot_x;
+        hot_y = o.hot_y;
+        if (image_gen != o.image_gen) {
+            std::memcpy(image, o.image, sizeof(image));
+            image_gen = o.image_gen;
+        }
+    }
+
+    // Blend the cursor over one row of host ARGB pixels (row y of
+    // a 'width' wide screen). Used by software backends.
+    void composite_row(uint32_t row_y, uint32_t* argb, uint32_t width) const
+    {
+        if (!enabled)
+            return;
+
+        int32_t cy = (int32_t)row_y - top();
+        if (cy < 0 || cy >= (int32_t)SIZE)
+            return;
+
+        const uint32_t* src = &image[(uint32_t)cy * SIZE];
+        for (int32_t cx = 0; cx < (int32_t)SIZE; cx++) {
+            int32_t sx = left() + cx;
+            if (sx < 0 || sx >= (int32_t)width)
+                continue;
+
+            uint32_t s = src[cx];
+            uint32_t a = s >> 24;
+            if (a == 0)
+                continue;
+            if (a == 255) {
+                argb[sx] = s;
+                continue;
+            }
+
+            uint32_t d = argb[sx];
+            uint32_t out = 0xFF000000u;
+            for (int sh = 0; sh < 24; sh += 8) {
+                uint32_t c = (((s >> sh) & 0xFF) * a + ((d >> sh) & 0xFF) * (255 - a)) / 255;
+                out |= c << sh;
+            }
+            argb[sx] = out;
+        }
+    }
+};
@@ -0,0 +1,319 @@
+// -----------------------------------------------------------
+// net_backend.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// pcap / UNIX socket / TAP network backends
+// -----------------------------------------------------------
+
+#include "net_backend.h"
+#include "../log.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#define RACER_HAVE_TAP 1
+#endif
+
+// -----------------------------------------------------------
+// pcap: transmitted frames are appended to a capture file,
+// frames from an optional input capture are replayed as fast
+// as the guest posts receive buffers
+// -----------------------------------------------------------
+class PcapBackend : public NetBackend {
+public:
+    ~PcapBackend() override
+    {
+        if (out) fclose(out);
+        if (in)  fclose(in);
+    }
+
+    bool open(const std::string& out_path, const std::string& in_path)
+    {
+        out = fopen(out_path.c_str(), "wb");
+        if (!out) {
+            Log::err() << "[NET] Cannot create " << out_path << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        // Large stdio buffer: one write() per many frames
+        setvbuf(out, nullptr, _IOFBF, 1 << 20);
+
+        const uint32_t hdr[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };   // LINKTYPE_ETHERNET
+        fwrite(hdr, sizeof(hdr), 1, out);
+
+        if (in_path.empty())
+            return true;
+
+        in = fopen(in_path.c_str(), "rb");
+        uint32_t ih[6];
+        if (!in || fread(ih, sizeof(ih), 1, in) != 1 || (ih[0] != 0xA1B2C3D4 && ih[0] != 0xD4C3B2A1)) {
+            Log::err() << "[NET] Cannot replay " << in_path << ": not a pcap file\n";
+            return false;
+        }
+        in_swapped = ih[0] == 0xD4C3B2A1;
+        return true;
+    }
+
+    const char* kind() const override { return "pcap"; }
+
+    bool send(const uint8_t* frame, size_t len) override
+    {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        const uint32_t rec[4] = { (uint32_t)tv.tv_sec, (uint32_t)tv.tv_usec, (uint32_t)len, (uint32_t)len };
+        fwrite(rec, sizeof(rec), 1, out);
+        fwrite(frame, 1, len, out);
+        return true;
+    }
+
+    size_t recv(uint8_t* buf, size_t cap) override
+    {
+        if (!in)
+            return 0;
+
+        for (;;) {
+            uint32_t rec[4];
+            if (fread(rec, sizeof(rec), 1, in) != 1) {
+                fclose(in);
+                in = nullptr;
+                return 0;
+            }
+            uint32_t incl = in_swapped ? __builtin_bswap32(rec[2]) : rec[2];
+            if (incl > 65535) {
+                fclose(in);   // corrupt record: stop replaying
+                in = nullptr;
+                return 0;
+            }
+
+            if (incl == 0 || incl > cap) {
+                // Skip what the guest could never receive
+                if (fseek(in, incl, SEEK_CUR) != 0) {
+                    fclose(in);
+                    in = nullptr;
+                    return 0;
+                }
+                continue;
+            }
+            if (fread(buf, incl, 1, in) != 1) {
+                fclose(in);
+                in = nullptr;
+                return 0;
+            }
+            return incl;
+        }
+    }
+
+private:
+    FILE* out = nullptr;
+    FILE* in  = nullptr;
+    bool  in_swapped = false;
+};
+
+// -----------------------------------------------------------
+// UNIX socket: SOCK_SEQPACKET keeps frame boundaries. The first
+// instance on a path listens and accepts its peer lazily; the
+// second connects. Everything is non-blocking.
+// -----------------------------------------------------------
+class UnixSocketBackend : public NetBackend {
+public:
+    ~UnixSocketBackend() override
+    {
+        if (peer >= 0)
+            ::close(peer);
+        if (listener >= 0) {
+            ::close(listener);
+            unlink(path.c_str());
+        }
+    }
+
+    bool open(const std::string& p)
+    {
+        path = p;
+
+        struct sockaddr_un sa = {};
+        sa.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(sa.sun_path)) {
+            Log::err() << "[NET] Socket path too long: " << path << "\n";
+            return false;
+        }
+        std::strcpy(sa.sun_path, path.c_str());
+
+        // Peer already listening?
+        int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        if (fd < 0) {
+            Log::err() << "[NET] socket: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) == 0) {
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            peer = fd;
+            Log::out() << "[NET] Connected to " << path << "\n";
+            return true;
+        }
+
+        // No: listen for it (a stale socket file is replaced)
+        unlink(path.c_str());
+        if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, 1) != 0) {
+            Log::err() << "[NET] Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+            ::close(fd);
+            return false;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        listener = fd;
+        Log::out() << "[NET] Waiting for peer on " << path << "\n";
+        return true;
+    }
+
+    const char* kind() const override { return "unix socket"; }
+
+    bool send(const uint8_t* frame, size_t len) override
+    {
+        if (!connected())
+            return true;             // nobody on the wire
+        ssize_t n = ::send(peer, frame, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return false;            // peer's queue is full
+        if (n < 0)
+            drop_peer();
+        return true;
+    }
+
+    size_t recv(uint8_t* buf, size_t cap) override
+    {
+        if (!connected())
+            return 0;
+        ssize_t n = ::recv(peer, buf, cap, MSG_DONTWAIT);
+        if (n > 0)
+            return (size_t)n;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            drop_peer();
+        return 0;
+    }
+
+private:
+    std::string path;
+    int listener = -1;
+    int peer     = -1;
+
+    bool connected()
+    {
+        if (peer >= 0)
+            return true;
+        if (listener < 0)
+            return false;
+        peer = accept(listener, nullptr, nullptr);
+        if (peer < 0)
+            return false;
+        fcntl(peer, F_SETFL, O_NONBLOCK);
+        Log::out() << "[NET] Peer connected on " << path << "\n";
+        return true;
+    }
+
+    void drop_peer()
+    {
+        Log::out() << "[NET] Peer on " << path << " went away\n";
+        ::close(peer);
+        peer = -1;
+    }
+};
+
+#ifdef RACER_HAVE_TAP
+// -----------------------------------------------------------
+// TAP: raw Ethernet frames to and from a host interface. The
+// interface must exist and be owned by us (ip tuntap add ...).
+// -----------------------------------------------------------
+class TapBackend : public NetBackend {
+public:
+    ~TapBackend() override
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    bool open(const std::string& ifname)
+    {
+        fd = ::open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+        if (fd < 0) {
+            Log::err() << "[NET] /dev/net/tun: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        struct ifreq ifr = {};
+        ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+        std::strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+        if (ioctl(fd, TUNSETIFF, &ifr) != 0) {
+            Log::err() << "[NET] TAP " << ifname << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    const char* kind() const override { return "tap"; }
+
+    bool send(const uint8_t* frame, size_t len) override
+    {
+        ssize_t n = ::write(fd, frame, len);
+        return n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+
+    size_t recv(uint8_t* buf, size_t cap) override
+    {
+        ssize_t n = ::read(fd, buf, cap);
+        return n > 0 ? (size_t)n : 0;
+    }
+
+private:
+    int fd = -1;
+};
+#endif
+
+// -----------------------------------------------------------
+// Factory
+// -----------------------------------------------------------
+NetBackend* NetBackend::open(const std::string& spec)
+{
+    size_t colon = spec.find(':');
+    std::string type = spec.substr(0, colon);
+    std::string arg  = colon == std::string::npos ? "" : spec.substr(colon + 1);
+
+    if (type == "pcap" && !arg.empty()) {
+        size_t comma = arg.find(',');
+        PcapBackend* b = new PcapBackend();
+        if (b->open(arg.substr(0, comma), comma == std::string::npos ? "" : arg.substr(comma + 1)))
+            return b;
+        delete b;
+        return nullptr;
+    }
+
+    if (type == "unix" && !arg.empty()) {
+        UnixSocketBackend* b = new UnixSocketBackend();
+        if (b->open(arg))
+            return b;
+        delete b;
+        return nullptr;
+    }
+
+    if (type == "tap" && !arg.empty()) {
+#ifdef RACER_HAVE_TAP
+        TapBackend* b = new TapBackend();
+        if (b->open(arg))
+            return b;
+        delete b;
+#else
+        Log::err() << "[NET] TAP is not available on this host\n";
+#endif
+        return nullptr;
+    }
+
+    Log::err() << "[NET] Bad network spec '" << spec
+               << "' (want pcap:<out>[,<in>], unix:<path> or tap:<ifname>)\n";
+    return nullptr;
+}
@@ -0,0 +1,42 @@
+// -----------------------------------------------------------
+// net_backend.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Host side of the emulated Ethernet
+//
+//   - send() / recv() never block: the controller polls recv()
+//     from scheduler events and drains whatever has arrived, and
+//     holds transmit back while send() reports the host is full
+//   - Backends, chosen by a spec string:
+//       pcap:<out.pcap>[,<in.pcap>]  capture TX, replay RX
+//       unix:<path>                  SOCK_SEQPACKET link between
+//                                    two local instances (first
+//                                    one listens, second connects)
+//       tap:<ifname>                 Linux TAP device
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+class NetBackend {
+public:
+    static constexpr size_t MAX_FRAME = 1518;   // incl. header + FCS
+
+    virtual ~NetBackend() {}
+
+    virtual const char* kind() const = 0;
+
+    // Queue one frame for the wire. false only for flow control:
+    // the host side is full and the frame should be retried later.
+    // With no peer connected the frame is lost, as on a real wire,
+    // and true is returned.
+    virtual bool send(const uint8_t* frame, size_t len) = 0;
+
+    // Next received frame into buf; its length, or 0 if none yet
+    virtual size_t recv(uint8_t* buf, size_t cap) = 0;
+
+    // nullptr (after printing why) on a bad spec or open failure
+    static NetBackend* open(const std::string& spec);
+};
@@ -0,0 +1,272 @@
+// -----------------------------------------------------------
+// pixel_convert.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Vectorised guest → host pixel conversion with runtime dispatch
+// -----------------------------------------------------------
+
+#include "pixel_convert.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RACER_PIXCONV_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RACER_HOST_BIG_ENDIAN 1
+#endif
+
+typedef void (*RowFunc)(GuestPixelFormat, const uint8_t*, uint32_t*, size_t);
+
+// -----------------------------------------------------------
+// Scalar kernels (any host; also handles SIMD tails)
+// -----------------------------------------------------------
+static inline uint32_t load_be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] <<  8) |  (uint32_t)p[3];
+}
+
+static void row_scalar(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t n)
+{
+    switch (fmt)
+    {
+    case GuestPixelFormat::ARGB8888:
+#ifdef RACER_HOST_BIG_ENDIAN
+        std::memcpy(dst, src, n * 4);
+#else
+        for (size_t i = 0; i < n; i++)
+            dst[i] = load_be32(src + i * 4);
+#endif
+        break;
+
+    case GuestPixelFormat::XRGB8888:
+        for (size_t i = 0; i < n; i++)
+            dst[i] = load_be32(src + i * 4) | 0xFF000000u;
+        break;
+
+    case GuestPixelFormat::ABGR8888:
+        for (size_t i = 0; i < n; i++) {
+            const uint8_t* p = src + i * 4;
+            dst[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[3] << 16) |
+                     ((uint32_t)p[2] <<  8) |  (uint32_t)p[1];
+        }
+        break;
+
+    case GuestPixelFormat::RGB565:
+        for (size_t i = 0; i < n; i++) {
+            uint32_t v = ((uint32_t)src[i * 2] << 8) | src[i * 2 + 1];
+            uint32_t r = (v >> 11) & 0x1F;
+            uint32_t g = (v >>  5) & 0x3F;
+            uint32_t b =  v        & 0x1F;
+            r = (r << 3) | (r >> 2);
+            g = (g << 2) | (g >> 4);
+            b = (b << 3) | (b >> 2);
+            dst[i] = 0xFF000000u | (r << 16) | (g << 8) | b;
+        }
+        break;
+    }
+}
+
+#if defined(RACER_PIXCONV_X86) && !defined(RACER_HOST_BIG_ENDIAN)
+
+// -----------------------------------------------------------
+// SSE2: 32-bit byte swap with shifts (no pshufb available)
+// -----------------------------------------------------------
+static inline __m128i bswap32_sse2(__m128i v)
+{
+    // swap bytes within 16-bit halves, then swap the halves
+    __m128i t = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    t = _mm_shufflelo_epi16(t, _MM_SHUFFLE(2, 3, 0, 1));
+    t = _mm_shufflehi_epi16(t, _MM_SHUFFLE(2, 3, 0, 1));
+    return t;
+}
+
+static void row_sse2(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t n)
+{
+    if (fmt != GuestPixelFormat::ARGB8888 && fmt != GuestPixelFormat::XRGB8888) {
+        row_scalar(fmt, src, dst, n);
+        return;
+    }
+
+    const __m128i alpha = _mm_set1_epi32(fmt == GuestPixelFormat::XRGB8888 ? (int)0xFF000000 : 0);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i * 4 + 16));
+        _mm_storeu_si128((__m128i*)(dst + i),     _mm_or_si128(bswap32_sse2(a), alpha));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_or_si128(bswap32_sse2(b), alpha));
+    }
+
+    if (i < n)
+        row_scalar(fmt, src + i * 4, dst + i, n - i);
+}
+
+// -----------------------------------------------------------
+// SSSE3: one pshufb per 4 pixels, any 32-bit byte order
+// -----------------------------------------------------------
+__attribute__((target("ssse3")))
+static __m128i shuffle_mask_128(GuestPixelFormat fmt)
+{
+    // Destination bytes per pixel (LE): B G R A
+    if (fmt == GuestPixelFormat::ABGR8888)
+        return _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+
+    return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+}
+
+__attribute__((target("ssse3")))
+static void row_ssse3(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t n)
+{
+    if (fmt == GuestPixelFormat::RGB565) {
+        row_scalar(fmt, src, dst, n);
+        return;
+    }
+
+    const __m128i mask  = shuffle_mask_128(fmt);
+    const __m128i alpha = _mm_set1_epi32(fmt == GuestPixelFormat::XRGB8888 ? (int)0xFF000000 : 0);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8_t* s = src + i * 4;
+        __m128i a = _mm_loadu_si128((const __m128i*)(s));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_storeu_si128((__m128i*)(dst + i),      _mm_or_si128(_mm_shuffle_epi8(a, mask), alpha));
+        _mm_storeu_si128((__m128i*)(dst + i + 4),  _mm_or_si128(_mm_shuffle_epi8(b, mask), alpha));
+        _mm_storeu_si128((__m128i*)(dst + i + 8),  _mm_or_si128(_mm_shuffle_epi8(c, mask), alpha));
+        _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_or_si128(_mm_shuffle_epi8(d, mask), alpha));
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_shuffle_epi8(a, mask), alpha));
+    }
+
+    if (i < n)
+        row_scalar(fmt, src + i * 4, dst + i, n - i);
+}
+
+// -----------------------------------------------------------
+// AVX2: 8 pixels per vpshufb (in-lane shuffle is fine: pixels
+// never cross a 128-bit lane), plus 565 expansion
+// -----------------------------------------------------------
+__attribute__((target("avx2")))
+static void row_565_avx2(const uint8_t* src, uint32_t* dst, size_t n)
+{
+    const __m256i m5   = _mm256_set1_epi32(0x1F);
+    const __m256i m6   = _mm256_set1_epi32(0x3F);
+    const __m256i opaq = _mm256_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // 8 big-endian halfwords → 8 host dwords
+        __m128i h = _mm_loadu_si128((const __m128i*)(src + i * 2));
+        h = _mm_or_si128(_mm_slli_epi16(h, 8), _mm_srli_epi16(h, 8));
+        __m256i v = _mm256_cvtepu16_epi32(h);
+
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(v, 11), m5);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 5),  m6);
+        __m256i b = _mm256_and_si256(v, m5);
+
+        r = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+        g = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+        b = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+
+        __m256i out = _mm256_or_si256(opaq,
+                      _mm256_or_si256(_mm256_slli_epi32(r, 16),
+                      _mm256_or_si256(_mm256_slli_epi32(g, 8), b)));
+        _mm256_storeu_si256((__m256i*)(dst + i), out);
+    }
+
+    if (i < n)
+        row_scalar(GuestPixelFormat::RGB565, src + i * 2, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void row_avx2(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t n)
+{
+    if (fmt == GuestPixelFormat::RGB565) {
+        row_565_avx2(src, dst, n);
+        return;
+    }
+
+    const __m256i mask = (fmt == GuestPixelFormat::ABGR8888)
+        ? _mm256_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                           1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12)
+        : _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i alpha = _mm256_set1_epi32(fmt == GuestPixelFormat::XRGB8888 ? (int)0xFF000000 : 0);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const uint8_t* s = src + i * 4;
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(s + 96));
+        _mm256_storeu_si256((__m256i*)(dst + i),      _mm256_or_si256(_mm256_shuffle_epi8(a, mask), alpha));
+        _mm256_storeu_si256((__m256i*)(dst + i + 8),  _mm256_or_si256(_mm256_shuffle_epi8(b, mask), alpha));
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), _mm256_or_si256(_mm256_shuffle_epi8(c, mask), alpha));
+        _mm256_storeu_si256((__m256i*)(dst + i + 24), _mm256_or_si256(_mm256_shuffle_epi8(d, mask), alpha));
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(_mm256_shuffle_epi8(a, mask), alpha));
+    }
+
+    if (i < n)
+        row_scalar(fmt, src + i * 4, dst + i, n - i);
+}
+
+#endif // RACER_PIXCONV_X86
+
+// -----------------------------------------------------------
+// Runtime dispatch (resolved once, thread-safe static init)
+// -----------------------------------------------------------
+struct ConvertDispatch {
+    RowFunc     row = row_scalar;
+    const char* isa = "scalar";
+
+    ConvertDispatch()
+    {
+#if defined(RACER_PIXCONV_X86) && !defined(RACER_HOST_BIG_ENDIAN)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))       { row = row_avx2;  isa = "avx2";  }
+        else if (__builtin_cpu_supports("ssse3")) { row = row_ssse3; isa = "ssse3"; }
+        else                                      { row = row_sse2;  isa = "sse2";  }
+#endif
+    }
+};
+
+static const ConvertDispatch& dispatch()
+{
+    static const ConvertDispatch d;
+    return d;
+}
+
+// -----------------------------------------------------------
+// Public entry points
+// -----------------------------------------------------------
+void convert_row(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t count)
+{
+    dispatch().row(fmt, src, dst, count);
+}
+
+void convert_rect(GuestPixelFormat fmt,
+                  const uint8_t* src, size_t src_pitch,
+                  uint8_t* dst, size_t dst_pitch,
+                  uint32_t w, uint32_t h)
+{
+    RowFunc row = dispatch().row;
+
+    for (uint32_t y = 0; y < h; y++)
+        row(fmt, src + y * src_pitch, (uint32_t*)(dst + y * dst_pitch), w);
+}
+
+const char* pixel_convert_isa()
+{
+    return dispatch().isa;
+}
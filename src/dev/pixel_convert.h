@@ -0,0 +1,44 @@
+// -----------------------------------------------------------
+// pixel_convert.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Guest (big-endian) pixel → host ARGB8888 conversion kernels
+//
+//   - Scalar, SSE2, SSSE3 (pshufb) and AVX2 implementations
+//   - Chosen once at first use from the host CPU features
+//   - Row and rectangle entry points, so callers convert only
+//     the dirty parts of a frame
+//
+// Output is a host-native uint32_t 0xAARRGGBB per pixel, which
+// is what SDL_PIXELFORMAT_ARGB8888 expects.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Pixel layouts the SI/CRM path can hand us (bytes in guest memory order)
+enum class GuestPixelFormat : uint32_t {
+    ARGB8888 = 0,   // AA RR GG BB   (default PROM / X11 visual)
+    XRGB8888 = 1,   // xx RR GG BB   alpha ignored, forced opaque
+    ABGR8888 = 2,   // AA BB GG RR   (OpenGL-style ordering)
+    RGB565   = 3,   // RRRRRGGG GGGBBBBB, 16-bit big-endian
+};
+
+// Bytes per pixel for a guest format
+inline uint32_t guest_pixel_bytes(GuestPixelFormat f)
+{
+    return (f == GuestPixelFormat::RGB565) ? 2 : 4;
+}
+
+// Convert 'count' pixels of one scanline
+void convert_row(GuestPixelFormat fmt, const uint8_t* src, uint32_t* dst, size_t count);
+
+// Convert a w x h rectangle; pitches are in bytes
+void convert_rect(GuestPixelFormat fmt,
+                  const uint8_t* src, size_t src_pitch,
+                  uint8_t* dst, size_t dst_pitch,
+                  uint32_t w, uint32_t h);
+
+// Name of the kernel set in use ("avx2", "ssse3", "sse2", "scalar")
+const char* pixel_convert_isa();
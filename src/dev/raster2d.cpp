@@ -0,0 +1,374 @@
+// -----------------------------------------------------------
+// raster2d.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// SI/CRM 2D raster engine: fill / copy / glyph expansion
+// -----------------------------------------------------------
+
+#include "raster2d.h"
+#include "framebuffer.h"
+#include "../scheduler.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#define RACER_RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RACER_HOST_BIG_ENDIAN 1
+#endif
+
+// Register values are 32-bit pixels as the guest sees them; the
+// buffer holds them in guest (big-endian) byte order.
+static inline uint32_t to_guest_order(uint32_t v)
+{
+#ifdef RACER_HOST_BIG_ENDIAN
+    return v;
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+// -----------------------------------------------------------
+// Row kernels
+// -----------------------------------------------------------
+static void fill_row(uint32_t* d, uint32_t n, uint32_t v)
+{
+    uint32_t i = 0;
+#ifdef RACER_RASTER_SSE2
+    const __m128i c = _mm_set1_epi32((int)v);
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(d + i +  0), c);
+        _mm_storeu_si128((__m128i*)(d + i +  4), c);
+        _mm_storeu_si128((__m128i*)(d + i +  8), c);
+        _mm_storeu_si128((__m128i*)(d + i + 12), c);
+    }
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i*)(d + i), c);
+#endif
+    for (; i < n; i++)
+        d[i] = v;
+}
+
+#ifdef RACER_RASTER_SSE2
+// Lane j of entry n selects fg when bit (3 - j) of n is set
+// (MSB of the nibble is the leftmost pixel)
+struct ExpandMasks {
+    __m128i m[16];
+    ExpandMasks()
+    {
+        for (int n = 0; n < 16; n++)
+            m[n] = _mm_set_epi32((n & 1) ? -1 : 0, (n & 2) ? -1 : 0,
+                                 (n & 4) ? -1 : 0, (n & 8) ? -1 : 0);
+    }
+};
+static const ExpandMasks expand_masks;
+#endif
+
+static void expand_row(uint32_t* d, uint32_t n, const uint32_t* bits,
+                       uint32_t fgv, uint32_t bgv, bool transparent)
+{
+    uint32_t i = 0;
+#ifdef RACER_RASTER_SSE2
+    const __m128i f = _mm_set1_epi32((int)fgv);
+    const __m128i b = _mm_set1_epi32((int)bgv);
+    for (; i + 4 <= n; i += 4) {
+        uint32_t nib = (bits[i >> 5] >> (28 - (i & 31))) & 0xF;
+        __m128i  m   = expand_masks.m[nib];
+        __m128i  bk  = transparent ? _mm_loadu_si128((const __m128i*)(d + i)) : b;
+        _mm_storeu_si128((__m128i*)(d + i),
+                         _mm_or_si128(_mm_and_si128(m, f), _mm_andnot_si128(m, bk)));
+    }
+#endif
+    for (; i < n; i++) {
+        bool set = (bits[i >> 5] >> (31 - (i & 31))) & 1;
+        if (set)
+            d[i] = fgv;
+        else if (!transparent)
+            d[i] = bgv;
+    }
+}
+
+// -----------------------------------------------------------
+// Raster2D
+// -----------------------------------------------------------
+Raster2D::Raster2D(Framebuffer* f) : fb(f) {}
+
+Raster2D::~Raster2D()
+{
+    if (done_event && sched)
+        sched->cancel(done_event);
+}
+
+// Clip a rectangle to the screen; returns false if nothing is left
+static bool clip_rect(const Framebuffer* fb, uint32_t x, uint32_t y, uint32_t& w, uint32_t& h)
+{
+    if (x >= fb->width() || y >= fb->height() || w == 0 || h == 0)
+        return false;
+    if (w > fb->width()  - x) w = fb->width()  - x;
+    if (h > fb->height() - y) h = fb->height() - y;
+    return true;
+}
+
+void Raster2D::fill(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
+{
+    if (!clip_rect(fb, x, y, w, h))
+        return;
+
+    const uint32_t v = to_guest_order(color);
+    const uint32_t pitch = fb->pitch();
+    uint8_t* row = fb->data() + (size_t)y * pitch + (size_t)x * 4;
+
+    for (uint32_t j = 0; j < h; j++, row += pitch)
+        fill_row((uint32_t*)row, w, v);
+
+    fb->mark_dirty_rect(x, y, w, h);
+}
+
+void Raster2D::copy(uint32_t sx, uint32_t sy, uint32_t dx, uint32_t dy, uint32_t w, uint32_t h)
+{
+    // Both rectangles must be on screen
+    if (!clip_rect(fb, sx, sy, w, h) || !clip_rect(fb, dx, dy, w, h))
+        return;
+
+    const uint32_t pitch = fb->pitch();
+    uint8_t* base = fb->data();
+    const size_t bytes = (size_t)w * 4;
+
+    // Overlapping scroll down: walk rows bottom-up so source rows
+    // are read before they are overwritten. memmove covers
+    // horizontal overlap within a row.
+    if (dy > sy) {
+        for (uint32_t j = h; j-- > 0;)
+            std::memmove(base + (size_t)(dy + j) * pitch + (size_t)dx * 4,
+                         base + (size_t)(sy + j) * pitch + (size_t)sx * 4, bytes);
+    } else {
+        for (uint32_t j = 0; j < h; j++)
+            std::memmove(base + (size_t)(dy + j) * pitch + (size_t)dx * 4,
+                         base + (size_t)(sy + j) * pitch + (size_t)sx * 4, bytes);
+    }
+
+    fb->mark_dirty_rect(dx, dy, w, h);
+}
+
+void Raster2D::expand(uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+                      const uint32_t* bits, uint32_t fgc, uint32_t bgc, bool transparent)
+{
+    const uint32_t words_per_row = (w + 31) / 32;
+    uint32_t cw = w, ch = h;
+    if (!clip_rect(fb, x, y, cw, ch))
+        return;
+
+    const uint32_t fgv = to_guest_order(fgc);
+    const uint32_t bgv = to_guest_order(bgc);
+    const uint32_t pitch = fb->pitch();
+    uint8_t* row = fb->data() + (size_t)y * pitch + (size_t)x * 4;
+
+    for (uint32_t j = 0; j < ch; j++, row += pitch, bits += words_per_row)
+        expand_row((uint32_t*)row, cw, bits, fgv, bgv, transparent);
+
+    fb->mark_dirty_rect(x, y, cw, ch);
+}
+
+// -----------------------------------------------------------
+// Timing model
+// -----------------------------------------------------------
+// The host finishes a command as soon as it is issued; what the
+// guest observes (BUSY, FIFO space, DONE interrupt) follows the
+// modelled engine. Issuing past a full FIFO is accepted - real
+// hardware would stall the bus, which we cannot do from MMIO.
+// -----------------------------------------------------------
+uint64_t Raster2D::now() const
+{
+    return sched ? sched->now() : 0;
+}
+
+void Raster2D::retire()
+{
+    const uint64_t t = now();
+    while (!fifo_done.empty() && fifo_done.front() <= t)
+        fifo_done.pop_front();
+}
+
+void Raster2D::account(uint64_t pixels, uint64_t px_per_cycle)
+{
+    executed++;
+    done = false;
+    update_irq();
+
+    if (!sched) {
+        // No timeline (tools): complete immediately
+        on_complete();
+        return;
+    }
+
+    const uint64_t t = now();
+    const uint64_t start = (engine_free_at > t) ? engine_free_at : t;
+    engine_free_at = start + SETUP_CYCLES + (pixels + px_per_cycle - 1) / px_per_cycle;
+
+    retire();
+    fifo_done.push_back(engine_free_at);
+
+    if (done_event)
+        sched->cancel(done_event);
+
+    done_event = sched->schedule_at(engine_free_at, [this]() {
+        done_event = 0;
+        on_complete();
+    });
+}
+
+void Raster2D::on_complete()
+{
+    fifo_done.clear();
+    done = true;
+    update_irq();
+}
+
+void Raster2D::update_irq()
+{
+    bool level = done && (ctrl & CTRL_DONE_IRQ);
+    if (level == irq_asserted)
+        return;
+
+    irq_asserted = level;
+    if (irq_cb)
+        irq_cb(level);
+}
+
+// -----------------------------------------------------------
+// Command dispatch
+// -----------------------------------------------------------
+void Raster2D::start(uint32_t cmd)
+{
+    if ((cmd & 0xFF) == CMD_EXPAND) {
+        // Wait for the glyph bits on REG_HOSTDATA
+        const uint32_t w = size_wh & 0xFFFF, h = size_wh >> 16;
+        uint32_t cw = w, ch = h;
+        if (!clip_rect(fb, dst_xy & 0xFFFF, dst_xy >> 16, cw, ch))
+            cw = ch = 0;
+
+        pending_cmd       = cmd;
+        host_row_words    = (w + 31) / 32;
+        host_words_needed = host_row_words * h;
+        host_words_seen   = 0;
+        host_keep_w       = cw;
+        host_keep_h       = ch;
+        host_data.clear();
+        host_data.reserve((size_t)((cw + 31) / 32) * ch);     // bounded by the screen
+        if (host_words_needed == 0) {
+            pending_cmd = 0;
+            execute(cmd);
+        }
+        return;
+    }
+
+    execute(cmd);
+}
+
+void Raster2D::execute(uint32_t cmd)
+{
+    const uint32_t dx = dst_xy & 0xFFFF, dy = dst_xy >> 16;
+    const uint32_t sx = src_xy & 0xFFFF, sy = src_xy >> 16;
+    const uint32_t w  = size_wh & 0xFFFF, h = size_wh >> 16;
+    const uint64_t px = (uint64_t)w * h;
+
+    switch (cmd & 0xFF)
+    {
+    case CMD_FILL:
+        fill(dx, dy, w, h, fg);
+        account(px, FILL_PX_PER_CYC);
+        break;
+
+    case CMD_COPY:
+        copy(sx, sy, dx, dy, w, h);
+        account(px, COPY_PX_PER_CYC);
+        break;
+
+    case CMD_EXPAND:
+        // Stored bits are the visible part, already clipped
+        expand(dx, dy, host_keep_w, host_keep_h, host_data.data(), fg, bg,
+               (cmd & CMD_TRANSPARENT) != 0);
+        account(px, EXP_PX_PER_CYC);
+        break;
+
+    default:
+        break;
+    }
+}
+
+// -----------------------------------------------------------
+// Guest register access
+// -----------------------------------------------------------
+uint32_t Raster2D::read_reg(uint32_t offset)
+{
+    switch (offset)
+    {
+    case REG_DST:  return dst_xy;
+    case REG_SRC:  return src_xy;
+    case REG_SIZE: return size_wh;
+    case REG_FG:   return fg;
+    case REG_BG:   return bg;
+    case REG_CTRL: return ctrl;
+
+    case REG_STATUS:
+    {
+        retire();
+        uint32_t used = (uint32_t)fifo_done.size();
+        uint32_t free_slots = used < FIFO_DEPTH ? FIFO_DEPTH - used : 0;
+
+        uint32_t st = free_slots << 8;
+        if (now() < engine_free_at) st |= ST_BUSY;
+        if (done)                   st |= ST_DONE;
+        if (pending_cmd)            st |= ST_HOST_WAIT;
+        return st;
+    }
+    }
+
+    return 0;
+}
+
+void Raster2D::write_reg(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_DST:  dst_xy  = value; return;
+    case REG_SRC:  src_xy  = value; return;
+    case REG_SIZE: size_wh = value; return;
+    case REG_FG:   fg      = value; return;
+    case REG_BG:   bg      = value; return;
+
+    case REG_CTRL:
+        ctrl = value;
+        update_irq();
+        return;
+
+    case REG_STATUS:
+        if (value & ST_DONE) {
+            done = false;
+            update_irq();
+        }
+        return;
+
+    case REG_CMD:
+        start(value);
+        return;
+
+    case REG_HOSTDATA: {
+        if (!pending_cmd)
+            return;
+
+        // Words off screen are consumed but not kept
+        const uint32_t i = host_words_seen++;
+        if (i / host_row_words < host_keep_h && i % host_row_words < (host_keep_w + 31) / 32)
+            host_data.push_back(value);
+        if (host_words_seen == host_words_needed) {
+            uint32_t cmd = pending_cmd;
+            pending_cmd = 0;
+            execute(cmd);
+        }
+        return;
+    }
+    }
+}
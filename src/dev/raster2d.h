@@ -0,0 +1,118 @@
+// -----------------------------------------------------------
+// raster2d.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// SI/CRM 2D raster engine: solid fill, screen-to-screen block
+// copy and monochrome (glyph) expansion.
+//
+//   - Commands run on the host pixel buffer with SIMD kernels
+//     and mark only the rectangle they touch dirty
+//   - Guest-visible busy / FIFO / completion interrupt follow a
+//     per-pixel cost model on the emulator timeline, the same
+//     way the UART models its transmitter
+//
+// Registers live at Framebuffer register offset 0x1000 and up
+// (Framebuffer::write_reg forwards them here).
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <functional>
+
+class Framebuffer;
+class Scheduler;
+
+class Raster2D {
+public:
+    // Register offsets (relative to the framebuffer register block)
+    static constexpr uint32_t REG_BASE     = 0x1000;
+    static constexpr uint32_t REG_DST      = 0x1000;  // (y << 16) | x
+    static constexpr uint32_t REG_SRC      = 0x1004;  // (y << 16) | x, COPY only
+    static constexpr uint32_t REG_SIZE     = 0x1008;  // (h << 16) | w
+    static constexpr uint32_t REG_FG       = 0x100C;  // pixel value, guest order
+    static constexpr uint32_t REG_BG       = 0x1010;
+    static constexpr uint32_t REG_CTRL     = 0x1014;  // R/W
+    static constexpr uint32_t REG_STATUS   = 0x1018;  // R: status, W: ack bits
+    static constexpr uint32_t REG_CMD      = 0x101C;  // W: start command
+    static constexpr uint32_t REG_HOSTDATA = 0x1020;  // W: glyph bits for EXPAND
+    static constexpr uint32_t REG_END      = 0x1100;
+
+    // REG_CMD opcode (low byte) and flags
+    static constexpr uint32_t CMD_FILL   = 1;
+    static constexpr uint32_t CMD_COPY   = 2;
+    static constexpr uint32_t CMD_EXPAND = 3;
+    static constexpr uint32_t CMD_TRANSPARENT = 1u << 8;  // EXPAND: 0 bits keep dst
+
+    // REG_CTRL bits
+    static constexpr uint32_t CTRL_DONE_IRQ = 1u << 0;
+
+    // REG_STATUS bits; FIFO free slots in bits 8..15
+    static constexpr uint32_t ST_BUSY      = 1u << 0;
+    static constexpr uint32_t ST_DONE      = 1u << 1;   // sticky, write 1 to clear
+    static constexpr uint32_t ST_HOST_WAIT = 1u << 2;   // EXPAND waiting for data
+
+    static constexpr uint32_t FIFO_DEPTH = 16;
+
+    explicit Raster2D(Framebuffer* fb);
+    ~Raster2D();
+
+    void attach_scheduler(Scheduler* s) { sched = s; }
+    void set_irq_callback(std::function<void(bool)> cb) { irq_cb = std::move(cb); }
+
+    // Guest MMIO access (CPU thread only)
+    uint32_t read_reg(uint32_t offset);
+    void     write_reg(uint32_t offset, uint32_t value);
+
+    // Host-side entry points (also used by the register interface)
+    void fill(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color);
+    void copy(uint32_t sx, uint32_t sy, uint32_t dx, uint32_t dy, uint32_t w, uint32_t h);
+    void expand(uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+                const uint32_t* bits, uint32_t fg, uint32_t bg, bool transparent);
+
+    uint64_t commands_executed() const { return executed; }
+
+private:
+    Framebuffer* fb;
+
+    // ---- command registers
+    uint32_t dst_xy = 0, src_xy = 0, size_wh = 0;
+    uint32_t fg = 0, bg = 0, ctrl = 0;
+
+    // ---- EXPAND host data: one 32-bit word per 32 pixels of a row,
+    // rows padded to a word, MSB = leftmost pixel
+    // The guest sends every word of its rectangle; only the part
+    // that is on screen (host_keep_w x host_keep_h) is stored
+    uint32_t pending_cmd = 0;
+    uint32_t host_words_needed = 0;
+    uint32_t host_words_seen   = 0;
+    uint32_t host_row_words    = 0;
+    uint32_t host_keep_w = 0, host_keep_h = 0;
+    std::vector<uint32_t> host_data;
+
+    // ---- timing model
+    // Cost in CPU cycles: setup plus pixels / throughput
+    static constexpr uint64_t SETUP_CYCLES    = 40;
+    static constexpr uint64_t FILL_PX_PER_CYC = 8;
+    static constexpr uint64_t COPY_PX_PER_CYC = 4;
+    static constexpr uint64_t EXP_PX_PER_CYC  = 2;
+
+    Scheduler* sched = nullptr;
+    std::function<void(bool)> irq_cb;
+
+    std::deque<uint64_t> fifo_done;   // completion cycle of each queued command
+    uint64_t engine_free_at = 0;
+    uint64_t done_event     = 0;      // pending scheduler event (0 = none)
+    bool     done           = false;
+    bool     irq_asserted   = false;
+    uint64_t executed       = 0;
+
+    uint64_t now() const;
+    void     start(uint32_t cmd);
+    void     execute(uint32_t cmd);
+    void     account(uint64_t pixels, uint64_t px_per_cycle);
+    void     retire();
+    void     on_complete();
+    void     update_irq();
+};
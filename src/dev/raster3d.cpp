@@ -0,0 +1,607 @@
+// -----------------------------------------------------------
+// raster3d.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Tile-binned, multi-threaded software rasteriser
+// -----------------------------------------------------------
+
+#include "raster3d.h"
+#include "framebuffer.h"
+#include "../log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define RACER_RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RACER_HOST_BIG_ENDIAN 1
+#endif
+
+static inline uint32_t to_guest_order(uint32_t v)
+{
+#ifdef RACER_HOST_BIG_ENDIAN
+    return v;
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+static inline float word_to_float(uint32_t w)
+{
+    float f;
+    std::memcpy(&f, &w, 4);
+    return f;
+}
+
+Raster3D::Raster3D(Framebuffer* f) : fb(f)
+{
+    for (int i = 0; i < 16; i++)
+        matrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+Raster3D::~Raster3D()
+{
+    stop_workers();
+}
+
+// -----------------------------------------------------------
+// Guest register access
+// -----------------------------------------------------------
+uint32_t Raster3D::read_reg(uint32_t offset)
+{
+    switch (offset)
+    {
+    case REG_STATUS:
+    {
+        uint32_t queued = (uint32_t)std::min<size_t>(prims.size(), 0xFFFF);
+        uint32_t st = queued << 16;
+        if (in_command) st |= ST_PARSING;
+        if (fence_done) st |= ST_FENCE_DONE;
+        return st;
+    }
+
+    case REG_CTRL:  return ctrl;
+    case REG_FENCE: return fence_value;
+    }
+
+    return 0;
+}
+
+void Raster3D::write_reg(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_FIFO:
+        push_word(value);
+        return;
+
+    case REG_CTRL:
+        ctrl = value;
+        update_irq();
+        return;
+
+    case REG_FENCE:
+        fence_done = false;
+        update_irq();
+        return;
+    }
+}
+
+void Raster3D::update_irq()
+{
+    bool level = fence_done && (ctrl & CTRL_FENCE_IRQ);
+    if (level == irq_asserted)
+        return;
+
+    irq_asserted = level;
+    if (irq_cb)
+        irq_cb(level);
+}
+
+// -----------------------------------------------------------
+// Command FIFO
+// -----------------------------------------------------------
+void Raster3D::submit(const uint32_t* words, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        push_word(words[i]);
+}
+
+void Raster3D::push_word(uint32_t w)
+{
+    if (!in_command) {
+        cmd_op      = w >> 24;
+        cmd_payload = w & 0xFFFF;
+        cmd.clear();
+        if (cmd_payload == 0) {
+            execute(cmd_op, nullptr, 0);
+            return;
+        }
+        in_command = true;
+        return;
+    }
+
+    cmd.push_back(w);
+    if (cmd.size() == cmd_payload) {
+        in_command = false;
+        execute(cmd_op, cmd.data(), cmd_payload);
+    }
+}
+
+void Raster3D::execute(uint32_t op, const uint32_t* p, uint32_t n)
+{
+    ensure_targets();
+
+    switch (op)
+    {
+    case OP_NOP:
+        break;
+
+    case OP_CLEAR:
+        if (n >= 3)
+            add_clear(p[0], p[1], word_to_float(p[2]));
+        break;
+
+    case OP_MATRIX:
+        if (n >= 16)
+            for (int i = 0; i < 16; i++)
+                matrix[i] = word_to_float(p[i]);
+        break;
+
+    case OP_VIEWPORT:
+        if (n >= 2) {
+            vp_x = (int)(p[0] & 0xFFFF);
+            vp_y = (int)(p[0] >> 16);
+            vp_w = (int)(p[1] & 0xFFFF);
+            vp_h = (int)(p[1] >> 16);
+        }
+        break;
+
+    case OP_STATE:
+        if (n >= 1)
+            state = p[0];
+        break;
+
+    case OP_TRIANGLES:
+        for (uint32_t i = 0; i + 12 <= n; i += 12) {
+            Vertex v[3];
+            for (int k = 0; k < 3; k++) {
+                const uint32_t* q = p + i + k * 4;
+                v[k].x = word_to_float(q[0]);
+                v[k].y = word_to_float(q[1]);
+                v[k].z = word_to_float(q[2]);
+                v[k].color = q[3];
+            }
+            add_triangle(v[0], v[1], v[2]);
+
+            if (prims.size() >= MAX_PRIMS)
+                flush();
+        }
+        break;
+
+    case OP_FLUSH:
+        flush();
+        break;
+
+    case OP_FENCE:
+        flush();
+        fence_value = n ? p[0] : 0;
+        fence_done  = true;
+        update_irq();
+        break;
+
+    default:
+        RLOG_FIRST(DEV, Warn, 8, "GFX3D unknown command 0x%llx", op);
+        break;
+    }
+}
+
+// -----------------------------------------------------------
+// Geometry and binning
+// -----------------------------------------------------------
+void Raster3D::ensure_targets()
+{
+    const uint32_t w = fb->width(), h = fb->height();
+    const uint32_t bx = (w + BIN_SIZE - 1) / BIN_SIZE;
+    const uint32_t by = (h + BIN_SIZE - 1) / BIN_SIZE;
+
+    if (bx == bins_x && by == bins_y && depth.size() == (size_t)w * h)
+        return;
+
+    bins_x = bx;
+    bins_y = by;
+    bins.assign((size_t)bx * by, {});
+    depth.assign((size_t)w * h, 1.0f);
+
+    if (vp_w == 0 || vp_h == 0) {
+        vp_w = (int)w;
+        vp_h = (int)h;
+    }
+}
+
+static void bin_prim(std::vector<std::vector<uint32_t>>& bins, uint32_t bins_x,
+                     int x0, int y0, int x1, int y1, uint32_t idx)
+{
+    const uint32_t bx0 = (uint32_t)x0 / Raster3D::BIN_SIZE, bx1 = (uint32_t)x1 / Raster3D::BIN_SIZE;
+    const uint32_t by0 = (uint32_t)y0 / Raster3D::BIN_SIZE, by1 = (uint32_t)y1 / Raster3D::BIN_SIZE;
+
+    for (uint32_t by = by0; by <= by1; by++)
+        for (uint32_t bx = bx0; bx <= bx1; bx++)
+            bins[by * bins_x + bx].push_back(idx);
+}
+
+void Raster3D::add_clear(uint32_t flags, uint32_t color, float d)
+{
+    Prim c{};
+    c.kind        = Prim::Clear;
+    c.x0 = 0;
+    c.y0 = 0;
+    c.x1 = (int)fb->width()  - 1;
+    c.y1 = (int)fb->height() - 1;
+    c.color       = to_guest_order(color);
+    c.clear_depth = d;
+    c.clear_flags = flags;
+
+    prims.push_back(c);
+    bin_prim(bins, bins_x, c.x0, c.y0, c.x1, c.y1, (uint32_t)prims.size() - 1);
+}
+
+static void plane(float out[3], float f0, float f1, float f2,
+                  float x0, float y0, float dx1, float dy1, float dx2, float dy2, float inv_det)
+{
+    out[0] = ((f1 - f0) * dy2 - (f2 - f0) * dy1) * inv_det;
+    out[1] = ((f2 - f0) * dx1 - (f1 - f0) * dx2) * inv_det;
+    out[2] = f0 - out[0] * x0 - out[1] * y0;
+}
+
+void Raster3D::add_triangle(const Vertex& va, const Vertex& vb, const Vertex& vc)
+{
+    const Vertex* in[3] = { &va, &vb, &vc };
+    float sx[3], sy[3], sz[3];
+
+    // Transform, perspective divide, viewport (y down). Triangles
+    // crossing the w = 0 plane are dropped rather than clipped.
+    for (int k = 0; k < 3; k++) {
+        const float* m = matrix;
+        const float x = in[k]->x, y = in[k]->y, z = in[k]->z;
+        float cx = m[0]  * x + m[1]  * y + m[2]  * z + m[3];
+        float cy = m[4]  * x + m[5]  * y + m[6]  * z + m[7];
+        float cz = m[8]  * x + m[9]  * y + m[10] * z + m[11];
+        float cw = m[12] * x + m[13] * y + m[14] * z + m[15];
+        if (cw <= 1e-6f)
+            return;
+
+        float iw = 1.0f / cw;
+        sx[k] = vp_x + (cx * iw + 1.0f) * 0.5f * vp_w;
+        sy[k] = vp_y + (1.0f - cy * iw) * 0.5f * vp_h;
+        sz[k] = (cz * iw + 1.0f) * 0.5f;
+    }
+
+    const float dx1 = sx[1] - sx[0], dy1 = sy[1] - sy[0];
+    const float dx2 = sx[2] - sx[0], dy2 = sy[2] - sy[0];
+    const float area = dx1 * dy2 - dx2 * dy1;
+
+    // Counter-clockwise in NDC is negative area once y points down
+    if (area == 0.0f || ((state & STATE_CULL_BACK) && area > 0.0f))
+        return;
+
+    const float fw = (float)fb->width(), fh = (float)fb->height();
+    float minx = std::min({ sx[0], sx[1], sx[2] }), maxx = std::max({ sx[0], sx[1], sx[2] });
+    float miny = std::min({ sy[0], sy[1], sy[2] }), maxy = std::max({ sy[0], sy[1], sy[2] });
+    if (maxx < 0.0f || maxy < 0.0f || minx >= fw || miny >= fh)
+        return;
+
+    Prim t{};
+    t.kind  = Prim::Triangle;
+    t.state = state;
+    t.x0 = (int)std::max(0.0f, std::floor(minx));
+    t.y0 = (int)std::max(0.0f, std::floor(miny));
+    t.x1 = (int)std::min(fw - 1.0f, std::ceil(maxx));
+    t.y1 = (int)std::min(fh - 1.0f, std::ceil(maxy));
+
+    // Edge functions, positive inside
+    const float sgn = area > 0.0f ? 1.0f : -1.0f;
+    for (int e = 0; e < 3; e++) {
+        int i = e, j = (e + 1) % 3;
+        t.edge[e][0] = sgn * (sy[i] - sy[j]);
+        t.edge[e][1] = sgn * (sx[j] - sx[i]);
+        t.edge[e][2] = sgn * (sx[i] * sy[j] - sy[i] * sx[j]);
+    }
+
+    const float inv = 1.0f / area;
+    plane(t.z, sz[0], sz[1], sz[2], sx[0], sy[0], dx1, dy1, dx2, dy2, inv);
+
+    auto chan = [&](int shift, float out[3]) {
+        plane(out,
+              (float)((va.color >> shift) & 0xFF),
+              (float)((vb.color >> shift) & 0xFF),
+              (float)((vc.color >> shift) & 0xFF),
+              sx[0], sy[0], dx1, dy1, dx2, dy2, inv);
+    };
+    if (state & STATE_GOURAUD) {
+        chan(24, t.a);
+        chan(16, t.r);
+        chan( 8, t.g);
+        chan( 0, t.b);
+    }
+    t.color = to_guest_order(va.color);
+
+    prims.push_back(t);
+    bin_prim(bins, bins_x, t.x0, t.y0, t.x1, t.y1, (uint32_t)prims.size() - 1);
+}
+
+// -----------------------------------------------------------
+// Span kernels
+// -----------------------------------------------------------
+static inline uint32_t shade_scalar(const float r[3], const float g[3], const float b[3],
+                                    const float a[3], float fx, float py)
+{
+    auto ch = [&](const float p[3]) {
+        float v = p[0] * fx + p[1] * py + p[2];
+        v = v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+        return (uint32_t)v;
+    };
+    return to_guest_order((ch(a) << 24) | (ch(r) << 16) | (ch(g) << 8) | ch(b));
+}
+
+#ifdef RACER_RASTER_SSE2
+static inline __m128i bswap32_sse2(__m128i v)
+{
+    __m128i t = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    t = _mm_shufflelo_epi16(t, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(t, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline __m128i channel_sse2(const float p[3], __m128 fx, float py)
+{
+    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), fx), _mm_set1_ps(p[1] * py + p[2]));
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(v);
+}
+#endif
+
+// Fill pixels [x, x + n) of one row of a triangle
+static void shade_span(const float z[3], const float r[3], const float g[3],
+                       const float b[3], const float a[3], uint32_t flat, uint32_t st,
+                       uint32_t* dst, float* zrow, int x, int n, float py)
+{
+    const bool ztest  = (st & Raster3D::STATE_DEPTH_TEST) != 0;
+    const bool zwrite = (st & Raster3D::STATE_DEPTH_WRITE) != 0;
+    const bool smooth = (st & Raster3D::STATE_GOURAUD) != 0;
+    const float zb = z[1] * py + z[2];
+    int i = 0;
+
+#ifdef RACER_RASTER_SSE2
+    const __m128  offs  = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128  za    = _mm_set1_ps(z[0]);
+    const __m128  zbv   = _mm_set1_ps(zb);
+    const __m128i flatv = _mm_set1_epi32((int)flat);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128  fx = _mm_add_ps(_mm_set1_ps((float)(x + i)), offs);
+        __m128i m  = _mm_set1_epi32(-1);
+
+        if (ztest || zwrite) {
+            __m128 zv = _mm_add_ps(_mm_mul_ps(za, fx), zbv);
+            if (ztest) {
+                __m128 zold = _mm_loadu_ps(zrow + i);
+                __m128 pass = _mm_cmplt_ps(zv, zold);
+                if (_mm_movemask_ps(pass) == 0)
+                    continue;
+                m = _mm_castps_si128(pass);
+                if (zwrite)
+                    _mm_storeu_ps(zrow + i, _mm_or_ps(_mm_and_ps(pass, zv), _mm_andnot_ps(pass, zold)));
+            } else {
+                _mm_storeu_ps(zrow + i, zv);
+            }
+        }
+
+        __m128i col = flatv;
+        if (smooth) {
+            __m128i cv = _mm_slli_epi32(channel_sse2(a, fx, py), 24);
+            cv = _mm_or_si128(cv, _mm_slli_epi32(channel_sse2(r, fx, py), 16));
+            cv = _mm_or_si128(cv, _mm_slli_epi32(channel_sse2(g, fx, py), 8));
+            cv = _mm_or_si128(cv, channel_sse2(b, fx, py));
+#ifdef RACER_HOST_BIG_ENDIAN
+            col = cv;
+#else
+            col = bswap32_sse2(cv);
+#endif
+        }
+
+        __m128i* d = (__m128i*)(dst + i);
+        if (ztest)
+            col = _mm_or_si128(_mm_and_si128(m, col), _mm_andnot_si128(m, _mm_loadu_si128(d)));
+        _mm_storeu_si128(d, col);
+    }
+#endif
+
+    for (; i < n; i++) {
+        const float fx = (float)(x + i) + 0.5f;
+        if (ztest || zwrite) {
+            float zv = z[0] * fx + zb;
+            if (ztest && !(zv < zrow[i]))
+                continue;
+            if (zwrite)
+                zrow[i] = zv;
+        }
+        dst[i] = smooth ? shade_scalar(r, g, b, a, fx, py) : flat;
+    }
+}
+
+// -----------------------------------------------------------
+// Per-tile raster (one thread owns the tile)
+// -----------------------------------------------------------
+void Raster3D::raster_tile(uint32_t bin)
+{
+    const std::vector<uint32_t>& list = bins[bin];
+    if (list.empty())
+        return;
+
+    const int fw = (int)fb->width(), fh = (int)fb->height();
+    const int tx0 = (int)((bin % bins_x) * BIN_SIZE);
+    const int ty0 = (int)((bin / bins_x) * BIN_SIZE);
+    const int tx1 = std::min(tx0 + (int)BIN_SIZE, fw) - 1;
+    const int ty1 = std::min(ty0 + (int)BIN_SIZE, fh) - 1;
+
+    const uint32_t pitch = fb->pitch();
+    uint8_t* pixels = fb->data();
+
+    for (uint32_t idx : list) {
+        const Prim& p = prims[idx];
+
+        if (p.kind == Prim::Clear) {
+            for (int y = ty0; y <= ty1; y++) {
+                if (p.clear_flags & CLEAR_COLOR) {
+                    uint32_t* row = (uint32_t*)(pixels + (size_t)y * pitch) + tx0;
+                    std::fill(row, row + (tx1 - tx0 + 1), p.color);
+                }
+                if (p.clear_flags & CLEAR_DEPTH) {
+                    float* zr = &depth[(size_t)y * fw + tx0];
+                    std::fill(zr, zr + (tx1 - tx0 + 1), p.clear_depth);
+                }
+            }
+            continue;
+        }
+
+        const int ys = std::max(p.y0, ty0), ye = std::min(p.y1, ty1);
+        const int xs0 = std::max(p.x0, tx0), xe0 = std::min(p.x1, tx1);
+
+        for (int y = ys; y <= ye; y++) {
+            const float py = (float)y + 0.5f;
+
+            // Intersect the row with each edge's half-plane
+            float lo = (float)xs0, hi = (float)xe0;
+            bool empty = false;
+            for (int e = 0; e < 3 && !empty; e++) {
+                const float A = p.edge[e][0];
+                const float K = p.edge[e][1] * py + p.edge[e][2];
+                if (A > 0.0f)
+                    lo = std::max(lo, std::ceil(-K / A - 0.5f));
+                else if (A < 0.0f)
+                    hi = std::min(hi, std::floor(-K / A - 0.5f));
+                else if (K < 0.0f)
+                    empty = true;
+            }
+            if (empty || lo > hi)
+                continue;
+
+            const int xs = (int)lo, n = (int)hi - xs + 1;
+            uint32_t* row = (uint32_t*)(pixels + (size_t)y * pitch);
+            shade_span(p.z, p.r, p.g, p.b, p.a, p.color, p.state,
+                       row + xs, &depth[(size_t)y * fw + xs], xs, n, py);
+        }
+    }
+}
+
+// -----------------------------------------------------------
+// Worker pool
+// -----------------------------------------------------------
+void Raster3D::set_threads(uint32_t n)
+{
+    stop_workers();
+    want_threads = n;
+}
+
+void Raster3D::start_workers()
+{
+    uint32_t n = want_threads ? want_threads : std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+    if (n > 16) n = 16;
+
+    quitting = false;
+    for (uint32_t i = 1; i < n; i++)
+        workers.emplace_back(&Raster3D::worker_loop, this, job_gen, Log::context());
+
+    Log::out() << "[GFX3D] Rasteriser using " << n << " thread(s)\n";
+}
+
+void Raster3D::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lk(pool_mtx);
+        quitting = true;
+    }
+    pool_cv.notify_all();
+
+    for (auto& t : workers)
+        t.join();
+    workers.clear();
+}
+
+void Raster3D::worker_loop(uint64_t first_gen, const char* log_name)
+{
+    Log::Context log_ctx(log_name);
+    uint64_t seen = first_gen;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(pool_mtx);
+            pool_cv.wait(lk, [&] { return quitting || job_gen != seen; });
+            if (quitting)
+                return;
+            seen = job_gen;
+        }
+
+        const uint32_t total = bins_x * bins_y;
+        for (uint32_t b; (b = next_bin.fetch_add(1, std::memory_order_relaxed)) < total;)
+            raster_tile(b);
+
+        std::lock_guard<std::mutex> lk(pool_mtx);
+        if (--busy_count == 0)
+            done_cv.notify_one();
+    }
+}
+
+void Raster3D::run_bins()
+{
+    if (workers.empty() && (want_threads != 1))
+        start_workers();
+
+    const uint32_t total = bins_x * bins_y;
+    next_bin.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lk(pool_mtx);
+        busy_count = (uint32_t)workers.size();
+        job_gen++;
+    }
+    pool_cv.notify_all();
+
+    // Caller rasterises too
+    for (uint32_t b; (b = next_bin.fetch_add(1, std::memory_order_relaxed)) < total;)
+        raster_tile(b);
+
+    std::unique_lock<std::mutex> lk(pool_mtx);
+    done_cv.wait(lk, [&] { return busy_count == 0; });
+}
+
+// -----------------------------------------------------------
+// flush() - rasterise all bins, then publish dirty tiles
+// -----------------------------------------------------------
+void Raster3D::flush()
+{
+    if (prims.empty())
+        return;
+
+    run_bins();
+
+    const uint32_t fw = fb->width(), fh = fb->height();
+    for (uint32_t i = 0; i < bins.size(); i++) {
+        if (bins[i].empty())
+            continue;
+
+        uint32_t x = (i % bins_x) * BIN_SIZE, y = (i / bins_x) * BIN_SIZE;
+        fb->mark_dirty_rect(x, y, std::min(BIN_SIZE, fw - x), std::min(BIN_SIZE, fh - y));
+        bins[i].clear();
+    }
+
+    for (const Prim& p : prims)
+        if (p.kind == Prim::Triangle)
+            tris_drawn++;
+    prims.clear();
+}
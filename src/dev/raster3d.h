@@ -0,0 +1,174 @@
+// -----------------------------------------------------------
+// raster3d.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Software 3D backend for the graphics board
+//
+//   - Guest feeds a word-oriented command FIFO (REG_FIFO)
+//   - Vertices are transformed / viewport-mapped on the host,
+//     triangles are set up once and binned into 64x64 tiles
+//   - At FLUSH / FENCE the tiles are rasterised in parallel by
+//     a worker pool; each tile is owned by one thread, so no
+//     locking on pixels or depth
+//   - Spans are filled 4 pixels at a time with SSE (depth test,
+//     Gouraud colour), writing straight into Framebuffer pixels
+//
+// Command header: (opcode << 24) | payload word count
+//   OP_CLEAR      flags, colour, depth(float)
+//   OP_MATRIX     16 floats, row major, clip = M * (x y z 1)
+//   OP_VIEWPORT   (y << 16) | x, (h << 16) | w
+//   OP_STATE      STATE_* flags
+//   OP_TRIANGLES  n * 3 vertices of x, y, z (float), ARGB colour
+//   OP_FLUSH      -
+//   OP_FENCE      value (flushes, then REG_FENCE = value)
+//
+// Registers live at Framebuffer register offset 0x2000 and up.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+class Framebuffer;
+
+class Raster3D {
+public:
+    // Register offsets (relative to the framebuffer register block)
+    static constexpr uint32_t REG_BASE   = 0x2000;
+    static constexpr uint32_t REG_FIFO   = 0x2000;  // W: command words
+    static constexpr uint32_t REG_STATUS = 0x2004;  // R
+    static constexpr uint32_t REG_CTRL   = 0x2008;  // R/W
+    static constexpr uint32_t REG_FENCE  = 0x200C;  // R: last fence, W: ack IRQ
+    static constexpr uint32_t REG_END    = 0x2100;
+
+    // Command opcodes
+    enum : uint32_t {
+        OP_NOP       = 0,
+        OP_CLEAR     = 1,
+        OP_MATRIX    = 2,
+        OP_VIEWPORT  = 3,
+        OP_STATE     = 4,
+        OP_TRIANGLES = 5,
+        OP_FLUSH     = 6,
+        OP_FENCE     = 7,
+    };
+
+    // OP_CLEAR flags
+    static constexpr uint32_t CLEAR_COLOR = 1u << 0;
+    static constexpr uint32_t CLEAR_DEPTH = 1u << 1;
+
+    // OP_STATE flags
+    static constexpr uint32_t STATE_DEPTH_TEST  = 1u << 0;   // pass if z < stored
+    static constexpr uint32_t STATE_DEPTH_WRITE = 1u << 1;
+    static constexpr uint32_t STATE_GOURAUD     = 1u << 2;   // else flat, vertex 0
+    static constexpr uint32_t STATE_CULL_BACK   = 1u << 3;   // drop clockwise
+
+    // REG_STATUS bits; queued primitives in bits 16..31
+    static constexpr uint32_t ST_PARSING    = 1u << 0;   // mid-command
+    static constexpr uint32_t ST_FENCE_DONE = 1u << 1;
+
+    // REG_CTRL bits
+    static constexpr uint32_t CTRL_FENCE_IRQ = 1u << 0;
+
+    static constexpr uint32_t BIN_SIZE  = 64;       // tile edge in pixels
+    static constexpr uint32_t MAX_PRIMS = 16384;    // auto-flush threshold
+
+    explicit Raster3D(Framebuffer* fb);
+    ~Raster3D();
+
+    void set_irq_callback(std::function<void(bool)> cb) { irq_cb = std::move(cb); }
+
+    // Rasteriser threads including the caller (0 = host cores)
+    void set_threads(uint32_t n);
+
+    // Guest MMIO access (CPU thread only)
+    uint32_t read_reg(uint32_t offset);
+    void     write_reg(uint32_t offset, uint32_t value);
+
+    // Host-side command submission (same format as REG_FIFO)
+    void submit(const uint32_t* words, size_t count);
+
+    // Rasterise everything binned so far
+    void flush();
+
+    uint64_t triangles_drawn() const { return tris_drawn; }
+
+private:
+    struct Vertex {
+        float x, y, z;
+        uint32_t color;
+    };
+
+    // Set-up primitive: edge functions and attribute planes in
+    // screen space; f(x, y) = p[0] * x + p[1] * y + p[2]
+    struct Prim {
+        enum Kind : uint8_t { Clear, Triangle } kind;
+        uint32_t state;
+        int      x0, y0, x1, y1;        // inclusive pixel bounds
+        float    edge[3][3];
+        float    z[3];
+        float    r[3], g[3], b[3], a[3];
+        uint32_t color;                  // flat colour / clear colour (guest order)
+        float    clear_depth;
+        uint32_t clear_flags;
+    };
+
+    Framebuffer* fb;
+
+    // ---- command parser
+    std::vector<uint32_t> cmd;
+    uint32_t cmd_op      = 0;
+    uint32_t cmd_payload = 0;
+    bool     in_command  = false;
+
+    void push_word(uint32_t w);
+    void execute(uint32_t op, const uint32_t* p, uint32_t n);
+
+    // ---- geometry state
+    float    matrix[16];
+    int      vp_x = 0, vp_y = 0, vp_w = 0, vp_h = 0;
+    uint32_t state = 0;
+
+    void add_clear(uint32_t flags, uint32_t color, float depth);
+    void add_triangle(const Vertex& a, const Vertex& b, const Vertex& c);
+
+    // ---- bins
+    uint32_t bins_x = 0, bins_y = 0;
+    std::vector<Prim> prims;
+    std::vector<std::vector<uint32_t>> bins;   // prim indices per tile, in order
+    std::vector<float> depth;                  // one float per pixel
+
+    void ensure_targets();
+    void raster_tile(uint32_t bin);
+
+    // ---- worker pool
+    std::vector<std::thread> workers;
+    std::mutex               pool_mtx;
+    std::condition_variable  pool_cv;
+    std::condition_variable  done_cv;
+    uint64_t                 job_gen    = 0;
+    uint32_t                 busy_count = 0;
+    bool                     quitting   = false;
+    uint32_t                 want_threads = 0;
+    std::atomic<uint32_t>    next_bin{0};
+
+    void start_workers();
+    void stop_workers();
+    void worker_loop(uint64_t first_gen, const char* log_name);
+    void run_bins();
+
+    // ---- fence / interrupt
+    std::function<void(bool)> irq_cb;
+    uint32_t ctrl         = 0;
+    uint32_t fence_value  = 0;
+    bool     fence_done   = false;
+    bool     irq_asserted = false;
+    uint64_t tris_drawn   = 0;
+
+    void update_irq();
+};
@@ -0,0 +1,623 @@
+// -----------------------------------------------------------
+// scsi.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// SCSI controller / disk target with asynchronous backing store
+// -----------------------------------------------------------
+
+#include "scsi.h"
+#include "../scheduler.h"
+#include "../dma.h"
+#include "../replay.h"
+#include "../log.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// SCSI status bytes
+static constexpr uint8_t STATUS_GOOD  = 0x00;
+static constexpr uint8_t STATUS_CHECK = 0x02;
+
+// Sense keys
+static constexpr uint8_t SENSE_NONE            = 0x00;
+static constexpr uint8_t SENSE_MEDIUM_ERROR    = 0x03;
+static constexpr uint8_t SENSE_ILLEGAL_REQUEST = 0x05;
+static constexpr uint8_t SENSE_DATA_PROTECT    = 0x07;
+
+SCSIController::SCSIController() {}
+
+SCSIController::~SCSIController()
+{
+    if (poll_event && sched)
+        sched->cancel(poll_event);
+    if (done_event && sched)
+        sched->cancel(done_event);
+
+    // Backends drain their own queues on destruction; after that
+    // no request refers to our buffers any more
+    for (Target& t : targets) {
+        delete t.backend;
+        delete t.cdrom;
+    }
+    for (Command* c : in_flight)
+        delete c;
+}
+
+bool SCSIController::attach_disk(uint32_t id, BlockBackend* backend)
+{
+    if (id >= MAX_TARGETS || !backend)
+        return false;
+
+    delete targets[id].backend;
+    delete targets[id].cdrom;
+    targets[id] = Target();
+    targets[id].backend = backend;
+    targets[id].blocks  = backend->size() / BLOCK_SIZE;
+
+    Log::out() << "[SCSI] Target " << id << ": " << targets[id].blocks << " blocks ("
+               << backend->size() / (1024 * 1024) << " MB, " << backend->kind()
+               << (backend->read_only() ? ", read-only" : "") << ")\n";
+    return true;
+}
+
+bool SCSIController::attach_cdrom(uint32_t id, CDROMImage* image)
+{
+    if (id >= MAX_TARGETS || !image)
+        return false;
+
+    delete targets[id].backend;
+    delete targets[id].cdrom;
+    targets[id] = Target();
+    targets[id].cdrom      = image;
+    targets[id].block_size = CDROMImage::SECTOR_SIZE;
+    targets[id].blocks     = image->sectors();
+
+    Log::out() << "[SCSI] Target " << id << ": CD-ROM, " << image->sectors() << " sectors\n";
+    return true;
+}
+
+uint64_t SCSIController::now() const
+{
+    return sched ? sched->now() : 0;
+}
+
+void SCSIController::update_irq()
+{
+    bool level = done && (ctrl & CTRL_DONE_IRQ);
+    if (level == irq_asserted)
+        return;
+
+    irq_asserted = level;
+    if (irq_cb)
+        irq_cb(level);
+}
+
+// -----------------------------------------------------------
+// Guest register access
+// -----------------------------------------------------------
+uint32_t SCSIController::read_reg(uint32_t offset)
+{
+    switch (offset)
+    {
+    case REG_TARGET:   return target_id;
+    case REG_DMA_ADDR: return (uint32_t)dma_addr;
+    case REG_DMA_HI:   return (uint32_t)(dma_addr >> 32);
+    case REG_DMA_LEN:  return dma_len;
+    case REG_CTRL:     return ctrl;
+    case REG_XFER:     return xfer;
+
+    case REG_CDB0: case REG_CDB1: case REG_CDB2: case REG_CDB3:
+    {
+        const uint8_t* p = &cdb[offset - REG_CDB0];
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    case REG_STATUS:
+    {
+        uint32_t st = (uint32_t)scsi_status << 8;
+        if (busy)      st |= ST_BUSY;
+        if (done)      st |= ST_DONE;
+        if (no_target) st |= ST_NO_TARGET;
+        return st;
+    }
+
+    case REG_SENSE:
+        if (target_id < MAX_TARGETS) {
+            const Target& t = targets[target_id];
+            return ((uint32_t)t.sense_key << 16) | ((uint32_t)t.asc << 8) | t.ascq;
+        }
+        return 0;
+    }
+
+    return 0;
+}
+
+void SCSIController::write_reg(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_TARGET:   target_id = value & 0xFF; return;
+    case REG_DMA_ADDR: dma_addr = (dma_addr & ~0xFFFFFFFFULL) | value; return;
+    case REG_DMA_HI:   dma_addr = (dma_addr & 0xFFFFFFFFULL) | ((uint64_t)value << 32); return;
+    case REG_DMA_LEN:  dma_len = value; return;
+
+    case REG_CDB0: case REG_CDB1: case REG_CDB2: case REG_CDB3:
+    {
+        uint8_t* p = &cdb[offset - REG_CDB0];
+        p[0] = (uint8_t)(value >> 24);
+        p[1] = (uint8_t)(value >> 16);
+        p[2] = (uint8_t)(value >>  8);
+        p[3] = (uint8_t)(value >>  0);
+        return;
+    }
+
+    case REG_CTRL:
+        ctrl = value;
+        update_irq();
+        return;
+
+    case REG_STATUS:
+        if (value & ST_DONE) {
+            done = false;
+            update_irq();
+        }
+        return;
+
+    case REG_CMD:
+        if (value & CMD_RESET)
+            bus_reset();
+        else if ((value & CMD_GO) && !busy)
+            start();
+        return;
+    }
+}
+
+// -----------------------------------------------------------
+// Command completion
+// -----------------------------------------------------------
+void SCSIController::finish_now(uint8_t status, uint32_t bytes)
+{
+    busy        = false;
+    done        = true;
+    scsi_status = status;
+    xfer        = bytes;
+    total_bytes += bytes;
+    update_irq();
+}
+
+void SCSIController::complete_at(uint64_t when, uint8_t status, uint32_t bytes)
+{
+    if (!sched) {
+        finish_now(status, bytes);
+        return;
+    }
+
+    done_event = sched->schedule_at(when, [this, status, bytes]() {
+        done_event = 0;
+        finish_now(status, bytes);
+    });
+}
+
+void SCSIController::check_condition(Target& t, uint8_t key, uint8_t asc, uint8_t ascq)
+{
+    t.sense_key = key;
+    t.asc       = asc;
+    t.ascq      = ascq;
+    complete_at(now() + CMD_CYCLES, STATUS_CHECK, 0);
+}
+
+// Copy command response data to the guest DMA window
+uint32_t SCSIController::data_in(const uint8_t* data, uint32_t len)
+{
+    len = std::min(len, dma_len);
+    if (!dma || len == 0 || !dma->write(dma_addr, data, len))
+        return 0;
+    return len;
+}
+
+// -----------------------------------------------------------
+// start() - decode the CDB
+// -----------------------------------------------------------
+void SCSIController::start()
+{
+    busy      = true;
+    done      = false;
+    no_target = false;
+    xfer      = 0;
+    update_irq();
+
+    if (target_id >= MAX_TARGETS || !targets[target_id].present()) {
+        // Selection timeout, reported after the bus timeout
+        no_target = true;
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, 0);
+        return;
+    }
+
+    Target& t = targets[target_id];
+    const uint8_t op = cdb[0];
+
+    switch (op)
+    {
+    case 0x00:  // TEST UNIT READY
+    case 0x1B:  // START STOP UNIT
+    case 0x2F:  // VERIFY(10)
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, 0);
+        return;
+
+    case 0x03:  // REQUEST SENSE
+    {
+        uint8_t s[18] = {};
+        s[0]  = 0x70;
+        s[2]  = t.sense_key;
+        s[7]  = 10;
+        s[12] = t.asc;
+        s[13] = t.ascq;
+        uint32_t n = data_in(s, std::min<uint32_t>(cdb[4] ? cdb[4] : 4, sizeof(s)));
+        t.sense_key = t.asc = t.ascq = 0;
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, n);
+        return;
+    }
+
+    case 0x12:  // INQUIRY
+    {
+        uint8_t d[36] = {};
+        d[0] = t.cdrom ? 0x05 : 0x00;   // CD-ROM / direct-access device
+        d[1] = t.cdrom ? 0x80 : 0x00;   // removable medium
+        d[2] = 0x02;            // SCSI-2
+        d[3] = 0x02;            // response format
+        d[4] = sizeof(d) - 5;
+        std::memcpy(&d[8],  "SGI     ", 8);
+        std::memcpy(&d[16], t.cdrom ? "RACER CD-ROM    " : "RACER DISK      ", 16);
+        std::memcpy(&d[32], "0001", 4);
+        uint32_t n = data_in(d, std::min<uint32_t>(cdb[4], sizeof(d)));
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, n);
+        return;
+    }
+
+    case 0x1A:  // MODE SENSE(6): header + one block descriptor
+    {
+        uint8_t d[12] = {};
+        d[0] = sizeof(d) - 1;
+        d[2] = t.read_only() ? 0x80 : 0x00;   // WP bit
+        d[3] = 8;
+        uint64_t nb = std::min<uint64_t>(t.blocks, 0xFFFFFF);
+        d[5]  = (uint8_t)(nb >> 16); d[6] = (uint8_t)(nb >> 8); d[7] = (uint8_t)nb;
+        d[10] = (uint8_t)(t.block_size >> 8);
+        d[11] = (uint8_t)t.block_size;
+        uint32_t n = data_in(d, std::min<uint32_t>(cdb[4], sizeof(d)));
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, n);
+        return;
+    }
+
+    case 0x25:  // READ CAPACITY(10)
+    {
+        uint64_t last = t.blocks ? t.blocks - 1 : 0;
+        if (last > 0xFFFFFFFF) last = 0xFFFFFFFF;
+        uint8_t d[8] = {
+            (uint8_t)(last >> 24), (uint8_t)(last >> 16), (uint8_t)(last >> 8), (uint8_t)last,
+            0, 0, (uint8_t)(t.block_size >> 8), (uint8_t)t.block_size
+        };
+        uint32_t n = data_in(d, sizeof(d));
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, n);
+        return;
+    }
+
+    case 0x43:  // READ TOC: one data track starting at LBA 0
+    {
+        if (!t.cdrom) {
+            check_condition(t, SENSE_ILLEGAL_REQUEST, 0x20);
+            return;
+        }
+        uint64_t end = std::min<uint64_t>(t.blocks, 0xFFFFFFFF);
+        uint8_t d[20] = {};
+        d[1] = sizeof(d) - 2;
+        d[2] = 1;                       // first track
+        d[3] = 1;                       // last track
+        d[5] = 0x14;  d[6] = 1;         // track 1: data, LBA 0
+        d[13] = 0x14; d[14] = 0xAA;     // lead-out
+        d[16] = (uint8_t)(end >> 24); d[17] = (uint8_t)(end >> 16);
+        d[18] = (uint8_t)(end >> 8);  d[19] = (uint8_t)end;
+        uint32_t alloc = ((uint32_t)cdb[7] << 8) | cdb[8];
+        uint32_t n = data_in(d, std::min<uint32_t>(alloc, sizeof(d)));
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, n);
+        return;
+    }
+
+    case 0x08:  // READ(6)
+    case 0x0A:  // WRITE(6)
+    {
+        uint64_t lba = ((uint64_t)(cdb[1] & 0x1F) << 16) | ((uint64_t)cdb[2] << 8) | cdb[3];
+        uint32_t count = cdb[4] ? cdb[4] : 256;
+        start_rw(t, op == 0x0A, lba, count);
+        return;
+    }
+
+    case 0x28:  // READ(10)
+    case 0x2A:  // WRITE(10)
+    {
+        uint64_t lba = ((uint64_t)cdb[2] << 24) | ((uint64_t)cdb[3] << 16) |
+                       ((uint64_t)cdb[4] << 8) | cdb[5];
+        uint32_t count = ((uint32_t)cdb[7] << 8) | cdb[8];
+        start_rw(t, op == 0x2A, lba, count);
+        return;
+    }
+
+    case 0x35:  // SYNCHRONIZE CACHE(10)
+    {
+        // Read-only medium, nothing to write back
+        if (t.cdrom) {
+            complete_at(now() + CMD_CYCLES, STATUS_GOOD, 0);
+            return;
+        }
+
+        Command* c = new Command();
+        c->req.op   = BlockRequest::Op::Flush;
+        c->req.user = c;
+        c->target   = target_id;
+        issue(t, c, CMD_CYCLES);
+        return;
+    }
+
+    default:
+        check_condition(t, SENSE_ILLEGAL_REQUEST, 0x20);   // invalid opcode
+        return;
+    }
+}
+
+// -----------------------------------------------------------
+// READ / WRITE: hand the transfer to the host asynchronously
+// -----------------------------------------------------------
+void SCSIController::start_rw(Target& t, bool write, uint64_t lba, uint32_t count)
+{
+    if (count == 0) {
+        complete_at(now() + CMD_CYCLES, STATUS_GOOD, 0);
+        return;
+    }
+
+    if (lba + count > t.blocks) {
+        check_condition(t, SENSE_ILLEGAL_REQUEST, 0x21);   // LBA out of range
+        return;
+    }
+
+    if (write && t.read_only()) {
+        check_condition(t, SENSE_DATA_PROTECT, 0x27);      // write protected
+        return;
+    }
+
+    if (t.cdrom) {
+        start_cd_read(t, lba, count);
+        return;
+    }
+
+    const uint64_t bytes = (uint64_t)count * BLOCK_SIZE;
+    if (!dma || bytes > dma_len || !dma->check(dma_addr, bytes)) {
+        check_condition(t, SENSE_ILLEGAL_REQUEST, 0x24);   // bad DMA window
+        return;
+    }
+
+    Command* c = new Command();
+    c->buf.resize((size_t)bytes);
+    c->req.op     = write ? BlockRequest::Op::Write : BlockRequest::Op::Read;
+    c->req.offset = lba * BLOCK_SIZE;
+    c->req.length = (uint32_t)bytes;
+    c->req.buf    = c->buf.data();
+    c->req.user   = c;
+    c->target     = target_id;
+    c->dma_addr   = dma_addr;
+
+    // Data out is taken from guest memory at issue time
+    if (write)
+        dma->read(dma_addr, c->buf.data(), bytes);
+
+    // Modelled disk time: seek unless sequential, then media rate
+    uint64_t cost = CMD_CYCLES + bytes * CYCLES_PER_BYTE;
+    if (lba != t.next_lba)
+        cost += SEEK_CYCLES;
+    t.next_lba = lba + count;
+    issue(t, c, cost);
+}
+
+// Hand a host command to the backend; it completes 'cost' cycles
+// from now, or at the recorded cycle on replay
+void SCSIController::issue(Target& t, Command* c, uint64_t cost)
+{
+    c->issued = now();
+    c->due    = c->issued + cost;
+    c->pinned = virtual_time;
+    if (replay && replay->replaying()) {
+        c->due    = replay->disk_completion(c->issued, c->target, c->due,
+                                            c->replay_error, c->replay_aborted);
+        c->pinned = true;
+    }
+
+    active = c;
+    in_flight.push_back(c);
+
+    if (!t.backend->submit(&c->req)) {
+        in_flight.pop_back();
+        active = nullptr;
+        delete c;
+        check_condition(t, SENSE_MEDIUM_ERROR, 0x00);
+        return;
+    }
+
+    schedule_poll(c->due);
+}
+
+// -----------------------------------------------------------
+// CD-ROM READ: no host request, no bounce buffer. The sectors
+// are DMAed from the image mapping straight into guest RAM at
+// the modelled completion time; readahead has usually paged
+// them in by then.
+// -----------------------------------------------------------
+void SCSIController::start_cd_read(Target& t, uint64_t lba, uint32_t count)
+{
+    const uint64_t bytes = (uint64_t)count * t.block_size;
+    if (!dma || bytes > dma_len) {
+        check_condition(t, SENSE_ILLEGAL_REQUEST, 0x24);   // bad DMA window
+        return;
+    }
+
+    const uint8_t* src = t.cdrom->access(lba * t.block_size, bytes);
+    if (!src) {
+        check_condition(t, SENSE_MEDIUM_ERROR, 0x00);
+        return;
+    }
+
+    uint64_t cost = CMD_CYCLES + bytes * CD_CYCLES_PER_BYTE;
+    if (lba != t.next_lba)
+        cost += SEEK_CYCLES;
+    t.next_lba = lba + count;
+
+    DmaList sg = { { dma_addr, (uint32_t)bytes } };
+    auto done = [this, bytes](bool ok) {
+        done_event = 0;
+        finish_now(ok ? STATUS_GOOD : STATUS_CHECK, ok ? (uint32_t)bytes : 0);
+    };
+    if (!dma->write_after(sg, src, cost, done, &done_event))
+        check_condition(t, SENSE_ILLEGAL_REQUEST, 0x24);
+}
+
+// -----------------------------------------------------------
+// Completion polling on the emulator timeline
+// -----------------------------------------------------------
+void SCSIController::schedule_poll(uint64_t when)
+{
+    if (!sched) {
+        // No timeline (tools): wait for the host right here
+        while (!in_flight.empty()) {
+            poll();
+            if (!in_flight.empty())
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    if (poll_event)
+        sched->cancel(poll_event);
+
+    poll_event = sched->schedule_at(when, [this]() {
+        poll_event = 0;
+        poll();
+    });
+}
+
+void SCSIController::reap_host()
+{
+    reaped.clear();
+    for (Target& t : targets)
+        if (t.backend && t.backend->in_flight())
+            t.backend->reap(reaped);
+
+    for (BlockRequest* r : reaped)
+        ((Command*)r->user)->host_done = true;
+}
+
+// Pinned completion time has come: the guest must see it now,
+// however long the host still takes
+void SCSIController::wait_host(Command* c)
+{
+    while (!c->host_done) {
+        std::this_thread::yield();
+        reap_host();
+    }
+}
+
+void SCSIController::poll()
+{
+    reap_host();
+
+    // Finish (or drop) everything the host is done with and
+    // whose modelled time has come
+    const uint64_t t = now();
+    uint64_t next = 0;
+    for (size_t i = 0; i < in_flight.size();) {
+        Command* c = in_flight[i];
+        if (c->pinned && !c->aborted && c->due <= t)
+            wait_host(c);
+
+        if (c->host_done && (c->aborted || c->due <= t || !sched)) {
+            in_flight.erase(in_flight.begin() + i);
+            if (replay && replay->recording())
+                replay->record_disk(c->issued, c->target,
+                                    (int32_t)std::min<int64_t>(c->req.result, 0), c->aborted);
+            if (replay && replay->replaying() && c->replay_aborted && !c->aborted)
+                replay->diverge("disk command completed that the recording aborted");
+            if (!c->aborted)
+                finish_command(c);
+            delete c;
+            continue;
+        }
+
+        // An aborted command has no deadline: the guest never sees it
+        const bool exact = !c->aborted && (c->host_done || c->pinned);
+        uint64_t when = exact ? c->due : std::max(c->due, t + POLL_CYCLES);
+        if (!next || when < next)
+            next = when;
+        i++;
+    }
+
+    if (next && sched)
+        schedule_poll(next);
+}
+
+void SCSIController::finish_command(Command* c)
+{
+    if (active == c)
+        active = nullptr;
+
+    Target& t = targets[c->target];
+
+    // On replay the guest sees the error it saw when recorded,
+    // whatever the host does this time
+    int64_t error = std::min<int64_t>(c->req.result, 0);
+    if (replay && replay->replaying()) {
+        if (error != c->replay_error)
+            Log::err() << "[SCSI] Target " << c->target << ": host result differs from the "
+                       << "recording, replaying the recorded one\n";
+        error = c->replay_error;
+    }
+
+    if (error < 0) {
+        Log::err() << "[SCSI] Host I/O error on target " << c->target
+                   << ": " << std::strerror((int)-error) << "\n";
+        t.sense_key = SENSE_MEDIUM_ERROR;
+        t.asc = t.ascq = 0;
+        finish_now(STATUS_CHECK, 0);
+        return;
+    }
+
+    if (c->req.op == BlockRequest::Op::Read)
+        dma->write(c->dma_addr, c->buf.data(), c->buf.size());
+
+    t.sense_key = SENSE_NONE;
+    finish_now(STATUS_GOOD, c->req.length);
+}
+
+// -----------------------------------------------------------
+// Bus reset: abandon the active command. The host may still be
+// using its buffer, so it stays in in_flight until reaped.
+// -----------------------------------------------------------
+void SCSIController::bus_reset()
+{
+    if (active) {
+        active->aborted = true;
+        active = nullptr;
+    }
+
+    if (done_event && sched)
+        sched->cancel(done_event);
+    done_event = 0;
+
+    busy        = false;
+    done        = false;
+    no_target   = false;
+    scsi_status = 0;
+    xfer        = 0;
+    update_irq();
+
+    for (Target& t : targets) {
+        t.sense_key = t.asc = t.ascq = 0;
+        t.next_lba  = 0;
+    }
+}
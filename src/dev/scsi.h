@@ -0,0 +1,172 @@
+// -----------------------------------------------------------
+// scsi.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// SCSI host controller + direct-access (disk) targets
+//
+//   - Guest loads target id, a CDB and a DMA window, then
+//     writes GO; completion is a sticky DONE bit + interrupt
+//   - READ / WRITE go to the host image through BlockBackend
+//     asynchronously: the CPU keeps running while the host does
+//     the I/O, and the interrupt is posted at the modelled disk
+//     time (or when the host finishes, if that is later)
+//   - Other commands (INQUIRY, READ CAPACITY, ...) are answered
+//     directly but still complete on the emulator timeline
+//   - CD-ROM targets serve READ from an mmap()ed ISO straight
+//     into guest RAM (see cdrom_image.h)
+//
+// Register block lives at MACE + 0x60000 (see emulator.cpp).
+// The interface is a simple emulator-defined controller, not a
+// model of the Octane's QLogic ISP chip.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "block_backend.h"
+#include "cdrom_image.h"
+
+class Scheduler;
+class DmaEngine;
+class Replay;
+
+class SCSIController {
+public:
+    // Register offsets (relative to the controller block)
+    static constexpr uint32_t REG_TARGET   = 0x00;  // target id (0..6)
+    static constexpr uint32_t REG_CDB0     = 0x04;  // CDB bytes 0..3, byte 0 in bits 31..24
+    static constexpr uint32_t REG_CDB1     = 0x08;
+    static constexpr uint32_t REG_CDB2     = 0x0C;
+    static constexpr uint32_t REG_CDB3     = 0x10;
+    static constexpr uint32_t REG_DMA_ADDR = 0x14;  // guest physical address, low
+    static constexpr uint32_t REG_DMA_HI   = 0x18;  // high
+    static constexpr uint32_t REG_DMA_LEN  = 0x1C;  // bytes available at DMA_ADDR
+    static constexpr uint32_t REG_CMD      = 0x20;  // W: CMD_*
+    static constexpr uint32_t REG_STATUS   = 0x24;  // R: status, W: ack bits
+    static constexpr uint32_t REG_CTRL     = 0x28;  // R/W
+    static constexpr uint32_t REG_XFER     = 0x2C;  // R: bytes transferred
+    static constexpr uint32_t REG_SENSE    = 0x30;  // R: (key << 16) | (asc << 8) | ascq
+    static constexpr uint32_t REG_BLOCK    = 0x100;
+
+    // REG_CMD
+    static constexpr uint32_t CMD_GO    = 1;
+    static constexpr uint32_t CMD_RESET = 2;
+
+    // REG_STATUS bits; SCSI status byte in bits 8..15
+    static constexpr uint32_t ST_BUSY    = 1u << 0;
+    static constexpr uint32_t ST_DONE    = 1u << 1;   // sticky, write 1 to clear
+    static constexpr uint32_t ST_NO_TARGET = 1u << 2; // selection timeout
+
+    // REG_CTRL bits
+    static constexpr uint32_t CTRL_DONE_IRQ = 1u << 0;
+
+    static constexpr uint32_t MAX_TARGETS = 7;        // id 7 is the controller
+    static constexpr uint32_t BLOCK_SIZE  = 512;
+
+    SCSIController();
+    ~SCSIController();
+
+    void attach_scheduler(Scheduler* s) { sched = s; }
+    void attach_dma(DmaEngine* d) { dma = d; }
+    void set_irq_callback(std::function<void(bool)> cb) { irq_cb = std::move(cb); }
+
+    // Deterministic runs (see replay.h). Virtual time completes
+    // disk commands exactly at the modelled time, waiting for the
+    // host if it is slower; a replay log supplies recorded times.
+    void set_virtual_time(bool on) { virtual_time = on; }
+    void attach_replay(Replay* r) { replay = r; }
+
+    // Takes ownership of the backend / image
+    bool attach_disk(uint32_t id, BlockBackend* backend);
+    bool attach_cdrom(uint32_t id, CDROMImage* image);
+
+    // Guest MMIO access (CPU thread only)
+    uint32_t read_reg(uint32_t offset);
+    void     write_reg(uint32_t offset, uint32_t value);
+
+    // Data bytes moved by completed commands since power-on
+    uint64_t bytes_transferred() const { return total_bytes; }
+
+private:
+    struct Target {
+        BlockBackend* backend = nullptr;  // disk
+        CDROMImage*   cdrom   = nullptr;  // or CD-ROM
+        uint32_t      block_size = BLOCK_SIZE;
+        uint64_t      blocks  = 0;
+        uint64_t      next_lba = 0;       // for the seek model
+        uint8_t       sense_key = 0, asc = 0, ascq = 0;
+
+        bool present() const   { return backend || cdrom; }
+        bool read_only() const { return cdrom || backend->read_only(); }
+    };
+
+    // One command in flight on the host. Heap allocated so a bus
+    // reset can abandon it while the host still owns the buffer.
+    struct Command {
+        BlockRequest         req;
+        std::vector<uint8_t> buf;
+        uint32_t target   = 0;
+        uint64_t dma_addr = 0;
+        uint64_t issued   = 0;
+        uint64_t due      = 0;            // modelled completion cycle
+        bool     pinned   = false;        // complete at 'due' exactly
+        bool     host_done = false;
+        bool     aborted   = false;
+        int32_t  replay_error   = 0;      // replay: recorded outcome
+        bool     replay_aborted = false;
+    };
+
+    Target   targets[MAX_TARGETS];
+    Scheduler* sched = nullptr;
+    DmaEngine* dma   = nullptr;
+    Replay*    replay = nullptr;
+    bool       virtual_time = false;
+    std::function<void(bool)> irq_cb;
+
+    // ---- registers
+    uint32_t target_id = 0;
+    uint8_t  cdb[16]   = {};
+    uint64_t dma_addr  = 0;
+    uint32_t dma_len   = 0;
+    uint32_t ctrl      = 0;
+    uint32_t xfer      = 0;
+    uint8_t  scsi_status = 0;
+    bool     busy      = false;
+    bool     done      = false;
+    bool     no_target = false;
+    bool     irq_asserted = false;
+    uint64_t total_bytes  = 0;
+
+    // ---- async I/O
+    Command*              active = nullptr;
+    std::vector<Command*> in_flight;       // includes abandoned commands
+    std::vector<BlockRequest*> reaped;
+    uint64_t poll_event = 0;
+    uint64_t done_event = 0;               // non-I/O command completion
+
+    // Timing model (CPU cycles at 195 MHz)
+    static constexpr uint64_t CMD_CYCLES      = 20000;    // ~100 us command overhead
+    static constexpr uint64_t SEEK_CYCLES     = 1500000;  // ~8 ms seek + rotation
+    static constexpr uint64_t CYCLES_PER_BYTE = 10;       // ~20 MB/s media rate
+    static constexpr uint64_t POLL_CYCLES     = 20000;    // host not done yet: look again
+    static constexpr uint64_t CD_CYCLES_PER_BYTE = 40;    // ~32x drive, ~4.8 MB/s
+
+    uint64_t now() const;
+    void     start();
+    void     start_rw(Target& t, bool write, uint64_t lba, uint32_t count);
+    void     start_cd_read(Target& t, uint64_t lba, uint32_t count);
+    void     issue(Target& t, Command* c, uint64_t cost);
+    void     finish_now(uint8_t status, uint32_t bytes);
+    void     complete_at(uint64_t when, uint8_t status, uint32_t bytes);
+    void     check_condition(Target& t, uint8_t key, uint8_t asc, uint8_t ascq = 0);
+    uint32_t data_in(const uint8_t* data, uint32_t len);
+    void     schedule_poll(uint64_t when);
+    void     poll();
+    void     reap_host();
+    void     wait_host(Command* c);
+    void     finish_command(Command* c);
+    void     bus_reset();
+    void     update_irq();
+};
@@ -6,12 +6,14 @@
 
 #include "sdl_display.h"
 #include "framebuffer.h"
+#include "pixel_convert.h"
+#include "../log.h"
 #include <SDL2/SDL.h>
-#include <iostream>
 
 SDLDisplay::SDLDisplay() {}
 SDLDisplay::~SDLDisplay()
 {
+    if (cursor_tex) SDL_DestroyTexture((SDL_Texture*)cursor_tex);
     if (texture)  SDL_DestroyTexture((SDL_Texture*)texture);
     if (renderer) SDL_DestroyRenderer((SDL_Renderer*)renderer);
     if (window)   SDL_DestroyWindow((SDL_Window*)window);
@@ -24,7 +26,7 @@ SDLDisplay::~SDLDisplay()
 bool SDLDisplay::init(uint32_t w, uint32_t h)
 {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "[SDL] Init failed: " << SDL_GetError() << "\n";
+        Log::err() << "[SDL] Init failed: " << SDL_GetError() << "\n";
         return false;
     }
 
@@ -40,48 +42,256 @@ bool SDLDisplay::init(uint32_t w, uint32_t h)
     );
 
     if (!window) {
-        std::cerr << "[SDL] Window failed: " << SDL_GetError() << "\n";
+        Log::err() << "[SDL] Window failed: " << SDL_GetError() << "\n";
         return false;
     }
 
     renderer = SDL_CreateRenderer((SDL_Window*)window, -1, SDL_RENDERER_ACCELERATED);
     if (!renderer) {
-        std::cerr << "[SDL] Renderer failed: " << SDL_GetError() << "\n";
+        Log::err() << "[SDL] Renderer failed: " << SDL_GetError() << "\n";
         return false;
     }
 
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo((SDL_Renderer*)renderer, &info) == 0) {
+        num_supported = info.num_texture_formats;
+        if (num_supported > 16) num_supported = 16;
+        for (uint32_t i = 0; i < num_supported; i++)
+            supported_formats[i] = info.texture_formats[i];
+    }
+
+    if (!ensure_texture(GuestPixelFormat::ARGB8888))
+        return false;
+
+    Log::out() << "[SDL] Display initialized: " << w << "x" << h
+               << " (" << (tex_native ? "native texture upload"
+                                     : pixel_convert_isa())
+               << ")\n";
+
+    return true;
+}
+
+// -----------------------------------------------------------
+// Update SDL2 texture from emulator framebuffer
+// Only tiles written since the last update are uploaded; an
+// unchanged frame costs one compare and no present.
+// -----------------------------------------------------------
+bool SDLDisplay::update(Framebuffer& fb)
+{
+    bool moved = update_cursor(fb.hw_cursor());
+
+    if (!fb.has_changes(cursor)) {
+        if (!moved)
+            return refresh();
+        render();
+        return true;
+    }
+
+    fb.collect_dirty(cursor, dirty);
+    upload(fb.data(), fb.pitch(), fb.format(), dirty);
+    render();
+    return true;
+}
+
+// -----------------------------------------------------------
+// present() - render-thread path (see display_thread.cpp)
+// -----------------------------------------------------------
+bool SDLDisplay::present(const FrameSnapshot& frame)
+{
+    bool moved = update_cursor(frame.cursor);
+
+    if (!frame.upload.any()) {
+        if (!moved)
+            return refresh();
+        render();
+        return true;
+    }
+
+    upload(frame.pixels.data(), frame.pitch, frame.format, frame.upload);
+    render();
+    return true;
+}
+
+bool SDLDisplay::refresh()
+{
+    if (!need_present)
+        return false;
+
+    render();
+    return true;
+}
+
+// -----------------------------------------------------------
+// Texture format selection
+// -----------------------------------------------------------
+// SDL packed formats name bits of a host uint32_t, so the format
+// whose bytes-in-memory equal the guest's depends on host endianness.
+static uint32_t native_alias_format(GuestPixelFormat fmt)
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    switch (fmt) {
+    case GuestPixelFormat::ARGB8888: return SDL_PIXELFORMAT_ARGB8888;
+    case GuestPixelFormat::XRGB8888: return SDL_PIXELFORMAT_RGB888;
+    case GuestPixelFormat::ABGR8888: return SDL_PIXELFORMAT_ABGR8888;
+    default: break;
+    }
+#else
+    switch (fmt) {
+    case GuestPixelFormat::ARGB8888: return SDL_PIXELFORMAT_BGRA8888;  // AA RR GG BB
+    case GuestPixelFormat::XRGB8888: return SDL_PIXELFORMAT_BGRX8888;  // xx RR GG BB
+    case GuestPixelFormat::ABGR8888: return SDL_PIXELFORMAT_RGBA8888;  // AA BB GG RR
+    default: break;
+    }
+#endif
+    return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+bool SDLDisplay::ensure_texture(GuestPixelFormat fmt, bool* recreated)
+{
+    if (recreated)
+        *recreated = false;
+    if (texture && fmt == tex_guest)
+        return true;
+
+    // Only accept the alias if the renderer takes it without an
+    // internal software conversion
+    uint32_t want   = SDL_PIXELFORMAT_ARGB8888;
+    uint32_t native = native_alias_format(fmt);
+    for (uint32_t i = 0; i < num_supported; i++)
+        if (native != SDL_PIXELFORMAT_UNKNOWN && supported_formats[i] == native)
+            want = native;
+
+    if (texture && want == tex_format) {
+        tex_guest  = fmt;
+        tex_native = (want == native);
+        return true;
+    }
+
+    if (texture)
+        SDL_DestroyTexture((SDL_Texture*)texture);
+
     texture = SDL_CreateTexture(
         (SDL_Renderer*)renderer,
-        SDL_PIXELFORMAT_ARGB8888,
+        want,
         SDL_TEXTUREACCESS_STREAMING,
-        w, h
+        fb_width, fb_height
     );
 
     if (!texture) {
-        std::cerr << "[SDL] Texture failed: " << SDL_GetError() << "\n";
+        Log::err() << "[SDL] Texture failed: " << SDL_GetError() << "\n";
         return false;
     }
 
-    std::cout << "[SDL] Display initialized: " << w << "x" << h << "\n";
-
+    tex_format = want;
+    tex_guest  = fmt;
+    tex_native = (want == native);
+    if (recreated)
+        *recreated = true;
     return true;
 }
 
 // -----------------------------------------------------------
-// Update SDL2 texture from emulator framebuffer
+// upload() - move dirty rects into the texture, one memory pass
+// -----------------------------------------------------------
+//   native: SDL_UpdateTexture straight from guest storage
+//   other : lock the rect and let the SIMD kernels write the
+//           converted pixels directly into texture memory
 // -----------------------------------------------------------
-void SDLDisplay::update(Framebuffer& fb)
+void SDLDisplay::upload(const uint8_t* base, uint32_t pitch, GuestPixelFormat fmt,
+                        const DirtyTiles& tiles)
 {
-    SDL_UpdateTexture(
-        (SDL_Texture*)texture,
-        nullptr,
-        fb.data(),
-        fb_width * 4
-    );
+    const DirtyTiles* todo = &tiles;
+
+    if (fmt != tex_guest) {
+        bool fresh;
+        if (!ensure_texture(fmt, &fresh))
+            return;
+
+        // Fresh texture has no contents: send the whole frame
+        if (fresh) {
+            all_tiles.resize(fb_width, fb_height, Framebuffer::TILE_W, Framebuffer::TILE_H);
+            all_tiles.mark_all();
+            todo = &all_tiles;
+        }
+    }
+
+    const uint32_t bpp = guest_pixel_bytes(fmt);
+
+    todo->for_each_rect([&](uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+        const uint8_t* src = base + (size_t)y * pitch + (size_t)x * bpp;
+        SDL_Rect r = { (int)x, (int)y, (int)w, (int)h };
+
+        if (tex_native) {
+            SDL_UpdateTexture((SDL_Texture*)texture, &r, src, pitch);
+            return;
+        }
+
+        void* dst = nullptr;
+        int   dst_pitch = 0;
+        if (SDL_LockTexture((SDL_Texture*)texture, &r, &dst, &dst_pitch) != 0)
+            return;
+
+        // Locked pitch may be padded; the kernels honour it per row
+        convert_rect(fmt, src, pitch, (uint8_t*)dst, (size_t)dst_pitch, w, h);
 
+        SDL_UnlockTexture((SDL_Texture*)texture);
+    });
+}
+
+// -----------------------------------------------------------
+// Cursor overlay: a 64x64 blended texture drawn over the frame.
+// A move re-presents without touching the framebuffer texture;
+// the image is uploaded (16 KB) only when the guest changed it.
+// Returns true if what is on screen changed.
+// -----------------------------------------------------------
+bool SDLDisplay::update_cursor(const HwCursor& c)
+{
+    bool changed = false;
+
+    if (c.enabled && (!cur_loaded || c.image_gen != cur_gen)) {
+        if (!cursor_tex) {
+            cursor_tex = SDL_CreateTexture((SDL_Renderer*)renderer, SDL_PIXELFORMAT_ARGB8888,
+                                           SDL_TEXTUREACCESS_STREAMING,
+                                           HwCursor::SIZE, HwCursor::SIZE);
+            if (!cursor_tex)
+                return false;
+            SDL_SetTextureBlendMode((SDL_Texture*)cursor_tex, SDL_BLENDMODE_BLEND);
+        }
+
+        SDL_UpdateTexture((SDL_Texture*)cursor_tex, nullptr, c.image, HwCursor::SIZE * 4);
+        cur_gen    = c.image_gen;
+        cur_loaded = true;
+        changed    = true;
+    }
+
+    if (c.enabled != cur_on || (c.enabled && (c.left() != cur_x || c.top() != cur_y)))
+        changed = true;
+
+    cur_on = c.enabled;
+    cur_x  = c.left();
+    cur_y  = c.top();
+    return changed;
+}
+
+void SDLDisplay::render()
+{
     SDL_RenderClear((SDL_Renderer*)renderer);
     SDL_RenderCopy((SDL_Renderer*)renderer, (SDL_Texture*)texture, nullptr, nullptr);
+
+    if (cur_on && cursor_tex) {
+        // Framebuffer texture is stretched over the whole output
+        int out_w = (int)fb_width, out_h = (int)fb_height;
+        SDL_GetRendererOutputSize((SDL_Renderer*)renderer, &out_w, &out_h);
+        const float sx = (float)out_w / fb_width, sy = (float)out_h / fb_height;
+
+        SDL_Rect r = { (int)(cur_x * sx), (int)(cur_y * sy),
+                       (int)(HwCursor::SIZE * sx), (int)(HwCursor::SIZE * sy) };
+        SDL_RenderCopy((SDL_Renderer*)renderer, (SDL_Texture*)cursor_tex, nullptr, &r);
+    }
+
     SDL_RenderPresent((SDL_Renderer*)renderer);
+
+    need_present = false;
 }
 
 // -----------------------------------------------------------
@@ -97,5 +307,13 @@ void SDLDisplay::process_events(bool& quit)
 
         if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
             quit = true;
+
+        // Window contents lost or rescaled: present again even
+        // if the framebuffer itself did not change
+        if (e.type == SDL_WINDOWEVENT &&
+            (e.window.event == SDL_WINDOWEVENT_EXPOSED ||
+             e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
+             e.window.event == SDL_WINDOWEVENT_RESTORED))
+            need_present = true;
     }
 }
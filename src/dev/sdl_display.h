@@ -6,8 +6,8 @@
 
 #pragma once
 #include <cstdint>
-
-class Framebuffer;
+#include "framebuffer.h"
+#include "frame_snapshot.h"
 
 class SDLDisplay {
 public:
@@ -15,14 +15,54 @@ public:
     ~SDLDisplay();
 
     bool init(uint32_t w, uint32_t h);
-    void update(Framebuffer& fb);
+
+    // Upload changed tiles and present. Returns false (and does
+    // nothing) when the framebuffer is unchanged since last call.
+    bool update(Framebuffer& fb);
+
+    // Same, for a frame handed over by DisplayThread
+    bool present(const FrameSnapshot& frame);
+
+    // Re-present the current texture if the window needs it
+    bool refresh();
+
     void process_events(bool& quit);
 
 private:
     void* window = nullptr;   // SDL_Window*
     void* renderer = nullptr; // SDL_Renderer*
     void* texture = nullptr;  // SDL_Texture*
+    void* cursor_tex = nullptr; // SDL_Texture*, 64x64 blended overlay
 
     uint32_t fb_width  = 0;
     uint32_t fb_height = 0;
+
+    Framebuffer::DirtyCursor cursor;
+    DirtyTiles               dirty;
+    DirtyTiles               all_tiles;   // used after texture re-creation
+    bool                     need_present = true;  // window exposed/resized
+
+    // Texture pixel layout. When the renderer accepts a format whose
+    // memory layout equals the guest's, pixels are uploaded straight
+    // from guest storage; otherwise the conversion kernels write into
+    // the locked texture.
+    uint32_t         tex_format = 0;       // SDL_PixelFormatEnum
+    GuestPixelFormat tex_guest  = GuestPixelFormat::ARGB8888;
+    bool             tex_native = false;   // guest bytes == texture bytes
+    uint32_t         supported_formats[16] = {};
+    uint32_t         num_supported = 0;
+
+    // Cursor overlay as last presented
+    bool     cur_on  = false;
+    int32_t  cur_x   = 0;
+    int32_t  cur_y   = 0;
+    uint32_t cur_gen = 0;
+    bool     cur_loaded = false;
+
+    // *recreated: a new (empty) texture was created
+    bool ensure_texture(GuestPixelFormat fmt, bool* recreated = nullptr);
+    bool update_cursor(const HwCursor& c);
+    void upload(const uint8_t* base, uint32_t pitch, GuestPixelFormat fmt,
+                const DirtyTiles& tiles);
+    void render();
 };
@@ -0,0 +1,71 @@
+// -----------------------------------------------------------
+// triple_buffer.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Lock-free triple buffer (one producer, one consumer)
+//
+//   - Producer fills back(), then publish() swaps it with the
+//     shared middle slot. Never waits for the consumer.
+//   - Consumer calls acquire(); if a new frame was published it
+//     swaps the middle slot into front(). Never waits either.
+//   - If the producer publishes twice before the consumer looks,
+//     the older frame is dropped; publish() reports that so the
+//     producer can carry over any per-frame bookkeeping.
+// -----------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    // ---- Producer side
+    T&       back()             { return slots[back_idx]; }
+    uint32_t back_index() const { return back_idx; }
+
+    // Make back() visible to the consumer. Returns true if the
+    // previously published frame was never acquired (it is now
+    // back() again and will be overwritten).
+    bool publish()
+    {
+        uint8_t prev = middle.exchange((uint8_t)(back_idx | FRESH),
+                                       std::memory_order_acq_rel);
+        back_idx = prev & INDEX;
+        return (prev & FRESH) != 0;
+    }
+
+    // ---- Consumer side
+    // Returns true if front() now holds a newer frame
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+
+        uint8_t prev = middle.exchange(front_idx, std::memory_order_acq_rel);
+        front_idx = prev & INDEX;
+        return true;
+    }
+
+    // True if a published frame is waiting to be acquired
+    bool pending() const { return (middle.load(std::memory_order_relaxed) & FRESH) != 0; }
+
+    const T& front() const      { return slots[front_idx]; }
+    uint32_t front_index() const { return front_idx; }
+
+    // Direct slot access for setup (before either side runs)
+    T& slot(uint32_t i) { return slots[i]; }
+
+private:
+    static constexpr uint8_t INDEX = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    T slots[3];
+
+    // Each index is owned by exactly one party at any time
+    alignas(64) uint32_t back_idx  = 0;   // producer only
+    alignas(64) uint32_t front_idx = 1;   // consumer only
+    alignas(64) std::atomic<uint8_t> middle{2};
+};
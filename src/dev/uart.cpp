@@ -0,0 +1,300 @@
+// -----------------------------------------------------------
+// uart.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// MACE serial console: buffered output + timed TX status
+// -----------------------------------------------------------
+
+#include "uart.h"
+#include "../scheduler.h"
+#include "../log.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+UART::UART()
+{
+    ring.reset(new uint8_t[RING_SIZE]);
+}
+
+UART::~UART()
+{
+    stop_io();
+}
+
+// -----------------------------------------------------------
+// open_sink() - choose console destination, start I/O thread
+// -----------------------------------------------------------
+bool UART::open_sink(Sink kind, const std::string& path)
+{
+    stop_io();
+
+    int fd = -1;
+    bool own = true;
+
+    switch (kind)
+    {
+    case Sink::Stdout:
+        fd  = STDOUT_FILENO;
+        own = false;
+        break;
+
+    case Sink::File:
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            Log::err() << "[UART] Cannot open log file " << path
+                       << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        break;
+
+    case Sink::Pty:
+        fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+            Log::err() << "[UART] Cannot allocate pseudo-terminal: "
+                       << std::strerror(errno) << "\n";
+            if (fd >= 0) ::close(fd);
+            return false;
+        }
+        pty_path = ptsname(fd);
+        Log::out() << "[UART] Console on " << pty_path << "\n";
+        break;
+    }
+
+    sink_kind = kind;
+    out_fd    = fd;
+    own_fd    = own;
+
+    // Anything printed so far must precede guest output
+    Log::flush();
+    std::cout.flush();
+
+    running.store(true);
+    io_thread = std::thread(&UART::io_loop, this, Log::context());
+    return true;
+}
+
+// -----------------------------------------------------------
+// stop_io() - drain remaining output and join the I/O thread
+// -----------------------------------------------------------
+void UART::stop_io()
+{
+    if (running.exchange(false)) {
+        io_cv.notify_one();
+        io_thread.join();
+    }
+
+    if (own_fd && out_fd >= 0)
+        ::close(out_fd);
+
+    out_fd = -1;
+    own_fd = false;
+}
+
+// -----------------------------------------------------------
+// push() - producer side of the ring (CPU thread)
+// -----------------------------------------------------------
+void UART::push(uint8_t c)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+
+    // Ring full: host sink is far behind. Wait for room rather
+    // than lose console output (pty sink drops on its own side).
+    while (h - tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        io_cv.notify_one();
+        std::this_thread::yield();
+    }
+
+    ring[h & RING_MASK] = c;
+    head.store(h + 1, std::memory_order_release);
+
+    if (io_sleeping.load(std::memory_order_relaxed))
+        io_cv.notify_one();
+}
+
+// -----------------------------------------------------------
+// I/O thread: write contiguous ring spans with one syscall each
+// -----------------------------------------------------------
+void UART::drain_once()
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+
+    while (t != h)
+    {
+        size_t start = t & RING_MASK;
+        size_t span  = std::min(h - t, RING_SIZE - start);
+
+        ssize_t n = ::write(out_fd, &ring[start], span);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            // No reader on the pty (or sink gone): the bytes fall
+            // off the end of the serial line, as on real hardware.
+            dropped_bytes.fetch_add(span, std::memory_order_relaxed);
+            n = (ssize_t)span;
+        }
+
+        t += (size_t)n;
+        tail.store(t, std::memory_order_release);
+    }
+}
+
+void UART::io_loop(const char* log_name)
+{
+    Log::Context log_ctx(log_name);
+    using namespace std::chrono;
+
+    while (true)
+    {
+        drain_once();
+
+        if (!running.load())
+            break;
+
+        std::unique_lock<std::mutex> lk(io_mtx);
+        io_sleeping.store(true);
+
+        // Re-check after publishing the sleeping flag so a push
+        // that raced with us is not left waiting for the timeout.
+        if (head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed)
+            && running.load())
+        {
+            io_cv.wait_for(lk, milliseconds(5));
+        }
+
+        io_sleeping.store(false);
+    }
+
+    drain_once();
+}
+
+// -----------------------------------------------------------
+// flush() - wait until the I/O thread has written everything
+// -----------------------------------------------------------
+void UART::flush()
+{
+    if (!running.load())
+        return;
+
+    size_t h = head.load(std::memory_order_relaxed);
+    while (tail.load(std::memory_order_acquire) < h) {
+        io_cv.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+// -----------------------------------------------------------
+// Transmitter timing model
+// -----------------------------------------------------------
+// Each character occupies the line for char_cycles. tx_idle_at
+// is when the last queued character finishes shifting out; the
+// FIFO level seen by the guest is derived from it on demand, so
+// no per-cycle work is needed.
+// -----------------------------------------------------------
+uint64_t UART::now() const
+{
+    return sched ? sched->now() : 0;
+}
+
+uint64_t UART::tx_fifo_level() const
+{
+    uint64_t t = now();
+    if (tx_idle_at <= t)
+        return 0;
+
+    return (tx_idle_at - t + char_cycles - 1) / char_cycles;
+}
+
+void UART::set_irq(bool level)
+{
+    if (level == irq_asserted)
+        return;
+
+    irq_asserted = level;
+    if (irq_cb)
+        irq_cb(level);
+}
+
+void UART::schedule_tx_irq()
+{
+    if (!sched || !(ctrl & CTRL_TX_IRQ))
+        return;
+
+    if (irq_event)
+        sched->cancel(irq_event);
+
+    irq_event = sched->schedule_at(tx_idle_at, [this]() {
+        irq_event = 0;
+        set_irq(true);
+    });
+}
+
+// -----------------------------------------------------------
+// Guest register access
+// -----------------------------------------------------------
+uint32_t UART::read_reg(uint32_t offset)
+{
+    switch (offset)
+    {
+    case REG_DATA:
+        // No console input yet → -1 (PROM polls for this)
+        return 0xFFFFFFFF;
+
+    case REG_STATUS:
+    {
+        uint64_t level = tx_fifo_level();
+        uint32_t st = 0;
+        if (level < TX_FIFO_DEPTH) st |= ST_THR_EMPTY;
+        if (level == 0)            st |= ST_TX_IDLE;
+        return st;
+    }
+
+    case REG_CTRL:
+        return ctrl;
+    }
+
+    return 0;
+}
+
+void UART::write_reg(uint32_t offset, uint32_t value)
+{
+    switch (offset)
+    {
+    case REG_DATA:
+    {
+        uint64_t t = now();
+        uint64_t start = (tx_idle_at > t) ? tx_idle_at : t;
+        tx_idle_at = start + char_cycles;
+
+        // Writing THR acknowledges a pending TX interrupt
+        set_irq(false);
+        schedule_tx_irq();
+
+        if (running.load(std::memory_order_relaxed))
+            push((uint8_t)(value & 0xFF));
+        if (tx_tap)
+            tx_tap((uint8_t)(value & 0xFF));
+        return;
+    }
+
+    case REG_CTRL:
+        ctrl = value;
+        if (!(ctrl & CTRL_TX_IRQ)) {
+            if (irq_event && sched) sched->cancel(irq_event);
+            irq_event = 0;
+            set_irq(false);
+        } else if (tx_fifo_level() == 0) {
+            set_irq(true);
+        } else {
+            schedule_tx_irq();
+        }
+        return;
+    }
+}
@@ -0,0 +1,126 @@
+// -----------------------------------------------------------
+// uart.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// MACE serial console (PROM / IRIX console port)
+//
+//   - Guest writes go into a lock-free single-producer ring
+//   - A host I/O thread drains the ring in bulk to stdout,
+//     a log file or a pseudo-terminal
+//   - Transmit-ready status and the TX interrupt are modelled
+//     on the emulator timeline (baud rate), independent of
+//     how fast the host sink actually is
+//
+// Register block lives at MACE + 0x50000 (see emulator.cpp).
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+class Scheduler;
+
+class UART {
+public:
+    // Host side destination for console output
+    enum class Sink {
+        Stdout,
+        File,
+        Pty
+    };
+
+    // Register offsets (relative to the UART block)
+    static constexpr uint32_t REG_DATA   = 0x00;  // W: TX char, R: RX char (-1 = none)
+    static constexpr uint32_t REG_STATUS = 0x08;  // R: line status
+    static constexpr uint32_t REG_CTRL   = 0x10;  // R/W: interrupt enable
+    static constexpr uint32_t REG_BLOCK  = 0x100; // size of register block
+
+    // REG_STATUS bits (16550 LSR layout)
+    static constexpr uint32_t ST_RX_READY = 1u << 0;
+    static constexpr uint32_t ST_THR_EMPTY = 1u << 5;  // room in TX FIFO
+    static constexpr uint32_t ST_TX_IDLE  = 1u << 6;   // FIFO + shifter empty
+
+    // REG_CTRL bits
+    static constexpr uint32_t CTRL_TX_IRQ = 1u << 1;   // IRQ when TX goes idle
+
+    UART();
+    ~UART();
+
+    // Select where console output goes. Starts the I/O thread.
+    // For Sink::Pty the slave device name is printed and kept in pty_name().
+    bool open_sink(Sink kind, const std::string& path = "");
+    const std::string& pty_name() const { return pty_path; }
+
+    void attach_scheduler(Scheduler* s) { sched = s; }
+    void set_irq_callback(std::function<void(bool)> cb) { irq_cb = std::move(cb); }
+
+    // Observe every transmitted byte on the CPU thread (boot
+    // benchmark phase detection); unset costs one test per byte
+    void set_tx_tap(std::function<void(uint8_t)> fn) { tx_tap = std::move(fn); }
+
+    // Emulated line speed (default 9600 8N1 at the CPU clock)
+    void set_char_cycles(uint64_t c) { char_cycles = c ? c : 1; }
+
+    // Guest MMIO access (CPU thread only)
+    uint32_t read_reg(uint32_t offset);
+    void     write_reg(uint32_t offset, uint32_t value);
+
+    // Block until everything queued so far has reached the sink
+    void flush();
+
+    // Bytes queued for the sink since power-on (any thread)
+    uint64_t bytes_sent() const { return head.load(std::memory_order_relaxed); }
+
+    // Bytes dropped because the host sink could not keep up (pty only)
+    uint64_t dropped() const { return dropped_bytes.load(std::memory_order_relaxed); }
+
+private:
+    // ---- SPSC byte ring (producer = CPU thread, consumer = I/O thread)
+    static constexpr size_t RING_SIZE = 1u << 18;   // 256 KB, power of two
+    static constexpr size_t RING_MASK = RING_SIZE - 1;
+
+    std::unique_ptr<uint8_t[]> ring;
+    alignas(64) std::atomic<size_t> head{0};     // written by producer
+    alignas(64) std::atomic<size_t> tail{0};     // written by consumer
+    alignas(64) std::atomic<bool>   io_sleeping{false};
+
+    std::thread             io_thread;
+    std::atomic<bool>       running{false};
+    std::mutex              io_mtx;
+    std::condition_variable io_cv;
+
+    Sink        sink_kind = Sink::Stdout;
+    int         out_fd    = -1;
+    bool        own_fd    = false;
+    std::string pty_path;
+    std::atomic<uint64_t> dropped_bytes{0};
+
+    void push(uint8_t c);
+    void io_loop(const char* log_name);
+    void drain_once();
+    void stop_io();
+
+    // ---- Guest-visible transmitter model
+    static constexpr uint64_t TX_FIFO_DEPTH = 16;
+
+    Scheduler* sched = nullptr;
+    std::function<void(bool)> irq_cb;
+    std::function<void(uint8_t)> tx_tap;
+
+    uint64_t char_cycles  = 20000;  // ~9600 baud at 195 MHz
+    uint64_t tx_idle_at   = 0;      // cycle when FIFO + shifter drain
+    uint64_t irq_event    = 0;      // pending scheduler event (0 = none)
+    uint32_t ctrl         = 0;
+    bool     irq_asserted = false;
+
+    uint64_t now() const;
+    uint64_t tx_fifo_level() const;
+    void     schedule_tx_irq();
+    void     set_irq(bool level);
+};
@@ -0,0 +1,183 @@
+// -----------------------------------------------------------
+// dma.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Scatter-gather DMA between devices and guest RAM
+// -----------------------------------------------------------
+
+#include "dma.h"
+#include "memory.h"
+#include "scheduler.h"
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define RACER_HOST_BIG_ENDIAN 1
+#endif
+
+static inline uint32_t to_be32(uint32_t v)
+{
+#ifdef RACER_HOST_BIG_ENDIAN
+    return v;
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+// -----------------------------------------------------------
+// Validation
+// -----------------------------------------------------------
+bool DmaEngine::check(uint64_t addr, uint64_t len) const
+{
+    return mem && mem->host_range(addr, len) != nullptr;
+}
+
+bool DmaEngine::check(const DmaSegment* sg, size_t n) const
+{
+    for (size_t i = 0; i < n; i++) {
+        if (!check(sg[i].addr, sg[i].len))
+            return false;
+    }
+    return true;
+}
+
+uint64_t DmaEngine::total(const DmaSegment* sg, size_t n)
+{
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < n; i++)
+        bytes += sg[i].len;
+    return bytes;
+}
+
+void DmaEngine::touched(uint64_t addr, uint64_t len)
+{
+    to_guest += len;
+    if (!invalidate || len == 0)
+        return;
+    uint64_t first = addr & ~(PAGE_SIZE - 1);
+    uint64_t end   = (addr + len + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    invalidate(first, end - first);
+}
+
+// -----------------------------------------------------------
+// Immediate copies
+// -----------------------------------------------------------
+bool DmaEngine::write(uint64_t addr, const void* src, uint64_t len)
+{
+    uint8_t* p = mem ? mem->host_range(addr, len) : nullptr;
+    if (!p)
+        return false;
+    std::memcpy(p, src, (size_t)len);
+    touched(addr, len);
+    return true;
+}
+
+bool DmaEngine::read(uint64_t addr, void* dst, uint64_t len)
+{
+    uint8_t* p = mem ? mem->host_range(addr, len) : nullptr;
+    if (!p)
+        return false;
+    std::memcpy(dst, p, (size_t)len);
+    from_guest += len;
+    return true;
+}
+
+bool DmaEngine::write(const DmaSegment* sg, size_t n, const void* src)
+{
+    if (!check(sg, n))
+        return false;
+
+    const uint8_t* s = (const uint8_t*)src;
+    for (size_t i = 0; i < n; i++) {
+        std::memcpy(mem->host_range(sg[i].addr, sg[i].len), s, sg[i].len);
+        touched(sg[i].addr, sg[i].len);
+        s += sg[i].len;
+    }
+    return true;
+}
+
+bool DmaEngine::read(const DmaSegment* sg, size_t n, void* dst)
+{
+    if (!check(sg, n))
+        return false;
+
+    uint8_t* d = (uint8_t*)dst;
+    for (size_t i = 0; i < n; i++) {
+        std::memcpy(d, mem->host_range(sg[i].addr, sg[i].len), sg[i].len);
+        from_guest += sg[i].len;
+        d += sg[i].len;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------
+// Big-endian words
+// -----------------------------------------------------------
+bool DmaEngine::write_be32(uint64_t addr, const uint32_t* words, size_t count)
+{
+    const uint64_t len = (uint64_t)count * 4;
+    uint8_t* p = mem ? mem->host_range(addr, len) : nullptr;
+    if (!p)
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v = to_be32(words[i]);
+        std::memcpy(p + i * 4, &v, 4);
+    }
+    touched(addr, len);
+    return true;
+}
+
+bool DmaEngine::read_be32(uint64_t addr, uint32_t* words, size_t count)
+{
+    const uint64_t len = (uint64_t)count * 4;
+    uint8_t* p = mem ? mem->host_range(addr, len) : nullptr;
+    if (!p)
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t v;
+        std::memcpy(&v, p + i * 4, 4);
+        words[i] = to_be32(v);
+    }
+    from_guest += len;
+    return true;
+}
+
+// -----------------------------------------------------------
+// Timed transfers
+// -----------------------------------------------------------
+void DmaEngine::finish_after(uint64_t cycles, std::function<void()> fn, uint64_t* event)
+{
+    uint64_t id = 0;
+    if (sched)
+        id = sched->schedule(cycles, std::move(fn));
+    else
+        fn();
+    if (event)
+        *event = id;
+}
+
+bool DmaEngine::write_after(const DmaList& sg, const void* src, uint64_t cycles, Done done,
+                            uint64_t* event)
+{
+    if (!check(sg.data(), sg.size()))
+        return false;
+
+    finish_after(cycles, [this, sg, src, done]() {
+        bool ok = write(sg.data(), sg.size(), src);
+        if (done)
+            done(ok);
+    }, event);
+    return true;
+}
+
+bool DmaEngine::read_after(const DmaList& sg, void* dst, uint64_t cycles, Done done,
+                           uint64_t* event)
+{
+    if (!read(sg.data(), sg.size(), dst))
+        return false;
+
+    finish_after(cycles, [done]() {
+        if (done)
+            done(true);
+    }, event);
+    return true;
+}
@@ -0,0 +1,86 @@
+// -----------------------------------------------------------
+// dma.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Bulk transfers between device buffers and guest RAM
+//
+//   - Devices describe a transfer as a scatter-gather list; the
+//     whole list is checked once (each segment inside RAM)
+//     before any byte moves, then each segment is one memcpy
+//   - Guest RAM is kept in guest (big-endian) byte order, so byte
+//     streams copy unchanged on any host; the *_be32 helpers are
+//     for structured data such as descriptors
+//   - Every write to guest RAM is reported, page granular, to an
+//     optional invalidate hook (for caches of decoded guest code)
+//   - Timed transfers complete on the emulator timeline: data
+//     read from the guest is captured at issue, data written to
+//     the guest lands when the transfer completes
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class Memory;
+class Scheduler;
+
+struct DmaSegment {
+    uint64_t addr = 0;      // guest physical
+    uint32_t len  = 0;
+};
+using DmaList = std::vector<DmaSegment>;
+
+class DmaEngine {
+public:
+    static constexpr uint64_t PAGE_SIZE = 4096;
+
+    // [first, first + bytes) of guest RAM was written, page aligned
+    using InvalidateHook = std::function<void(uint64_t first, uint64_t bytes)>;
+    using Done = std::function<void(bool ok)>;
+
+    void attach_memory(Memory* m) { mem = m; }
+    void attach_scheduler(Scheduler* s) { sched = s; }
+    void set_invalidate_hook(InvalidateHook h) { invalidate = std::move(h); }
+
+    // All segments inside guest RAM
+    bool check(const DmaSegment* sg, size_t n) const;
+    bool check(uint64_t addr, uint64_t len) const;
+    static uint64_t total(const DmaSegment* sg, size_t n);
+
+    // Immediate copies; false (nothing moved) if any segment is bad.
+    // 'src' / 'dst' hold total(sg, n) bytes, segments packed in order.
+    bool write(const DmaSegment* sg, size_t n, const void* src);   // device -> guest
+    bool read(const DmaSegment* sg, size_t n, void* dst);          // guest -> device
+    bool write(uint64_t addr, const void* src, uint64_t len);
+    bool read(uint64_t addr, void* dst, uint64_t len);
+
+    // Host-order words to / from big-endian guest memory
+    bool write_be32(uint64_t addr, const uint32_t* words, size_t count);
+    bool read_be32(uint64_t addr, uint32_t* words, size_t count);
+
+    // Timed transfers completing 'cycles' from now. Return false
+    // (and never call done) if the list is bad. The host buffer
+    // must stay valid until done runs. *event receives the
+    // scheduler id, for cancelling on a device reset.
+    bool write_after(const DmaList& sg, const void* src, uint64_t cycles, Done done,
+                     uint64_t* event = nullptr);
+    bool read_after(const DmaList& sg, void* dst, uint64_t cycles, Done done,
+                    uint64_t* event = nullptr);
+
+    // Totals since start, for statistics
+    uint64_t bytes_to_guest() const   { return to_guest; }
+    uint64_t bytes_from_guest() const { return from_guest; }
+
+private:
+    Memory*        mem   = nullptr;
+    Scheduler*     sched = nullptr;
+    InvalidateHook invalidate;
+
+    uint64_t to_guest   = 0;
+    uint64_t from_guest = 0;
+
+    void touched(uint64_t addr, uint64_t len);
+    void finish_after(uint64_t cycles, std::function<void()> fn, uint64_t* event);
+};
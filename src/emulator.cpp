@@ -14,22 +14,89 @@
 #include "mmu.h"
 #include "memory.h"
 #include "cp0.h"
-#include <iostream>
+#include "scheduler.h"
+#include "dma.h"
+#include "sampler.h"
+#include "symbols.h"
+#include "trace.h"
+#include "log.h"
+#include "boot_bench.h"
+#include "perf_counters.h"
+#include "replay.h"
+#include "prom_image.h"
+#include "dev/uart.h"
+#include "dev/scsi.h"
+#include "dev/ethernet.h"
+#include "dev/framebuffer.h"
+#include "dev/display_thread.h"
+#include "dev/headless_display.h"
+#include "dev/fb_shm.h"
+#include "dev/raster2d.h"
+#include "dev/raster3d.h"
+#include <sstream>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+// Bumped by the SIGUSR1 handler; every machine in the process
+// compares it with the count it last saw, on its own clock
+static std::atomic<uint32_t> profile_dump_requests{0};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "used from a signal handler");
+
+static void on_profile_signal(int)
+{
+    profile_dump_requests.fetch_add(1, std::memory_order_relaxed);
+}
 
-Emulator::Emulator()
+Emulator::Emulator(const std::string& name) : machine_name(name)
 {
-    cpu  = new CPU();
-    mmu  = new MMU();
-    cp0  = new CP0();
-    mem  = new Memory();
+    cpu   = new CPU();
+    mmu   = new MMU();
+    cp0   = new CP0();
+    mem   = new Memory();
+    sched = new Scheduler();
+    dma   = new DmaEngine();
+    uart  = new UART();
+    scsi  = new SCSIController();
+    enet  = new Ethernet();
+    symbols = new SymbolTable();
 }
 
 Emulator::~Emulator()
 {
+    if (replay)
+        replay->finish();   // end of the recording is now
+    if (ExecProfile::enabled)
+        print_profile();
+    if (sampler)
+        write_sample_reports();
+    delete sampler;
+    delete symbols;
+    delete tracer;      // flushes a streamed trace
+    if (boot_bench && !boot_bench->finished())
+        boot_bench->write_json(boot_report);     // partial: stopped early
+    delete boot_bench;
+    delete perf;        // unlinks the counter page
+
+    // UART first: its destructor drains pending console output
+    delete uart;
+    delete scsi;        // waits for host I/O still in flight
+    delete enet;        // network backend may log into replay
+    delete replay;
+    delete display;
+    delete headless;
+    delete fb_export;   // hands pixel storage back to fb
+    delete fb;
+    delete dma;
+    delete sched;
     delete cpu;
     delete mmu;
     delete cp0;
     delete mem;
+
+    Log::flush();
 }
 
 // -----------------------------------------------------------
@@ -37,7 +104,7 @@ Emulator::~Emulator()
 // -----------------------------------------------------------
 bool Emulator::init(uint64_t ram_size)
 {
-    std::cout << "[Emu] Initializing system...\n";
+    Log::out() << "[Emu] Initializing system...\n";
 
     // Setup RAM
     mem->init(ram_size);
@@ -51,32 +118,489 @@ bool Emulator::init(uint64_t ram_size)
 
     cp0->attach_cpu(cpu);
 
+    // Console UART: timed on the emulator clock, output drained
+    // by its own I/O thread so the CPU never waits on the terminal
+    uart->attach_scheduler(sched);
+    uart->set_irq_callback([this](bool level) { set_irq(IRQ_UART, level); });
+    if (!uart->open_sink(UART::Sink::Stdout))
+        return false;
+
+    // Device DMA into guest RAM: checked once per segment, then
+    // memcpy; timed completions go on the emulator clock
+    dma->attach_memory(mem);
+    dma->attach_scheduler(sched);
+
+    // SCSI: host I/O runs asynchronously, completions are
+    // delivered on the emulator clock
+    scsi->attach_scheduler(sched);
+    scsi->attach_dma(dma);
+    scsi->set_irq_callback([this](bool level) { set_irq(IRQ_SCSI, level); });
+
+    // Ethernet: descriptor rings in guest RAM, receive polled on
+    // the emulator clock; unplugged until attach_network()
+    enet->attach_scheduler(sched);
+    enet->attach_dma(dma);
+    enet->set_irq_callback([this](bool level) { set_irq(IRQ_ENET, level); });
+
     // Reset all components
+    sched->reset();
     cp0->reset();
     mmu->reset();
     cpu->reset();
 
-    std::cout << "[Emu] System ready.\n";
+    // Profiling builds: SIGUSR1 dumps the counters while running.
+    // The flag is polled from a scheduler event, so run() is not
+    // touched per instruction.
+    if (ExecProfile::enabled) {
+        profile_dumps_seen = profile_dump_requests.load(std::memory_order_relaxed);
+        std::signal(SIGUSR1, on_profile_signal);
+        schedule_profile_poll();
+    }
+
+    Log::out() << "[Emu] System ready.\n";
+    return true;
+}
+
+// -----------------------------------------------------------
+// Attach SI/CRM framebuffer
+// -----------------------------------------------------------
+bool Emulator::attach_framebuffer(uint64_t regs_base, uint64_t fb_phys,
+                                  uint32_t width, uint32_t height)
+{
+    if (!fb)
+        fb = new Framebuffer();
+
+    fb->init(width, height);
+
+    // 2D engine completion is timed on the emulator clock
+    fb->raster().attach_scheduler(sched);
+    fb->raster().set_irq_callback([this](bool level) { set_irq(IRQ_GFX, level); });
+    fb->raster3d().set_irq_callback([this](bool level) { set_irq(IRQ_GFX3D, level); });
+
+    fb_regs_base = regs_base;
+    fb_phys_base = fb_phys;
+    fb_phys_size = fb->size();
+
+    Log::out() << "[Emu] Framebuffer regs @ 0x" << std::hex << regs_base
+               << ", pixels @ 0x" << fb_phys << std::dec << "\n";
+    return true;
+}
+
+// -----------------------------------------------------------
+// Attach a SCSI disk image
+// -----------------------------------------------------------
+bool Emulator::attach_disk(uint32_t id, const std::string& path, bool read_only)
+{
+    BlockBackend* b = BlockBackend::open(path, read_only);
+    if (!b)
+        return false;
+
+    if (!scsi->attach_disk(id, b)) {
+        delete b;
+        return false;
+    }
+    return true;
+}
+
+bool Emulator::attach_cdrom(const std::string& path)
+{
+    CDROMImage* img = new CDROMImage();
+    if (!img->open(path)) {
+        delete img;
+        return false;
+    }
+
+    return scsi->attach_cdrom(4, img);
+}
+
+bool Emulator::attach_network(const std::string& spec)
+{
+    if (replay && replay->replaying()) {
+        Log::out() << "[Emu] Replaying: network input comes from the log, " << spec << " not opened\n";
+        return true;
+    }
+
+    NetBackend* b = NetBackend::open(spec);
+    if (!b)
+        return false;
+
+    if (replay && replay->recording())
+        b = replay->wrap_network(b);
+
+    enet->attach_backend(b);
+    return true;
+}
+
+// -----------------------------------------------------------
+// Display on a render thread, fed at guest VBLANK
+// -----------------------------------------------------------
+bool Emulator::start_display()
+{
+    if (!fb) {
+        Log::err() << "[Emu] start_display: no framebuffer attached\n";
+        return false;
+    }
+
+    if (!display)
+        display = new DisplayThread();
+
+    if (!display->start(fb->width(), fb->height()))
+        return false;
+
+    schedule_vblank();
+    return true;
+}
+
+bool Emulator::start_headless()
+{
+    if (!fb) {
+        Log::err() << "[Emu] start_headless: no framebuffer attached\n";
+        return false;
+    }
+
+    if (!headless)
+        headless = new HeadlessDisplay();
+
+    headless->attach(fb);
+    schedule_vblank();
     return true;
 }
 
+bool Emulator::export_framebuffer(const std::string& name)
+{
+    if (!fb) {
+        Log::err() << "[Emu] export_framebuffer: no framebuffer attached\n";
+        return false;
+    }
+
+    if (!fb_export)
+        fb_export = new FramebufferExport();
+
+    if (!fb_export->open(name, *fb))
+        return false;
+
+    schedule_vblank();
+    return true;
+}
+
+// -----------------------------------------------------------
+// Guest VBLANK: hand the frame to whichever backends exist
+// -----------------------------------------------------------
+void Emulator::schedule_vblank()
+{
+    if (vblank_running)
+        return;
+    vblank_running = true;
+
+    sched->schedule(CPU_HZ / VBLANK_HZ, [this]() {
+        vblank_running = false;
+        vblank_count++;
+
+        if (display) {
+            display->publish(*fb);
+            if (display->quit_requested())
+                request_stop();
+        }
+
+        if (headless)
+            headless->on_vblank(vblank_count);
+
+        if (fb_export)
+            fb_export->publish(*fb, vblank_count);
+
+        schedule_vblank();
+    });
+}
+
 // -----------------------------------------------------------
-// Load PROM (declared in Part 2)
+// Execution profile
 // -----------------------------------------------------------
-bool Emulator::load_prom(const std::string& path);
+void Emulator::print_profile()
+{
+    std::ostringstream report;
+    cpu->exec_profile().report(report);
+    Log::err() << report.str();
+}
+
+// -----------------------------------------------------------
+// Guest PC sampling
+// -----------------------------------------------------------
+bool Emulator::load_symbols(const std::string& path)
+{
+    return symbols->load(path);
+}
+
+void Emulator::start_sampling(const std::string& out_prefix, uint64_t interval_cycles)
+{
+    if (!sampler) {
+        sampler = new GuestSampler();
+        sampler->attach_cpu(cpu);
+        sampler->attach_scheduler(sched);
+    }
+    sample_prefix = out_prefix;
+    sampler->start(interval_cycles);
+}
+
+void Emulator::write_sample_reports()
+{
+    if (!sampler || sample_prefix.empty())
+        return;
+
+    sampler->write_flat(sample_prefix + ".flat", *symbols);
+    sampler->write_folded(sample_prefix + ".folded", *symbols);
+    Log::out() << "[Emu] " << sampler->samples() << " PC samples written to "
+               << sample_prefix << ".{flat,folded}\n";
+}
+
+// -----------------------------------------------------------
+// Binary trace
+// -----------------------------------------------------------
+static bool trace_compiled_in()
+{
+#ifdef RACER_TRACE
+    return true;
+#else
+    Log::err() << "[Emu] Tracing not compiled in (build with -DRACER_TRACE)\n";
+    return false;
+#endif
+}
+
+bool Emulator::start_trace_ring(size_t events, const std::string& crash_path)
+{
+    if (!trace_compiled_in())
+        return false;
+    if (!tracer)
+        tracer = new Tracer();
+    if (!tracer->start_ring(events))
+        return false;
+
+    tracer->install_crash_dump(crash_path);
+    cpu->attach_tracer(tracer);
+    return true;
+}
+
+bool Emulator::start_trace_file(const std::string& path)
+{
+    if (!trace_compiled_in())
+        return false;
+    if (!tracer)
+        tracer = new Tracer();
+    if (!tracer->start_file(path))
+        return false;
+
+    cpu->attach_tracer(tracer);
+    return true;
+}
+
+bool Emulator::dump_trace(const std::string& path)
+{
+    return tracer && tracer->dump(path);
+}
+
+// -----------------------------------------------------------
+// Boot benchmark
+// -----------------------------------------------------------
+bool Emulator::start_boot_bench(const std::string& report_path, const std::string& phases,
+                                uint64_t timeout_s)
+{
+    std::vector<BootBench::Milestone> milestones;
+    if (!BootBench::parse(phases.empty() ? BootBench::DEFAULT_PHASES : phases, milestones))
+        return false;
+
+    if (!boot_bench)
+        boot_bench = new BootBench();
+    boot_bench->attach_cpu(cpu);
+    boot_bench->attach_scheduler(sched);
+    boot_report = report_path;
+
+    uart->set_tx_tap([this](uint8_t c) { boot_bench->on_console(c); });
+
+    return boot_bench->start(milestones, timeout_s * CPU_HZ, [this]() {
+        boot_bench->write_json(boot_report);
+        request_stop();
+    });
+}
+
+// -----------------------------------------------------------
+// Record / replay
+// -----------------------------------------------------------
+bool Emulator::start_recording(const std::string& path)
+{
+    if (!replay) {
+        replay = new Replay();
+        replay->attach_cpu(cpu);
+        replay->attach_scheduler(sched);
+    }
+    if (!replay->start_record(path))
+        return false;
+
+    scsi->attach_replay(replay);
+    return true;
+}
+
+bool Emulator::start_replay(const std::string& path)
+{
+    if (!replay) {
+        replay = new Replay();
+        replay->attach_cpu(cpu);
+        replay->attach_scheduler(sched);
+    }
+    replay->set_stop_callback([this]() { request_stop(); });
+    if (!replay->start_replay(path))
+        return false;
+
+    scsi->attach_replay(replay);
+    if (replay->log_has_network())
+        enet->attach_backend(replay->wrap_network(nullptr));
+    return true;
+}
+
+void Emulator::set_virtual_time(bool on)
+{
+    scsi->set_virtual_time(on);
+}
+
+// -----------------------------------------------------------
+// Live performance counters
+// -----------------------------------------------------------
+bool Emulator::export_counters(const std::string& name)
+{
+    if (!perf)
+        perf = new PerfCounters();
+
+    perf_ev = perf->open(name, CPU_HZ) ? perf->events() : nullptr;
+    cpu->attach_perf(perf_ev);
+    mmu->attach_perf(perf_ev);
+    if (!perf_ev)
+        return false;
+
+    // Hot function table: per-PC window of the guest sampler. If
+    // sampling was not asked for, run it at the default interval;
+    // a later start_sampling() restarts it at its own.
+    if (!sampler)
+        start_sampling("", 0);
+    sampler->enable_window();
+
+    publish_counters();
+    if (!perf_running) {
+        perf_running = true;
+        schedule_perf_publish();
+    }
+    return true;
+}
+
+const PerfShm* Emulator::counters() const
+{
+    return perf ? perf->page() : nullptr;
+}
+
+void Emulator::publish_counters()
+{
+    // Fold the sampler window by function before entering the
+    // seqlock, so readers never wait on symbol lookups
+    std::vector<std::pair<uint64_t, std::string>> hot;
+    uint64_t window = 0;
+    const bool fold = sampler && ++hot_publishes >= PerfCounters::HOT_PUBLISHES;
+    if (fold) {
+        hot_publishes = 0;
+
+        std::unordered_map<uint64_t, uint64_t> pcs;
+        std::unordered_map<std::string, uint64_t> by_function;
+        sampler->take_window(pcs);
+        for (const auto& kv : pcs) {
+            by_function[symbols->function(kv.first)] += kv.second;
+            window += kv.second;
+        }
+        for (const auto& kv : by_function)
+            hot.push_back({ kv.second, kv.first });
+
+        const size_t n = std::min<size_t>(hot.size(), PERF_HOT_FUNCS);
+        std::partial_sort(hot.begin(), hot.begin() + n, hot.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+        hot.resize(n);
+    }
+
+    PerfPublished& p = perf->begin_publish();
+    p.cycles.set(sched->now());
+    p.instructions.set(sched->now());
+    p.vblanks.set(vblank_count);
+    p.frames_presented.set(display ? display->frames_presented() : vblank_count);
+    p.dma_to_guest.set(dma->bytes_to_guest());
+    p.dma_from_guest.set(dma->bytes_from_guest());
+    p.scsi_bytes.set(scsi->bytes_transferred());
+    p.net_tx_bytes.set(enet->bytes_sent());
+    p.net_rx_bytes.set(enet->bytes_received());
+    p.uart_tx_bytes.set(uart->bytes_sent());
+    if (fold) {
+        p.hot_window.set(window);
+        for (uint32_t i = 0; i < PERF_HOT_FUNCS; i++) {
+            const bool used = i < hot.size();
+            p.hot[i].samples.set(used ? hot[i].first : 0);
+            std::snprintf(p.hot[i].name, sizeof(p.hot[i].name), "%s",
+                          used ? hot[i].second.c_str() : "");
+        }
+    }
+    perf->end_publish();
+}
+
+void Emulator::schedule_perf_publish()
+{
+    sched->schedule(PerfCounters::PUBLISH_CYCLES, [this]() {
+        if (perf_ev)
+            publish_counters();
+        schedule_perf_publish();
+    });
+}
+
+void Emulator::schedule_profile_poll()
+{
+    // 10 ms of guest time
+    sched->schedule(CPU_HZ / 100, [this]() {
+        const uint32_t n = profile_dump_requests.load(std::memory_order_relaxed);
+        if (n != profile_dumps_seen) {
+            profile_dumps_seen = n;
+            print_profile();
+        }
+        schedule_profile_poll();
+    });
+}
+
+// -----------------------------------------------------------
+// Load PROM: mapped read-only at PromImage::PHYS_BASE, one copy
+// shared by every machine in the process (see prom_image.h)
+// -----------------------------------------------------------
+bool Emulator::load_prom(const std::string& path)
+{
+    std::shared_ptr<const PromImage> img = PromImage::load(path);
+    if (!img)
+        return false;
+
+    prom      = img;
+    prom_size = img->size();
+    return true;
+}
 
 // -----------------------------------------------------------
 // Main execution loop
 // -----------------------------------------------------------
 void Emulator::run(uint64_t cycles)
 {
-    std::cout << "[Emu] Starting CPU...\n";
+    // The CPU thread: everything posted from here on is this machine's
+    Log::Context log_ctx(log_name());
+    Log::out() << "[Emu] Starting CPU...\n";
+
+    // The CPU may run on another thread than install_crash_dump()
+    if (tracer)
+        Tracer::protect_thread();
 
-    for (uint64_t i = 0; i < cycles; i++)
+    stop_requested.store(false, std::memory_order_relaxed);
+
+    for (uint64_t i = 0; i < cycles && !stop_requested.load(std::memory_order_relaxed); i++)
     {
         cpu->step();
 
-        // For future: handle timers, interrupts, VBLANK, DMA
+        // Timers, device completions, VBLANK: all on the timeline
+        sched->advance(1);
     }
 }
 
@@ -120,11 +644,48 @@ static constexpr uint64_t CRM_BASE   = 0x1F600000;
 
 static constexpr uint64_t MMIO_SIZE  = 0x00200000; // 2MB per region
 
+// MACE sub-blocks
+static constexpr uint32_t MACE_UART_OFF = 0x50000;  // PROM console port
+static constexpr uint32_t MACE_SCSI_OFF = 0x60000;  // SCSI controller
+static constexpr uint32_t MACE_ENET_OFF = 0x70000;  // Ethernet
+
+// HEART interrupt status (one bit per line, see set_irq)
+static constexpr uint32_t HEART_ISR_OFF = 0x0080;
+
+// -----------------------------------------------------------
+// Counter slot for an MMIO address (same decode as below)
+// -----------------------------------------------------------
+uint32_t Emulator::mmio_device(uint64_t phys) const
+{
+    if (phys >= HEART_BASE && phys < HEART_BASE + MMIO_SIZE)
+        return PERF_DEV_HEART;
+    if (phys >= HUB_BASE && phys < HUB_BASE + MMIO_SIZE)
+        return PERF_DEV_HUB;
+    if (phys >= MACE_BASE && phys < MACE_BASE + MMIO_SIZE) {
+        const uint32_t off = (uint32_t)(phys - MACE_BASE);
+        if (off >= MACE_UART_OFF && off < MACE_UART_OFF + UART::REG_BLOCK)
+            return PERF_DEV_UART;
+        if (off >= MACE_SCSI_OFF && off < MACE_SCSI_OFF + SCSIController::REG_BLOCK)
+            return PERF_DEV_SCSI;
+        if (off >= MACE_ENET_OFF && off < MACE_ENET_OFF + Ethernet::REG_BLOCK)
+            return PERF_DEV_ENET;
+        return PERF_DEV_MACE;
+    }
+    if (fb && phys >= fb_regs_base && phys < fb_regs_base + MMIO_SIZE)
+        return PERF_DEV_GFX;
+    if (phys >= CRM_BASE && phys < CRM_BASE + MMIO_SIZE)
+        return PERF_DEV_CRM;
+    return PERF_DEV_UNKNOWN;
+}
+
 // -----------------------------------------------------------
 // MMIO READ32
 // -----------------------------------------------------------
 uint32_t Emulator::mmio_read32(uint64_t phys)
 {
+    if (perf_ev)
+        perf_ev->mmio_reads[mmio_device(phys)].add();
+
     // -----------------------------
     // HEART
     // -----------------------------
@@ -136,6 +697,9 @@ uint32_t Emulator::mmio_read32(uint64_t phys)
         if (off == 0x0000)
             return 0x00010001;  // fake HEART version
 
+        if (off == HEART_ISR_OFF)
+            return (uint32_t)heart_isr;
+
         return 0;
     }
 
@@ -160,10 +724,15 @@ uint32_t Emulator::mmio_read32(uint64_t phys)
     {
         uint32_t off = phys - MACE_BASE;
 
-        // PROM polls this for console input
-        // No input → return -1
-        if (off == 0x50000)
-            return 0xFFFFFFFF;
+        // Console UART (PROM polls data for input, status for TX)
+        if (off >= MACE_UART_OFF && off < MACE_UART_OFF + UART::REG_BLOCK)
+            return uart->read_reg(off - MACE_UART_OFF);
+
+        if (off >= MACE_SCSI_OFF && off < MACE_SCSI_OFF + SCSIController::REG_BLOCK)
+            return scsi->read_reg(off - MACE_SCSI_OFF);
+
+        if (off >= MACE_ENET_OFF && off < MACE_ENET_OFF + Ethernet::REG_BLOCK)
+            return enet->read_reg(off - MACE_ENET_OFF);
 
         return 0;
     }
@@ -171,6 +740,9 @@ uint32_t Emulator::mmio_read32(uint64_t phys)
     // -----------------------------
     // CRM / SI Graphics
     // -----------------------------
+    if (fb && phys >= fb_regs_base && phys < fb_regs_base + MMIO_SIZE)
+        return fb->read_reg((uint32_t)(phys - fb_regs_base));
+
     if (phys >= CRM_BASE && phys < CRM_BASE + MMIO_SIZE)
     {
         uint32_t off = phys - CRM_BASE;
@@ -189,8 +761,8 @@ uint32_t Emulator::mmio_read32(uint64_t phys)
     // -----------------------------
     // Unknown MMIO
     // -----------------------------
-    std::cerr << "[MMIO] Unknown read32 @ 0x"
-              << std::hex << phys << std::dec << "\n";
+    TRACE_MMIO(tracer, false, phys, 0);
+    RLOG_FIRST(MMIO, Warn, 8, "Unknown read32 @ 0x%llx", phys);
 
     return 0;
 }
@@ -200,6 +772,9 @@ uint32_t Emulator::mmio_read32(uint64_t phys)
 // -----------------------------------------------------------
 void Emulator::mmio_write32(uint64_t phys, uint32_t val)
 {
+    if (perf_ev)
+        perf_ev->mmio_writes[mmio_device(phys)].add();
+
     // -----------------------------
     // HEART
     // -----------------------------
@@ -225,11 +800,23 @@ void Emulator::mmio_write32(uint64_t phys, uint32_t val)
     {
         uint32_t off = phys - MACE_BASE;
 
-        // PROM writes serial output characters here:
-        if (off == 0x50000)
+        // PROM writes serial output characters here. The UART
+        // queues them for its I/O thread; nothing blocks here.
+        if (off >= MACE_UART_OFF && off < MACE_UART_OFF + UART::REG_BLOCK)
+        {
+            uart->write_reg(off - MACE_UART_OFF, val);
+            return;
+        }
+
+        if (off >= MACE_SCSI_OFF && off < MACE_SCSI_OFF + SCSIController::REG_BLOCK)
         {
-            char c = (char)(val & 0xFF);
-            std::cout << c; // print PROM output
+            scsi->write_reg(off - MACE_SCSI_OFF, val);
+            return;
+        }
+
+        if (off >= MACE_ENET_OFF && off < MACE_ENET_OFF + Ethernet::REG_BLOCK)
+        {
+            enet->write_reg(off - MACE_ENET_OFF, val);
             return;
         }
 
@@ -239,19 +826,36 @@ void Emulator::mmio_write32(uint64_t phys, uint32_t val)
     // -----------------------------
     // CRM / SI Graphics
     // -----------------------------
+    if (fb && phys >= fb_regs_base && phys < fb_regs_base + MMIO_SIZE)
+    {
+        fb->write_reg((uint32_t)(phys - fb_regs_base), val);
+        return;
+    }
+
     if (phys >= CRM_BASE && phys < CRM_BASE + MMIO_SIZE)
     {
-        // For now, ignore writes — framebuffer handled in Part 3
+        // No framebuffer attached: ignore writes
         return;
     }
 
     // -----------------------------
     // Unknown MMIO
     // -----------------------------
-    std::cerr << "[MMIO] Unknown write32 @ 0x"
-              << std::hex << phys
-              << " = 0x" << val
-              << std::dec << "\n";
+    TRACE_MMIO(tracer, true, phys, val);
+    RLOG_FIRST(MMIO, Warn, 8, "Unknown write32 @ 0x%llx = 0x%llx", phys, val);
+}
+
+// -----------------------------------------------------------
+// Interrupt routing: device lines → HEART ISR → CP0 Cause.IP2
+// -----------------------------------------------------------
+void Emulator::set_irq(uint32_t line, bool level)
+{
+    if (level)
+        heart_isr |= (1ULL << line);
+    else
+        heart_isr &= ~(1ULL << line);
+
+    cp0->set_interrupt_pending(2, heart_isr != 0);
 }
 
 // -----------------------------------------------------------
@@ -259,6 +863,12 @@ void Emulator::mmio_write32(uint64_t phys, uint32_t val)
 // -----------------------------------------------------------
 uint32_t Emulator::sys_read32(uint64_t phys)
 {
+    if (phys - fb_phys_base < fb_phys_size)
+        return fb->fb_read32((uint32_t)(phys - fb_phys_base));
+
+    if (phys - PromImage::PHYS_BASE < prom_size)
+        return prom->read32(phys - PromImage::PHYS_BASE);
+
     if (phys >= HEART_BASE)
         return mmio_read32(phys);
 
@@ -267,7 +877,13 @@ uint32_t Emulator::sys_read32(uint64_t phys)
 
 void Emulator::sys_write32(uint64_t phys, uint32_t val)
 {
-    if (phys >= HEART_BASE)
+    // Framebuffer window: goes through fb_write32 so the
+    // touched tile is marked dirty for the display
+    if (phys - fb_phys_base < fb_phys_size)
+        fb->fb_write32((uint32_t)(phys - fb_phys_base), val);
+    else if (phys - PromImage::PHYS_BASE < prom_size)
+        return;     // PROM is read-only
+    else if (phys >= HEART_BASE)
         mmio_write32(phys, val);
     else
         mem->write32(phys, val);
@@ -6,20 +6,70 @@
 // -----------------------------------------------------------
 
 #pragma once
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
 
 class CPU;
 class MMU;
 class Memory;
 class CP0;
+class Scheduler;
+class DmaEngine;
+class UART;
+class Framebuffer;
+class DisplayThread;
+class HeadlessDisplay;
+class FramebufferExport;
+class SCSIController;
+class Ethernet;
+class GuestSampler;
+class SymbolTable;
+class Tracer;
+class BootBench;
+class Replay;
+class PerfCounters;
+class PromImage;
+struct PerfEvents;
+struct PerfShm;
 
+// HEART interrupt lines used by emulated devices
+enum : uint32_t {
+    IRQ_UART = 0,
+    IRQ_GFX  = 1,
+    IRQ_GFX3D = 2,
+    IRQ_SCSI  = 3,
+    IRQ_ENET  = 4,
+};
+
+// One machine. Several can live in one process, each driven by
+// its own thread: every object an Emulator uses is its own, except
+// read-only assets (the PROM image) and process-wide services that
+// are thread-safe (the log writer, RLOG occurrence counters, the
+// SIGUSR1 profile request). Give each machine a name so its
+// messages read "[name] [SCSI] ..." (see Log::Context): run() sets
+// it on the CPU thread and helper threads (console, display,
+// rasteriser, disk I/O) take the context of the thread that started
+// them, so the thread that sets the machine up and tears it down
+// holds a Log::Context(name) itself. Give it a File console sink
+// (uart_ref().open_sink) rather than sharing stdout. Only one
+// machine per process can own the trace crash dump.
 class Emulator {
 public:
-    Emulator();
+    // Emulated clock: R10000 @ 195 MHz, one instruction per cycle
+    static constexpr uint64_t CPU_HZ     = 195000000;
+    static constexpr uint64_t VBLANK_HZ  = 60;
+
+    explicit Emulator(const std::string& name = std::string());
     ~Emulator();
 
+    const std::string& name() const { return machine_name; }
+
     bool init(uint64_t ram_size);
+
+    // Map the PROM read-only at 0x1FC00000; machines loading the
+    // same file share one copy (see prom_image.h)
     bool load_prom(const std::string& path);
 
     void run(uint64_t cycles);
@@ -32,12 +82,140 @@ public:
     uint32_t mmio_read32(uint64_t phys);
     void     mmio_write32(uint64_t phys, uint32_t val);
 
-    Memory& memory_ref() { return *mem; }
-    CPU&    cpu_ref()    { return *cpu; }
+    // SI/CRM graphics: register block + linear framebuffer window
+    bool attach_framebuffer(uint64_t regs_base, uint64_t fb_phys,
+                            uint32_t width = 1280, uint32_t height = 1024);
+    Framebuffer* framebuffer() { return fb; }
+
+    // Open the display window on its own render thread. Frames are
+    // published at guest VBLANK; the CPU never waits for the host.
+    bool start_display();
+
+    // No window: frame hashing / capture only, nothing per frame
+    // unless capture or a hash watch is configured
+    bool start_headless();
+    HeadlessDisplay* headless_ref() { return headless; }
+
+    // Move framebuffer pixels into POSIX shared memory 'name' so other
+    // processes can map them. Works alongside either display backend.
+    bool export_framebuffer(const std::string& name);
+
+    // Attach a disk image as SCSI target 'id' (0..6). Host I/O is
+    // asynchronous; see dev/scsi.h
+    bool attach_disk(uint32_t id, const std::string& path, bool read_only = false);
+
+    // Attach an ISO image as the SCSI CD-ROM (target 4, as on SGI
+    // systems). The image is mapped read-only.
+    bool attach_cdrom(const std::string& path);
+
+    // Connect the Ethernet to a host backend: pcap:<out>[,<in>],
+    // unix:<path> or tap:<ifname> (see dev/net_backend.h)
+    bool attach_network(const std::string& spec);
+
+    // Ask run() to return at the next instruction boundary
+    // (any thread)
+    void request_stop() { stop_requested.store(true, std::memory_order_relaxed); }
+
+    // Execution profile report (opcode/exception counts); only has
+    // data in builds with -DRACER_PROFILE. Also printed at exit and
+    // on SIGUSR1.
+    void print_profile();
+
+    // Guest PC sampling (see sampler.h). Symbol files are ELF images
+    // or PROM maps; reports go to <prefix>.flat and <prefix>.folded
+    // when the emulator shuts down.
+    bool load_symbols(const std::string& path);
+    void start_sampling(const std::string& out_prefix, uint64_t interval_cycles = 0);
+    void write_sample_reports();
+
+    // Binary instruction trace (builds with -DRACER_TRACE; see
+    // trace.h). Ring mode keeps the last 'events' events and dumps
+    // them to crash_path if the process dies; file mode streams all.
+    bool start_trace_ring(size_t events, const std::string& crash_path);
+    bool start_trace_file(const std::string& path);
+    bool dump_trace(const std::string& path);
+
+    // Boot benchmark (see boot_bench.h): time each phase up to the
+    // milestones in 'phases' (empty = PROM to IRIX login), stop the
+    // run at the last one or after timeout_s of guest time, and write
+    // a JSON report to report_path
+    bool start_boot_bench(const std::string& report_path, const std::string& phases,
+                          uint64_t timeout_s);
+
+    // Deterministic runs (see replay.h). Guest time is always the
+    // instruction count; these pin the host inputs to it. Start
+    // recording or replay before attach_network() and run().
+    bool start_recording(const std::string& path);
+    bool start_replay(const std::string& path);
+    void set_virtual_time(bool on);
+
+    // Live performance counters in POSIX shared memory 'name' (see
+    // perf_counters.h, read with tools/perf_counters_view). Nothing
+    // is counted until this is called. Also starts PC sampling for
+    // the hot function table.
+    bool export_counters(const std::string& name);
+
+    // The exported page, for in-process readers on any thread
+    // (PerfCounters::snapshot); nullptr until export_counters()
+    const PerfShm* counters() const;
+
+    // Interrupt lines into HEART (bit index in HEART ISR)
+    void set_irq(uint32_t line, bool level);
+
+    Memory&    memory_ref()    { return *mem; }
+    CPU&       cpu_ref()       { return *cpu; }
+    Scheduler& scheduler_ref() { return *sched; }
+    DmaEngine& dma_ref()       { return *dma; }
+    UART&      uart_ref()      { return *uart; }
 
 private:
-    CPU*    cpu  = nullptr;
-    MMU*    mmu  = nullptr;
-    CP0*    cp0  = nullptr;
-    Memory* mem  = nullptr;
+    std::string machine_name;
+
+    CPU*       cpu   = nullptr;
+    MMU*       mmu   = nullptr;
+    CP0*       cp0   = nullptr;
+    Memory*    mem   = nullptr;
+    Scheduler* sched = nullptr;
+    DmaEngine* dma   = nullptr;
+    UART*      uart  = nullptr;
+    SCSIController* scsi = nullptr;
+    Ethernet*  enet  = nullptr;
+    GuestSampler* sampler = nullptr;
+    SymbolTable*  symbols = nullptr;
+    std::string   sample_prefix;
+    Tracer*       tracer  = nullptr;
+    BootBench*    boot_bench = nullptr;
+    std::string   boot_report;
+    Replay*       replay  = nullptr;
+    PerfCounters* perf    = nullptr;
+    PerfEvents*   perf_ev = nullptr;    // perf's event block, or nullptr
+    Framebuffer* fb  = nullptr;
+
+    std::shared_ptr<const PromImage> prom;
+    uint64_t prom_size = 0;     // 0 = no PROM mapped
+
+    uint64_t fb_regs_base = 0;
+    uint64_t fb_phys_base = 0;
+    uint64_t fb_phys_size = 0;
+
+    uint64_t heart_isr = 0;   // pending interrupt lines
+
+    DisplayThread*   display  = nullptr;
+    HeadlessDisplay* headless = nullptr;
+    FramebufferExport* fb_export = nullptr;
+    std::atomic<bool> stop_requested{false};
+    bool     vblank_running = false;
+    bool     perf_running   = false;
+    uint32_t hot_publishes  = 0;
+    uint32_t profile_dumps_seen = 0;    // SIGUSR1 requests handled
+    uint64_t vblank_count   = 0;
+
+    // Name for Log::Context, nullptr if unnamed
+    const char* log_name() const { return machine_name.empty() ? nullptr : machine_name.c_str(); }
+
+    void schedule_vblank();
+    void schedule_profile_poll();
+    void schedule_perf_publish();
+    void publish_counters();
+    uint32_t mmio_device(uint64_t phys) const;
 };
@@ -0,0 +1,335 @@
+// -----------------------------------------------------------
+// log.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Asynchronous log writer
+// -----------------------------------------------------------
+
+#include "log.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Log {
+
+std::atomic<uint8_t> levels[(int)LogSys::COUNT] = {
+    { (uint8_t)LogLevel::Info }, { (uint8_t)LogLevel::Info }, { (uint8_t)LogLevel::Info },
+    { (uint8_t)LogLevel::Info }, { (uint8_t)LogLevel::Info }, { (uint8_t)LogLevel::Info },
+    { (uint8_t)LogLevel::Info },
+};
+
+static const char* const SYS_TAG[(int)LogSys::COUNT] = {
+    "CPU", "CP0", "MMU", "MEM", "MMIO", "Emu", "DEV",
+};
+
+static const char* const SYS_NAME[(int)LogSys::COUNT] = {
+    "cpu", "cp0", "mmu", "mem", "mmio", "emu", "dev",
+};
+
+static const char* const LEVEL_NAME[] = {
+    "trace", "debug", "info", "warn", "error", "off",
+};
+
+namespace {
+
+// RLOG record (fmt set) or a preformatted Line (fmt null)
+struct Record {
+    const char* fmt;
+    const char* ctx;
+    uint64_t    args[4];
+    uint64_t    repeat;
+    int         nargs;
+    int         fd;
+    LogSys      sys;
+    LogLevel    level;
+    std::string text;
+};
+
+thread_local const char* current_ctx = nullptr;
+
+// Producers append under the lock; the writer swaps the whole
+// batch out and formats it without holding the lock
+class Writer {
+public:
+    static constexpr size_t MAX_PENDING = 65536;
+
+    ~Writer()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (!started)
+                return;
+            stopping = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    void post(Record&& r)
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!started) {
+            started = true;
+            thread = std::thread(&Writer::loop, this);
+        }
+        if (pending.size() >= MAX_PENDING) {
+            dropped++;
+            return;
+        }
+        pending.push_back(std::move(r));
+        posted++;
+        lk.unlock();
+        cv.notify_one();
+    }
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        const uint64_t target = posted;
+        cv.notify_one();
+        done_cv.wait(lk, [&] { return !started || written >= target; });
+    }
+
+private:
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    std::thread             thread;
+    std::vector<Record>     pending;
+    bool     started  = false;
+    bool     stopping = false;
+    uint64_t posted   = 0;
+    uint64_t written  = 0;
+    uint64_t dropped  = 0;
+
+    // Writer thread only: whether stdout / stderr are at the start
+    // of a line (where a context prefix goes)
+    bool line_start[2] = { true, true };
+
+    void loop()
+    {
+        std::vector<Record> batch;
+        std::string out, err;
+
+        for (;;) {
+            uint64_t lost;
+            bool last;
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv.wait(lk, [&] { return stopping || !pending.empty(); });
+                batch.swap(pending);
+                lost = dropped;
+                dropped = 0;
+                last = stopping;
+            }
+
+            out.clear();
+            err.clear();
+            for (const Record& r : batch) {
+                if (r.fmt)
+                    format(r, err);
+                else
+                    append(r, r.fd == 1 ? out : err, line_start[r.fd == 1 ? 0 : 1]);
+            }
+            if (lost)
+                err += "[LOG] " + std::to_string(lost) + " messages dropped (writer behind)\n";
+            write_all(stdout, out);
+            write_all(stderr, err);
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                written += batch.size();
+            }
+            done_cv.notify_all();
+            batch.clear();
+
+            if (last)
+                return;
+        }
+    }
+
+    static void format(const Record& r, std::string& out)
+    {
+        char msg[512];
+        const unsigned long long* a = (const unsigned long long*)r.args;
+        switch (r.nargs) {
+        case 0:  std::snprintf(msg, sizeof(msg), "%s", r.fmt); break;
+        case 1:  std::snprintf(msg, sizeof(msg), r.fmt, a[0]); break;
+        case 2:  std::snprintf(msg, sizeof(msg), r.fmt, a[0], a[1]); break;
+        case 3:  std::snprintf(msg, sizeof(msg), r.fmt, a[0], a[1], a[2]); break;
+        default: std::snprintf(msg, sizeof(msg), r.fmt, a[0], a[1], a[2], a[3]); break;
+        }
+
+        if (r.ctx && *r.ctx) {
+            out += '[';
+            out += r.ctx;
+            out += "] ";
+        }
+        out += '[';
+        out += SYS_TAG[(int)r.sys];
+        out += "] ";
+        if (r.level == LogLevel::Warn)
+            out += "Warning: ";
+        else if (r.level == LogLevel::Error)
+            out += "ERROR: ";
+        out += msg;
+        if (r.repeat)
+            out += " (" + std::to_string(r.repeat) + " times so far)";
+        out += '\n';
+    }
+
+    // Line text as given, with the context prefix at each line start
+    static void append(const Record& r, std::string& out, bool& at_start)
+    {
+        const bool prefix = r.ctx && *r.ctx;
+        for (char ch : r.text) {
+            if (at_start && prefix) {
+                out += '[';
+                out += r.ctx;
+                out += "] ";
+            }
+            out += ch;
+            at_start = ch == '\n';
+        }
+    }
+
+    // Through stdio, so the text stays in order with what the host
+    // program prints itself
+    static void write_all(FILE* f, const std::string& s)
+    {
+        if (s.empty())
+            return;
+        std::fwrite(s.data(), 1, s.size(), f);
+        std::fflush(f);
+    }
+};
+
+Writer& writer()
+{
+    static Writer w;
+    return w;
+}
+
+} // namespace
+
+void post_raw(LogSys s, LogLevel l, uint64_t repeat, const char* fmt,
+              int nargs, const uint64_t* args)
+{
+    Record r;
+    r.fmt    = fmt;
+    r.ctx    = current_ctx;
+    r.repeat = repeat;
+    r.nargs  = nargs;
+    r.fd     = 2;
+    r.sys    = s;
+    r.level  = l;
+    for (int i = 0; i < 4; i++)
+        r.args[i] = i < nargs ? args[i] : 0;
+    writer().post(std::move(r));
+}
+
+void post_text(int fd, std::string text)
+{
+    if (text.empty())
+        return;
+
+    Record r = {};
+    r.ctx  = current_ctx;
+    r.fd   = fd;
+    r.text = std::move(text);
+    writer().post(std::move(r));
+}
+
+Line::~Line()
+{
+    post_text(fd, s.str());
+}
+
+Context::Context(const char* name) : prev(current_ctx)
+{
+    current_ctx = name;
+}
+
+Context::~Context()
+{
+    current_ctx = prev;
+}
+
+const char* context()
+{
+    return current_ctx;
+}
+
+void flush()
+{
+    writer().flush();
+}
+
+void set_level(LogSys s, LogLevel l)
+{
+    levels[(int)s].store((uint8_t)l, std::memory_order_relaxed);
+}
+
+static bool parse_level(const std::string& name, LogLevel& out)
+{
+    for (int i = 0; i <= (int)LogLevel::Off; i++) {
+        if (name == LEVEL_NAME[i]) {
+            out = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool configure(const char* spec)
+{
+    if (!spec)
+        return true;
+
+    bool ok = true;
+    std::string all = spec;
+    size_t pos = 0;
+    while (pos <= all.size()) {
+        size_t end = all.find(',', pos);
+        if (end == std::string::npos)
+            end = all.size();
+        const std::string item = all.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty())
+            continue;
+
+        const size_t eq = item.find('=');
+        LogLevel lvl;
+        if (eq == std::string::npos) {
+            if (!parse_level(item, lvl)) {
+                ok = false;
+                continue;
+            }
+            for (int i = 0; i < (int)LogSys::COUNT; i++)
+                set_level((LogSys)i, lvl);
+            continue;
+        }
+
+        const std::string sys = item.substr(0, eq);
+        bool found = false;
+        if (parse_level(item.substr(eq + 1), lvl)) {
+            for (int i = 0; i < (int)LogSys::COUNT; i++) {
+                if (sys == SYS_NAME[i]) {
+                    set_level((LogSys)i, lvl);
+                    found = true;
+                }
+            }
+        }
+        ok = ok && found;
+    }
+
+    if (!ok)
+        std::fprintf(stderr, "[LOG] Could not parse all of RACER_LOG=%s\n", spec);
+    return ok;
+}
+
+} // namespace Log
@@ -0,0 +1,177 @@
+// -----------------------------------------------------------
+// log.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Diagnostic logging for paths the guest can hit in a loop
+//
+//   - Per-subsystem runtime levels (RACER_LOG="cp0=debug,mmio=off")
+//   - Messages below RACER_LOG_MIN_LEVEL are compiled out
+//   - RLOG_FIRST: first N occurrences of a call site, then only
+//     the 2N-th, 4N-th, ... with the running count
+//   - The caller only stores the format pointer and up to four
+//     integer arguments; formatting and the write to stderr
+//     happen on a background thread
+//
+//   RLOG_FIRST(MMIO, Warn, 8, "Unknown read32 @ 0x%llx", phys);
+//
+// Formats must be string literals and take every argument as
+// a 64-bit integer (%llx, %llu, %lld).
+//
+// Messages from the objects of one machine (setup, status,
+// reports) go through Log::out() / Log::err() rather than
+// std::cout / std::cerr:
+//
+//   Log::out() << "[SCSI] Target " << id << ": " << blocks << " blocks\n";
+//
+// The line is formatted on the caller's thread and written to
+// stdout / stderr by the same background thread, in order with
+// everything else posted. While a Log::Context is active on a
+// thread, everything it posts is prefixed "[name] ", so several
+// machines in one process can be told apart.
+// -----------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+enum class LogLevel : uint8_t { Trace, Debug, Info, Warn, Error, Off };
+
+enum class LogSys : uint8_t { CPU, CP0, MMU, MEM, MMIO, EMU, DEV, COUNT };
+
+// Trace is compiled out unless the build lowers this
+#ifndef RACER_LOG_MIN_LEVEL
+#define RACER_LOG_MIN_LEVEL 1
+#endif
+
+namespace Log {
+
+extern std::atomic<uint8_t> levels[(int)LogSys::COUNT];
+
+inline bool enabled(LogSys s, LogLevel l)
+{
+    return (uint8_t)l >= levels[(int)s].load(std::memory_order_relaxed);
+}
+
+void set_level(LogSys s, LogLevel l);
+
+// "info" sets every subsystem, "cp0=debug,mmio=off" individual ones
+bool configure(const char* spec);
+
+// Wait until everything posted so far has been written
+void flush();
+
+// Machine name for messages posted on this thread while in scope
+// (nullptr or "" = no prefix). Nests. The name must stay valid
+// until flush() after its last message.
+class Context {
+public:
+    explicit Context(const char* name);
+    ~Context();
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+private:
+    const char* prev;
+};
+
+// Current machine name on this thread, nullptr if none
+const char* context();
+
+// One message for stdout (fd 1) or stderr (fd 2), posted when the
+// statement ends. Stream state (std::hex, ...) is per message.
+class Line {
+public:
+    explicit Line(int fd) : fd(fd) {}
+    ~Line();
+
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+    template <typename T>
+    Line& operator<<(const T& v)
+    {
+        s << v;
+        return *this;
+    }
+
+    Line& operator<<(std::ostream& (*manip)(std::ostream&))
+    {
+        manip(s);
+        return *this;
+    }
+
+private:
+    int                fd;
+    std::ostringstream s;
+};
+
+inline Line out() { return Line(1); }
+inline Line err() { return Line(2); }
+
+void post_text(int fd, std::string text);
+
+// Occurrence counter for one call site
+struct Site {
+    std::atomic<uint64_t> hits{0};
+
+    // Occurrence number (1-based). A plain load/store rather than
+    // a locked add: concurrent hits may be undercounted, which is
+    // fine for deciding what to print.
+    inline uint64_t hit()
+    {
+        const uint64_t n = hits.load(std::memory_order_relaxed) + 1;
+        hits.store(n, std::memory_order_relaxed);
+        return n;
+    }
+
+    // Whether occurrence n gets printed
+    static inline bool due(uint64_t n, uint64_t first)
+    {
+        return n <= first || ((n & (n - 1)) == 0 && n >= 2 * first);
+    }
+};
+
+template <typename T>
+inline uint64_t arg(T v)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                  "log arguments are integers; format strings on the caller side");
+    return (uint64_t)v;
+}
+
+// 'repeat' is the occurrence number for RLOG_FIRST, 0 otherwise
+void post_raw(LogSys s, LogLevel l, uint64_t repeat, const char* fmt,
+              int nargs, const uint64_t* args);
+
+template <typename... A>
+inline void post(LogSys s, LogLevel l, uint64_t repeat, const char* fmt, A... a)
+{
+    static_assert(sizeof...(A) <= 4, "at most four log arguments");
+    const uint64_t v[sizeof...(A) + 1] = { arg(a)..., 0 };
+    post_raw(s, l, repeat, fmt, (int)sizeof...(A), v);
+}
+
+} // namespace Log
+
+#define RLOG(sys, lvl, ...)                                                    \
+    do {                                                                       \
+        if ((int)LogLevel::lvl >= RACER_LOG_MIN_LEVEL &&                       \
+            Log::enabled(LogSys::sys, LogLevel::lvl))                          \
+            Log::post(LogSys::sys, LogLevel::lvl, 0, __VA_ARGS__);             \
+    } while (0)
+
+#define RLOG_FIRST(sys, lvl, n, ...)                                           \
+    do {                                                                       \
+        if ((int)LogLevel::lvl >= RACER_LOG_MIN_LEVEL &&                       \
+            Log::enabled(LogSys::sys, LogLevel::lvl)) {                        \
+            static Log::Site rlog_site_;                                       \
+            const uint64_t rlog_n_ = rlog_site_.hit();                         \
+            if (Log::Site::due(rlog_n_, (n)))                                  \
+                Log::post(LogSys::sys, LogLevel::lvl,                          \
+                          rlog_n_ > (uint64_t)(n) ? rlog_n_ : 0, __VA_ARGS__); \
+        }                                                                      \
+    } while (0)
@@ -4,33 +4,138 @@
 #include <iomanip>
 #include <cstdint>
 #include <string>
+#include <cstdlib>
 #include "emulator.h"
+#include "dev/headless_display.h"
+#include "log.h"
 #include <iostream>
 
 int emulator_main(const std::string &prom_path, const std::string &irix_iso_path) {
+    // RACER_LOG=<level> or <subsystem>=<level>,... (trace, debug,
+    // info, warn, error, off; subsystems cpu cp0 mmu mem mmio emu dev)
+    Log::configure(std::getenv("RACER_LOG"));
+
     try {
         Emulator emu;
         emu.init();
 
         // Attach a framebuffer device so user sees display (optional).
-        // Choose MMIO base and framebuffer physical base consistent with dev/framebuffer defaults.
-        const uint64_t fb_mmio = 0x1F000000ULL;
+        // Register block sits in the CRM window (0x1F000000 is HEART).
+        const uint64_t fb_mmio = 0x1F600000ULL;
         const uint64_t fb_phys = 0x10000000ULL;
         emu.attach_framebuffer(fb_mmio, fb_phys);
 
+        // Window runs on its own render thread. Without a display (or with
+        // RACER_HEADLESS set) run headless; RACER_CAPTURE_DIR and
+        // RACER_CAPTURE_EVERY (VBLANKs) enable periodic PNG capture.
+        const char* boot_bench = std::getenv("RACER_BOOT_BENCH");
+        bool headless = std::getenv("RACER_HEADLESS") != nullptr || boot_bench;
+        if (!headless && !emu.start_display()) {
+            std::cerr << "[MAIN] No display available, continuing headless\n";
+            headless = true;
+        }
+        if (headless && emu.start_headless()) {
+            const char* dir   = std::getenv("RACER_CAPTURE_DIR");
+            const char* every = std::getenv("RACER_CAPTURE_EVERY");
+            if (dir && every)
+                emu.headless_ref()->set_periodic_capture(
+                    dir, (uint32_t)std::strtoul(every, nullptr, 10),
+                    HeadlessDisplay::ImageFormat::PNG);
+        }
+
+        // RACER_FB_SHM=/name exports the framebuffer for external viewers
+        // (see tools/fb_shm_view.cpp)
+        if (const char* shm = std::getenv("RACER_FB_SHM"))
+            emu.export_framebuffer(shm);
+
+        // Deterministic runs: RACER_RECORD=<log> records every host
+        // input against the instruction count, RACER_REPLAY=<log> feeds
+        // them back and stops at the recorded end. RACER_VIRTUAL_TIME=1
+        // pins disk completions to modelled time (see replay.h).
+        if (std::getenv("RACER_VIRTUAL_TIME"))
+            emu.set_virtual_time(true);
+        if (const char* log = std::getenv("RACER_REPLAY")) {
+            if (!emu.start_replay(log))
+                return 2;
+        } else if (const char* log = std::getenv("RACER_RECORD")) {
+            if (!emu.start_recording(log))
+                return 2;
+        }
+
+        // RACER_COUNTERS_SHM=/name exports live performance counters
+        // (see tools/perf_counters_view.cpp)
+        if (const char* shm = std::getenv("RACER_COUNTERS_SHM"))
+            emu.export_counters(shm);
+
+        // RACER_DISK=<image> attaches a hard disk as SCSI target 1
+        // (raw image, or a copy-on-write overlay from tools/cow_tool)
+        if (const char* disk = std::getenv("RACER_DISK")) {
+            if (!emu.attach_disk(1, disk))
+                std::cerr << "[MAIN] Could not attach disk: " << disk << "\n";
+        }
+
+        // RACER_NET=<spec> plugs in the Ethernet (see dev/net_backend.h)
+        if (const char* net = std::getenv("RACER_NET")) {
+            if (!emu.attach_network(net))
+                std::cerr << "[MAIN] Could not attach network: " << net << "\n";
+        }
+
         // Load PROM
         if (!emu.load_prom(prom_path)) {
             std::cerr << "[MAIN] Failed to load PROM: " << prom_path << "\n";
             return 2;
         }
 
-        // Optionally, if an IRIX ISO path was provided, register it as a virtual CD-ROM.
-        // This requires SCSI/CD emulation not included here; provide hook for later:
+        // IRIX installation ISO: SCSI CD-ROM at target 4
         if (!irix_iso_path.empty()) {
             std::cout << "[MAIN] IRIX ISO provided: " << irix_iso_path << "\n";
-            // Hook point: emu.attach_cdrom(irix_iso_path) or mount ISO into disk subsystem.
-            // If you implemented load_disk_image to accept ISO, call it:
-            // emu.load_disk_image(irix_iso_path);
+            if (!emu.attach_cdrom(irix_iso_path))
+                std::cerr << "[MAIN] Could not attach CD-ROM image\n";
+        }
+
+        // RACER_SAMPLE=<prefix> samples the guest PC (every
+        // RACER_SAMPLE_EVERY cycles) and writes <prefix>.flat and
+        // <prefix>.folded at exit, symbolised with RACER_SYMBOLS
+        // (colon-separated ELF files or PROM symbol maps)
+        if (const char* prefix = std::getenv("RACER_SAMPLE")) {
+            if (const char* list = std::getenv("RACER_SYMBOLS")) {
+                std::string files = list;
+                size_t pos = 0;
+                while (pos <= files.size()) {
+                    size_t end = files.find(':', pos);
+                    if (end == std::string::npos)
+                        end = files.size();
+                    if (end > pos)
+                        emu.load_symbols(files.substr(pos, end - pos));
+                    pos = end + 1;
+                }
+            }
+            const char* every = std::getenv("RACER_SAMPLE_EVERY");
+            emu.start_sampling(prefix, every ? std::strtoull(every, nullptr, 10) : 0);
+        }
+
+        // Binary trace (-DRACER_TRACE builds): RACER_TRACE_RING=<events>
+        // keeps the last N events and writes them to RACER_TRACE_CRASH
+        // (default racer-crash.trace) on a crash; RACER_TRACE_FILE=<path>
+        // streams everything. Decode with tools/trace_dump.
+        if (const char* path = std::getenv("RACER_TRACE_FILE")) {
+            emu.start_trace_file(path);
+        } else if (const char* ring = std::getenv("RACER_TRACE_RING")) {
+            const char* crash = std::getenv("RACER_TRACE_CRASH");
+            emu.start_trace_ring(std::strtoull(ring, nullptr, 10),
+                                 crash ? crash : "racer-crash.trace");
+        }
+
+        // RACER_BOOT_BENCH=<report.json> times the boot phase by phase
+        // (headless) and stops at the last milestone. RACER_BOOT_PHASES
+        // overrides the milestones (see boot_bench.h), RACER_BOOT_TIMEOUT
+        // the guest-time limit in seconds (default 300).
+        if (boot_bench) {
+            const char* phases  = std::getenv("RACER_BOOT_PHASES");
+            const char* timeout = std::getenv("RACER_BOOT_TIMEOUT");
+            if (!emu.start_boot_bench(boot_bench, phases ? phases : "",
+                                      timeout ? std::strtoull(timeout, nullptr, 10) : 300))
+                return 2;
         }
 
         // Reset CPU & start running
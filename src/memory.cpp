@@ -6,7 +6,7 @@
 // -----------------------------------------------------------
 
 #include "memory.h"
-#include <iostream>
+#include "log.h"
 
 // -----------------------------------------------------------
 // Constructor / Destructor
@@ -21,8 +21,8 @@ void Memory::init(uint64_t size_bytes) {
     ram.resize(size_bytes);
     std::memset(ram.data(), 0, ram.size());
 
-    std::cout << "[MEM] RAM initialized: " << size_bytes / (1024*1024)
-              << " MB\n";
+    Log::out() << "[MEM] RAM initialized: " << size_bytes / (1024*1024)
+               << " MB\n";
 }
 
 // -----------------------------------------------------------
@@ -93,6 +93,14 @@ void Memory::load_blob(uint64_t phys, const void* data, size_t size) {
     std::memcpy(&ram[phys], p, size);
 }
 
+// -----------------------------------------------------------
+// read_blob()
+// -----------------------------------------------------------
+void Memory::read_blob(uint64_t phys, void* out, size_t size) {
+    check_bounds(phys, size);
+    std::memcpy(out, &ram[phys], size);
+}
+
 // -----------------------------------------------------------
 // clear_region()
 // -----------------------------------------------------------
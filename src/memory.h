@@ -35,6 +35,17 @@ public:
     // Load binary blob directly into RAM (PROM, ROM, etc.)
     void load_blob(uint64_t phys, const void* data, size_t size);
 
+    // Copy RAM out to a host buffer (device DMA reads)
+    void read_blob(uint64_t phys, void* out, size_t size);
+
+    // Host pointer to [phys, phys + size) after one bounds check,
+    // or nullptr if the range is not all RAM (see dma.h)
+    uint8_t* host_range(uint64_t phys, uint64_t size) {
+        if (phys > ram.size() || size > ram.size() - phys)
+            return nullptr;
+        return ram.data() + phys;
+    }
+
     // Clear region of RAM
     void clear_region(uint64_t phys, uint64_t size);
 
@@ -8,7 +8,8 @@
 #include "mmu.h"
 #include "memory.h"
 #include "cp0.h"
-#include <iostream>
+#include "perf_counters.h"
+#include "log.h"
 
 // -----------------------------------------------------------
 // Constructor / Destructor
@@ -28,7 +29,7 @@ void MMU::attach_cp0(CP0* c)       { cp0 = c; }
 void MMU::reset() {
     enable_tlb = false;
     for (auto& e : tlb) e.valid = false;
-    std::cout << "[MMU] Reset — flat mode enabled\n";
+    Log::out() << "[MMU] Reset — flat mode enabled\n";
 }
 
 // -----------------------------------------------------------
@@ -47,9 +48,14 @@ uint64_t MMU::translate(uint64_t vaddr) {
 // -----------------------------------------------------------
 uint64_t MMU::tlb_translate(uint64_t vaddr) {
     for (const auto& e : tlb) {
-        if (e.valid && ((vaddr >> 12) == e.vpn2))
+        if (e.valid && ((vaddr >> 12) == e.vpn2)) {
+            if (perf)
+                perf->tlb_hits.add();
             return (e.pfn << 12) | (vaddr & 0xFFF);
+        }
     }
+    if (perf)
+        perf->tlb_misses.add();
     throw std::runtime_error("[MMU] TLB miss at 0x" + std::to_string(vaddr));
 }
 
@@ -13,6 +13,7 @@
 // Forward declarations
 class Memory;
 class CP0;
+struct PerfEvents;
 
 // Simple TLB entry (placeholder for future full MIPS64)
 struct TLBEntry {
@@ -43,10 +44,17 @@ public:
     void set_tlb_enabled(bool en) { enable_tlb = en; }
     bool is_tlb_enabled() const { return enable_tlb; }
 
+    // Install an entry directly (host side: tests, benchmarks)
+    void write_tlb(int index, const TLBEntry& e) { tlb[index & (MAX_TLB - 1)] = e; }
+
+    // Live TLB hit/miss counters (see perf_counters.h); nullptr = off
+    void attach_perf(PerfEvents* p) { perf = p; }
+
 private:
     Memory* mem = nullptr;
     CP0*    cp0 = nullptr;
     bool    enable_tlb = false;
+    PerfEvents* perf = nullptr;
 
     // Simple 64-entry table for later full implementation
     static constexpr int MAX_TLB = 64;
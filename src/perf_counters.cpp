@@ -0,0 +1,116 @@
+// -----------------------------------------------------------
+// perf_counters.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Shared-memory performance counters (writer side)
+// -----------------------------------------------------------
+
+#include "perf_counters.h"
+#include "log.h"
+#include <cstring>
+#include <new>
+#include <ctime>
+#include <unistd.h>
+
+PerfCounters::PerfCounters() {}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+uint64_t PerfCounters::monotonic_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+bool PerfCounters::open(const std::string& name, uint64_t cpu_hz)
+{
+    close();
+
+    if (!seg.create(name, 4096, "PERF"))
+        return false;
+
+    shm = new (seg.data()) PerfShm();
+    shm->magic      = PERF_SHM_MAGIC;
+    shm->version    = PERF_SHM_VERSION;
+    shm->writer_pid = (uint32_t)getpid();
+    shm->cpu_hz     = cpu_hz;
+    shm->start_ns   = monotonic_ns();
+    shm->pub.host_ns.set(shm->start_ns);
+    shm->sequence.store(0, std::memory_order_release);
+
+    Log::out() << "[PERF] Counters exported as " << name << "\n";
+    return true;
+}
+
+void PerfCounters::close()
+{
+    seg.close();
+    shm = nullptr;
+}
+
+// -----------------------------------------------------------
+// Seqlock: odd while the published block is being updated
+// -----------------------------------------------------------
+PerfPublished& PerfCounters::begin_publish()
+{
+    const uint64_t seq = shm->sequence.load(std::memory_order_relaxed);
+    shm->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return shm->pub;
+}
+
+void PerfCounters::end_publish()
+{
+    shm->pub.host_ns.set(monotonic_ns());
+    const uint64_t seq = shm->sequence.load(std::memory_order_relaxed);
+    shm->sequence.store(seq + 1, std::memory_order_release);
+}
+
+// -----------------------------------------------------------
+// Reader side
+// -----------------------------------------------------------
+void PerfCounters::snapshot(const PerfShm* p, PerfSnapshot& s)
+{
+    for (;;) {
+        const uint64_t seq = p->sequence.load(std::memory_order_acquire);
+        if (seq & 1)
+            continue;
+
+        const PerfPublished& b = p->pub;
+        s.host_ns      = b.host_ns.get();
+        s.cycles       = b.cycles.get();
+        s.instructions = b.instructions.get();
+        s.vblanks      = b.vblanks.get();
+        s.frames       = b.frames_presented.get();
+        s.dma_to       = b.dma_to_guest.get();
+        s.dma_from     = b.dma_from_guest.get();
+        s.scsi         = b.scsi_bytes.get();
+        s.net_tx       = b.net_tx_bytes.get();
+        s.net_rx       = b.net_rx_bytes.get();
+        s.uart_tx      = b.uart_tx_bytes.get();
+        s.hot_window   = b.hot_window.get();
+        for (uint32_t i = 0; i < PERF_HOT_FUNCS; i++) {
+            s.hot_samples[i] = b.hot[i].samples.get();
+            std::memcpy(s.hot_name[i], b.hot[i].name, sizeof(s.hot_name[i]));
+            s.hot_name[i][sizeof(s.hot_name[i]) - 1] = 0;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (p->sequence.load(std::memory_order_relaxed) == seq)
+            break;
+    }
+
+    // Event counters are independent of each other
+    for (int i = 0; i < 32; i++)
+        s.exc[i] = p->ev.exceptions[i].get();
+    s.tlb_hits   = p->ev.tlb_hits.get();
+    s.tlb_misses = p->ev.tlb_misses.get();
+    for (uint32_t d = 0; d < PERF_DEV_COUNT; d++) {
+        s.mmio_r[d] = p->ev.mmio_reads[d].get();
+        s.mmio_w[d] = p->ev.mmio_writes[d].get();
+    }
+}
@@ -0,0 +1,169 @@
+// -----------------------------------------------------------
+// perf_counters.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Live performance counters in POSIX shared memory
+//
+//   - One page: a header, a block published periodically by the
+//     emulator thread, and a block of event counters. Every
+//     counter has exactly one writing thread, which bumps it with
+//     a relaxed load + store (no locked add), so counting costs
+//     about as much as a plain increment
+//   - Event counters are hooked on paths that are already slow:
+//     exceptions, TLB lookups and MMIO accesses
+//   - Cycles, frames and I/O bytes that the devices count anyway
+//     are copied into the published block every PUBLISH_CYCLES
+//     by a scheduler event; 'sequence' is a seqlock over that
+//     block, so a reader gets cycles and the host timestamp as a
+//     consistent pair and can derive MIPS from two snapshots
+//   - The published block also carries the hottest guest
+//     functions of the last HOT_PUBLISHES publishes, from the PC
+//     sampler (see sampler.h)
+//   - Nothing is hooked or counted until the page is opened
+//
+// Readers (tools/perf_counters_view.cpp) map the page read-only.
+// -----------------------------------------------------------
+
+#pragma once
+#include "shm_segment.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+static constexpr uint32_t PERF_SHM_MAGIC   = 0x52504331;   // "RPC1"
+static constexpr uint32_t PERF_SHM_VERSION = 2;
+static constexpr uint32_t PERF_HOT_FUNCS   = 8;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "counters are shared with other processes");
+
+// MMIO regions, in the order mmio_read32/write32 decode them
+enum PerfDevice : uint32_t {
+    PERF_DEV_HEART,
+    PERF_DEV_HUB,
+    PERF_DEV_UART,
+    PERF_DEV_SCSI,
+    PERF_DEV_ENET,
+    PERF_DEV_MACE,          // rest of MACE
+    PERF_DEV_GFX,           // framebuffer register block
+    PERF_DEV_CRM,           // CRM window without a framebuffer
+    PERF_DEV_UNKNOWN,
+    PERF_DEV_COUNT
+};
+
+inline const char* perf_device_name(uint32_t d)
+{
+    static const char* const NAMES[PERF_DEV_COUNT] = {
+        "heart", "hub", "uart", "scsi", "enet", "mace", "gfx", "crm", "unknown",
+    };
+    return d < PERF_DEV_COUNT ? NAMES[d] : "?";
+}
+
+// Counter with a single writing thread
+struct PerfCounter {
+    std::atomic<uint64_t> v{0};
+
+    inline void add(uint64_t n = 1)
+    {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    inline void set(uint64_t n) { v.store(n, std::memory_order_relaxed); }
+    inline uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+// One line of the hot function table
+struct PerfHot {
+    PerfCounter samples;
+    char        name[56];           // NUL terminated, truncated
+};
+
+// Emulator thread, under the seqlock, every PUBLISH_CYCLES
+struct alignas(64) PerfPublished {
+    PerfCounter host_ns;            // CLOCK_MONOTONIC at publish
+    PerfCounter cycles;             // guest clock
+    PerfCounter instructions;       // one per cycle
+    PerfCounter vblanks;
+    PerfCounter frames_presented;   // by the display thread
+    PerfCounter dma_to_guest;       // bytes, all devices
+    PerfCounter dma_from_guest;
+    PerfCounter scsi_bytes;         // disk + CD-ROM data phases
+    PerfCounter net_tx_bytes;
+    PerfCounter net_rx_bytes;
+    PerfCounter uart_tx_bytes;      // console output
+    PerfCounter hot_window;         // samples behind hot[]
+    PerfHot     hot[PERF_HOT_FUNCS];    // hottest first, samples 0 = unused
+};
+
+// Emulator thread, counted as events happen
+struct alignas(64) PerfEvents {
+    PerfCounter exceptions[32];     // by Cause.ExcCode
+    PerfCounter tlb_hits;
+    PerfCounter tlb_misses;
+    PerfCounter mmio_reads[PERF_DEV_COUNT];
+    PerfCounter mmio_writes[PERF_DEV_COUNT];
+};
+
+struct PerfShm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t writer_pid;
+    uint32_t reserved0;
+    uint64_t cpu_hz;
+    uint64_t start_ns;              // CLOCK_MONOTONIC at open
+
+    std::atomic<uint64_t> sequence; // seqlock over 'pub', publish count * 2
+
+    PerfPublished pub;
+    PerfEvents    ev;
+};
+
+static_assert(sizeof(PerfShm) <= 4096, "PerfShm must fit in one page");
+
+// Plain copy of a page, for readers
+struct PerfSnapshot {
+    uint64_t host_ns, cycles, instructions, vblanks, frames;
+    uint64_t dma_to, dma_from, scsi, net_tx, net_rx, uart_tx;
+    uint64_t hot_window;
+    uint64_t hot_samples[PERF_HOT_FUNCS];
+    char     hot_name[PERF_HOT_FUNCS][56];
+    uint64_t exc[32];
+    uint64_t tlb_hits, tlb_misses;
+    uint64_t mmio_r[PERF_DEV_COUNT], mmio_w[PERF_DEV_COUNT];
+};
+
+class PerfCounters {
+public:
+    static constexpr uint64_t PUBLISH_CYCLES = 1950000;  // 10 ms at 195 MHz
+    static constexpr uint32_t HOT_PUBLISHES  = 10;       // hot table: last 100 ms
+
+    PerfCounters();
+    ~PerfCounters();
+
+    // Create /dev/shm/<name> (name must start with '/'); fails if
+    // the name is in use
+    bool open(const std::string& name, uint64_t cpu_hz);
+    void close();
+
+    // Event block for the hooks; nullptr until open()
+    PerfEvents* events() { return shm ? &shm->ev : nullptr; }
+
+    // The page itself (in-process readers); nullptr until open()
+    const PerfShm* page() const { return shm; }
+
+    // Emulator thread: fill the block between begin and end
+    PerfPublished& begin_publish();
+    void           end_publish();
+
+    const std::string& name() const { return seg.name(); }
+
+    static uint64_t monotonic_ns();
+
+    // Any thread or process: consistent copy of the published
+    // block (retries while the writer is inside it), plus the
+    // event counters as they are
+    static void snapshot(const PerfShm* p, PerfSnapshot& s);
+
+private:
+    ShmSegment seg;
+    PerfShm*   shm = nullptr;
+};
@@ -0,0 +1,192 @@
+// -----------------------------------------------------------
+// profile.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Execution profile counters and report
+// -----------------------------------------------------------
+
+#include "profile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// SPECIAL: funct (bits 5..0), REGIMM: rt (20..16), COP0: rs (25..21)
+const ExecProfile::SubSel ExecProfile::SUB[64] = {
+    { SPECIAL_BASE, 0, 0x3F }, { REGIMM_BASE, 16, 0x1F },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { COP0_BASE, 21, 0x1F },                                   // 0x10 COP0
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+    { NO_SUB, 0, 0 }, { NO_SUB, 0, 0 },
+};
+
+// -----------------------------------------------------------
+// Mnemonics for the report ("" = reserved encoding)
+// -----------------------------------------------------------
+static const char* const MAIN_NAMES[64] = {
+    "SPECIAL", "REGIMM", "J",     "JAL",   "BEQ",   "BNE",   "BLEZ",  "BGTZ",
+    "ADDI",    "ADDIU",  "SLTI",  "SLTIU", "ANDI",  "ORI",   "XORI",  "LUI",
+    "COP0",    "COP1",   "COP2",  "COP1X", "BEQL",  "BNEL",  "BLEZL", "BGTZL",
+    "DADDI",   "DADDIU", "LDL",   "LDR",   "",      "",      "",      "",
+    "LB",      "LH",     "LWL",   "LW",    "LBU",   "LHU",   "LWR",   "LWU",
+    "SB",      "SH",     "SWL",   "SW",    "SDL",   "SDR",   "SWR",   "CACHE",
+    "LL",      "LWC1",   "LWC2",  "PREF",  "LLD",   "LDC1",  "LDC2",  "LD",
+    "SC",      "SWC1",   "SWC2",  "",      "SCD",   "SDC1",  "SDC2",  "SD",
+};
+
+static const char* const SPECIAL_NAMES[64] = {
+    "SLL",  "MOVCI", "SRL",  "SRA",  "SLLV",    "",       "SRLV",   "SRAV",
+    "JR",   "JALR",  "MOVZ", "MOVN", "SYSCALL", "BREAK",  "",       "SYNC",
+    "MFHI", "MTHI",  "MFLO", "MTLO", "DSLLV",   "",       "DSRLV",  "DSRAV",
+    "MULT", "MULTU", "DIV",  "DIVU", "DMULT",   "DMULTU", "DDIV",   "DDIVU",
+    "ADD",  "ADDU",  "SUB",  "SUBU", "AND",     "OR",     "XOR",    "NOR",
+    "",     "",      "SLT",  "SLTU", "DADD",    "DADDU",  "DSUB",   "DSUBU",
+    "TGE",  "TGEU",  "TLT",  "TLTU", "TEQ",     "",       "TNE",    "",
+    "DSLL", "",      "DSRL", "DSRA", "DSLL32",  "",       "DSRL32", "DSRA32",
+};
+
+static const char* const REGIMM_NAMES[32] = {
+    "BLTZ",   "BGEZ",   "BLTZL",   "BGEZL",   "", "", "",     "",
+    "TGEI",   "TGEIU",  "TLTI",    "TLTIU",   "TEQI", "", "TNEI", "",
+    "BLTZAL", "BGEZAL", "BLTZALL", "BGEZALL", "", "", "",     "",
+    "",       "",       "",        "",        "", "", "",     "",
+};
+
+static const char* const COP0_NAMES[32] = {
+    "MFC0", "DMFC0", "", "", "MTC0", "DMTC0", "", "",
+    "",     "",      "", "", "",     "",      "", "",
+    "C0",   "C0",    "C0", "C0", "C0", "C0", "C0", "C0",   // TLB ops, ERET
+    "C0",   "C0",    "C0", "C0", "C0", "C0", "C0", "C0",
+};
+
+static const char* const EXC_NAMES[32] = {
+    "Int",  "Mod",  "TLBL", "TLBS", "AdEL", "AdES", "IBE",  "DBE",
+    "Sys",  "Bp",   "RI",   "CpU",  "Ov",   "Tr",   "VCEI", "FPE",
+    "",     "",     "",     "",     "",     "",     "",     "WATCH",
+    "",     "",     "",     "",     "",     "",     "",     "VCED",
+};
+
+static std::string slot_name(uint32_t slot)
+{
+    const char* n;
+    char buf[32];
+    if (slot < ExecProfile::SPECIAL_BASE)      n = MAIN_NAMES[slot];
+    else if (slot < ExecProfile::REGIMM_BASE)  n = SPECIAL_NAMES[slot - ExecProfile::SPECIAL_BASE];
+    else if (slot < ExecProfile::COP0_BASE)    n = REGIMM_NAMES[slot - ExecProfile::REGIMM_BASE];
+    else                                       n = COP0_NAMES[slot - ExecProfile::COP0_BASE];
+
+    if (slot >= ExecProfile::COP0_BASE && std::strcmp(n, "C0") == 0) {
+        std::snprintf(buf, sizeof(buf), "C0.rs%02x", slot - ExecProfile::COP0_BASE);
+        return buf;
+    }
+    if (*n)
+        return n;
+
+    if (slot < ExecProfile::SPECIAL_BASE)
+        std::snprintf(buf, sizeof(buf), "op%02x", slot);
+    else if (slot < ExecProfile::REGIMM_BASE)
+        std::snprintf(buf, sizeof(buf), "SPECIAL.%02x", slot - ExecProfile::SPECIAL_BASE);
+    else if (slot < ExecProfile::COP0_BASE)
+        std::snprintf(buf, sizeof(buf), "REGIMM.%02x", slot - ExecProfile::REGIMM_BASE);
+    else
+        std::snprintf(buf, sizeof(buf), "COP0.%02x", slot - ExecProfile::COP0_BASE);
+    return buf;
+}
+
+// -----------------------------------------------------------
+// Counters
+// -----------------------------------------------------------
+void ExecProfile::reset()
+{
+    std::memset(main_count, 0, sizeof(main_count));
+    std::memset(sub_count, 0, sizeof(sub_count));
+    std::memset(exceptions, 0, sizeof(exceptions));
+    std::memset(unimp, 0, sizeof(unimp));
+}
+
+uint64_t ExecProfile::instructions() const
+{
+    uint64_t n = 0;
+    for (uint64_t c : main_count)
+        n += c;
+    return n;
+}
+
+// -----------------------------------------------------------
+// report() - handlers by count, unimplemented encodings that
+// were hit, exceptions by cause
+// -----------------------------------------------------------
+void ExecProfile::report(std::ostream& os) const
+{
+    if (!enabled) {
+        os << "[PROF] Profiling not compiled in (build with -DRACER_PROFILE)\n";
+        return;
+    }
+
+    const uint64_t total = instructions();
+    char line[160];
+
+    os << "[PROF] ---- execution profile: " << total << " instructions ----\n";
+    if (!total)
+        return;
+
+    // Leaf handlers: primary opcodes without a sub-table, plus
+    // every sub-table entry
+    std::vector<uint32_t> slots;
+    for (uint32_t op = 0; op < 64; op++)
+        if (SUB[op].base == NO_SUB && main_count[op])
+            slots.push_back(op);
+    for (uint32_t s = SPECIAL_BASE; s < NO_SUB; s++)
+        if (sub_count[s])
+            slots.push_back(s);
+    std::sort(slots.begin(), slots.end(), [this](uint32_t a, uint32_t b) {
+        return handler_count(a) > handler_count(b);
+    });
+
+    os << "[PROF]   handler             count    share    cumul     unimpl\n";
+    double cumul = 0;
+    for (uint32_t s : slots) {
+        const uint64_t n = handler_count(s);
+        const double share = 100.0 * n / total;
+        cumul += share;
+        std::snprintf(line, sizeof(line), "[PROF]   %-10s %14llu  %6.2f%%  %6.2f%%  %9llu\n",
+                      slot_name(s).c_str(), (unsigned long long)n, share, cumul,
+                      (unsigned long long)unimp[s]);
+        os << line;
+    }
+
+    uint64_t unimp_total = 0;
+    for (uint64_t c : unimp)
+        unimp_total += c;
+    std::snprintf(line, sizeof(line), "[PROF] Unimplemented (instr_UNIMP): %llu (%.2f%% of executed)\n",
+                  (unsigned long long)unimp_total, 100.0 * unimp_total / total);
+    os << line;
+
+    uint64_t exc_total = 0;
+    for (uint64_t c : exceptions)
+        exc_total += c;
+    if (exc_total) {
+        os << "[PROF] Exceptions by cause:\n";
+        for (int i = 0; i < 32; i++) {
+            if (!exceptions[i])
+                continue;
+            std::snprintf(line, sizeof(line), "[PROF]   %2d %-6s %14llu\n", i,
+                          EXC_NAMES[i][0] ? EXC_NAMES[i] : "?", (unsigned long long)exceptions[i]);
+            os << line;
+        }
+    }
+}
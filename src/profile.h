@@ -0,0 +1,96 @@
+// -----------------------------------------------------------
+// profile.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Guest execution profile: what the CPU dispatch actually runs
+//
+//   - One counter per handler slot: primary opcode, SPECIAL
+//     funct, REGIMM rt and COP0 rs (the fields OPC_MAIN,
+//     OPC_SPECIAL, OPC_REGIMM and the COP0 handler decode on)
+//   - Exceptions by Cause.ExcCode, and instructions that fell
+//     through to instr_UNIMP
+//   - Counting is branch free (table driven) and only compiled
+//     in with -DRACER_PROFILE; otherwise the PROFILE_* hooks
+//     expand to nothing
+//
+// The report is printed when the emulator exits and whenever
+// the process gets SIGUSR1 (see Emulator::init).
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+class ExecProfile {
+public:
+#ifdef RACER_PROFILE
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // Counter layout: [0, 64) primary opcode, then the sub-tables
+    static constexpr uint32_t SPECIAL_BASE = 64;
+    static constexpr uint32_t REGIMM_BASE  = 128;
+    static constexpr uint32_t COP0_BASE    = 160;
+    static constexpr uint32_t NO_SUB       = 192;   // sink for ops without a sub-table
+    static constexpr uint32_t SLOTS        = 193;
+
+    ExecProfile() { reset(); }
+
+    void reset();
+
+    inline void count(uint32_t ins)
+    {
+        const uint32_t op = ins >> 26;
+        main_count[op]++;
+        sub_count[sub_slot(ins)]++;
+    }
+
+    inline void count_exception(int code) { exceptions[code & 31]++; }
+    inline void count_unimp(uint32_t ins) { unimp[handler_slot(ins)]++; }
+
+    uint64_t instructions() const;
+
+    void report(std::ostream& os) const;
+
+private:
+    uint64_t main_count[64];
+    uint64_t sub_count[SLOTS];      // only SPECIAL_BASE.. are meaningful
+    uint64_t exceptions[32];
+    uint64_t unimp[SLOTS];          // by handler slot
+
+    // Per primary opcode: where its sub-table starts and which
+    // instruction field selects the entry
+    struct SubSel { uint16_t base; uint8_t shift; uint8_t mask; };
+    static const SubSel SUB[64];
+
+    static inline uint32_t sub_slot(uint32_t ins)
+    {
+        const SubSel& s = SUB[ins >> 26];
+        return s.base + ((ins >> s.shift) & s.mask);
+    }
+
+    // Handler that ran: the sub-table entry if there is one,
+    // else the primary opcode
+    static inline uint32_t handler_slot(uint32_t ins)
+    {
+        const uint32_t s = sub_slot(ins);
+        return s == NO_SUB ? (ins >> 26) : s;
+    }
+
+    uint64_t handler_count(uint32_t slot) const
+    {
+        return slot < SPECIAL_BASE ? main_count[slot] : sub_count[slot];
+    }
+};
+
+#ifdef RACER_PROFILE
+#define PROFILE_INSN(p, ins)    (p).count(ins)
+#define PROFILE_EXC(p, code)    (p).count_exception(code)
+#define PROFILE_UNIMP(p, ins)   (p).count_unimp(ins)
+#else
+#define PROFILE_INSN(p, ins)    ((void)0)
+#define PROFILE_EXC(p, code)    ((void)0)
+#define PROFILE_UNIMP(p, ins)   ((void)0)
+#endif
@@ -0,0 +1,89 @@
+// -----------------------------------------------------------
+// prom_image.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Shared read-only PROM image
+// -----------------------------------------------------------
+
+#include "prom_image.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// Same file as far as the kernel is concerned, and unchanged
+typedef std::tuple<uint64_t, uint64_t, uint64_t, int64_t, int64_t> FileKey;
+
+std::mutex                                      cache_mtx;
+std::map<FileKey, std::weak_ptr<const PromImage>> cache;
+
+} // namespace
+
+PromImage::~PromImage()
+{
+    if (map)
+        munmap((void*)map, map_size);
+}
+
+std::shared_ptr<const PromImage> PromImage::load(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Log::err() << "[PROM] Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        Log::err() << "[PROM] Empty or unreadable image: " << path << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+    if ((uint64_t)st.st_size > MAX_SIZE) {
+        Log::err() << "[PROM] " << path << " is " << st.st_size << " bytes, the PROM window is "
+                   << MAX_SIZE << "\n";
+        ::close(fd);
+        return nullptr;
+    }
+
+    const FileKey key((uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size,
+                      (int64_t)st.st_mtim.tv_sec, (int64_t)st.st_mtim.tv_nsec);
+
+    std::lock_guard<std::mutex> lk(cache_mtx);
+
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        if (std::shared_ptr<const PromImage> shared = it->second.lock()) {
+            ::close(fd);
+            return shared;
+        }
+    }
+
+    void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);    // the mapping keeps the file referenced
+    if (m == MAP_FAILED) {
+        Log::err() << "[PROM] mmap " << path << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+
+    std::shared_ptr<PromImage> img(new PromImage());
+    img->image_path = path;
+    img->map        = (const uint8_t*)m;
+    img->map_size   = (uint64_t)st.st_size;
+
+    // Drop entries whose last machine has gone
+    for (auto e = cache.begin(); e != cache.end();)
+        e = e->second.expired() ? cache.erase(e) : std::next(e);
+    cache[key] = img;
+
+    Log::out() << "[PROM] " << path << ": " << img->map_size / 1024 << " KB, mapped read-only\n";
+    return img;
+}
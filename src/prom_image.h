@@ -0,0 +1,52 @@
+// -----------------------------------------------------------
+// prom_image.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Read-only PROM image, shared by every machine in the process
+//
+//   - The file is mmap()ed read-only once; load() of the same
+//     file (same device, inode, size and mtime) hands out the
+//     image already mapped, so dozens of machines cost one copy
+//     and the page cache shares it with other processes too
+//   - The image lives as long as a machine holds it; the cache
+//     only keeps weak references
+//   - Nothing in it changes after load(), so any thread may read
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class PromImage {
+public:
+    // Physical window of the IP30 PROM (KSEG1 0xBFC00000)
+    static constexpr uint64_t PHYS_BASE = 0x1FC00000;
+    static constexpr uint64_t MAX_SIZE  = 0x00400000;   // 4 MB window
+
+    ~PromImage();
+
+    // Shared image of 'path', nullptr on error
+    static std::shared_ptr<const PromImage> load(const std::string& path);
+
+    uint64_t size() const { return map_size; }
+    const uint8_t* data() const { return map; }
+    const std::string& path() const { return image_path; }
+
+    // Big-endian word at 'offset' (as Memory::read32), 0 past the end
+    uint32_t read32(uint64_t offset) const
+    {
+        if (offset > map_size || map_size - offset < 4)
+            return 0;
+        const uint8_t* p = map + offset;
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+               ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+    }
+
+private:
+    PromImage() {}
+
+    std::string    image_path;
+    const uint8_t* map      = nullptr;
+    uint64_t       map_size = 0;
+};
@@ -0,0 +1,367 @@
+// -----------------------------------------------------------
+// replay.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Deterministic record / replay of host inputs
+// -----------------------------------------------------------
+
+#include "replay.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "dev/net_backend.h"
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+
+static const char REPLAY_MAGIC[8] = { 'R', 'A', 'C', 'E', 'R', 'R', 'P', 'L' };
+
+// The largest payload is a received frame
+static const uint32_t MAX_PAYLOAD = NetBackend::MAX_FRAME;
+
+// -----------------------------------------------------------
+// Network backend between the Ethernet and the host (record)
+// or standing in for the host (replay)
+// -----------------------------------------------------------
+class ReplayNetBackend : public NetBackend {
+public:
+    ReplayNetBackend(Replay* r, NetBackend* h) : log(r), host(h) {}
+    ~ReplayNetBackend() override { delete host; }
+
+    const char* kind() const override { return host ? "recorded" : "replay"; }
+
+    bool send(const uint8_t* frame, size_t len) override
+    {
+        if (log->replaying())
+            return log->replay_tx();
+
+        const bool ok = host->send(frame, len);
+        log->record_tx(ok);
+        return ok;
+    }
+
+    size_t recv(uint8_t* buf, size_t cap) override
+    {
+        if (log->replaying())
+            return log->replay_rx(buf, cap);
+
+        const size_t n = host->recv(buf, cap);
+        if (n)
+            log->record_rx(buf, n);
+        return n;
+    }
+
+private:
+    Replay*     log;
+    NetBackend* host;
+};
+
+Replay::Replay()
+{
+}
+
+Replay::~Replay()
+{
+    finish();
+}
+
+uint64_t Replay::now() const
+{
+    return sched ? sched->now() : 0;
+}
+
+// FNV-1a over the PC and the general registers
+uint64_t Replay::cpu_hash() const
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    auto mix = [&h](uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 0x100000001B3ULL;
+        }
+    };
+
+    mix(cpu->getPC());
+    for (uint32_t r = 0; r < 32; r++)
+        mix(cpu->read_reg(r));
+    return h;
+}
+
+// -----------------------------------------------------------
+// Recording
+// -----------------------------------------------------------
+bool Replay::start_record(const std::string& p)
+{
+    if (!cpu || !sched || mode_ != Mode::Off)
+        return false;
+
+    out.open(p, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        Log::err() << "[REPLAY] Cannot write " << p << "\n";
+        return false;
+    }
+
+    const uint32_t hdr[2] = { VERSION, 0 };
+    out.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    out.write((const char*)hdr, sizeof(hdr));
+
+    path  = p;
+    mode_ = Mode::Record;
+    schedule_record_sync();
+
+    Log::out() << "[REPLAY] Recording host inputs to " << p << "\n";
+    return true;
+}
+
+void Replay::write_record(Kind k, const void* payload, uint32_t len)
+{
+    const uint64_t cycle = now();
+    out.put((char)k);
+    out.write((const char*)&cycle, sizeof(cycle));
+    out.write((const char*)&len, sizeof(len));
+    if (len)
+        out.write((const char*)payload, len);
+    records++;
+}
+
+void Replay::finish()
+{
+    if (mode_ != Mode::Record)
+        return;
+
+    write_record(REC_END, nullptr, 0);
+    out.close();
+    mode_ = Mode::Off;
+
+    Log::out() << "[REPLAY] " << records << " records over " << now()
+               << " cycles written to " << path << "\n";
+}
+
+void Replay::schedule_record_sync()
+{
+    sched->schedule(SYNC_CYCLES, [this]() {
+        if (mode_ != Mode::Record)
+            return;
+        const uint64_t h = cpu_hash();
+        write_record(REC_SYNC, &h, sizeof(h));
+        schedule_record_sync();
+    });
+}
+
+void Replay::record_disk(uint64_t issued, uint32_t target, int32_t error, bool aborted)
+{
+    uint8_t p[17];
+    std::memcpy(p, &issued, 8);
+    std::memcpy(p + 8, &target, 4);
+    std::memcpy(p + 12, &error, 4);
+    p[16] = aborted ? 1 : 0;
+    write_record(REC_DISK, p, sizeof(p));
+}
+
+void Replay::record_rx(const uint8_t* frame, size_t len)
+{
+    write_record(REC_NET_RX, frame, (uint32_t)len);
+}
+
+void Replay::record_tx(bool accepted)
+{
+    const uint8_t a = accepted ? 1 : 0;
+    write_record(REC_NET_TX, &a, 1);
+}
+
+NetBackend* Replay::wrap_network(NetBackend* host)
+{
+    if (recording()) {
+        write_record(REC_NET_ATTACH, nullptr, 0);
+        return new ReplayNetBackend(this, host);
+    }
+    delete host;
+    return new ReplayNetBackend(this, nullptr);
+}
+
+// -----------------------------------------------------------
+// Replay
+// -----------------------------------------------------------
+bool Replay::load(const std::string& p)
+{
+    std::ifstream in(p, std::ios::binary | std::ios::ate);
+    if (!in) {
+        Log::err() << "[REPLAY] Cannot open " << p << "\n";
+        return false;
+    }
+    const uint64_t file_size = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    char magic[8];
+    uint32_t hdr[2];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+        !in.read((char*)hdr, sizeof(hdr)) || hdr[0] != VERSION) {
+        Log::err() << "[REPLAY] " << p << " is not a replay log (version " << VERSION << ")\n";
+        return false;
+    }
+
+    std::vector<uint8_t> payload;
+    for (;;) {
+        char kind;
+        uint64_t cycle;
+        uint32_t len;
+        if (!in.get(kind))
+            break;
+        if (!in.read((char*)&cycle, sizeof(cycle)) || !in.read((char*)&len, sizeof(len)))
+            break;
+        if (len > MAX_PAYLOAD) {
+            Log::err() << "[REPLAY] " << p << ": bad record length " << len
+                       << " at cycle " << cycle << "\n";
+            return false;
+        }
+        if (len > file_size - (uint64_t)in.tellg())
+            break;      // last record cut short
+        payload.resize(len);
+        if (len && !in.read((char*)payload.data(), len))
+            break;
+
+        switch ((uint8_t)kind) {
+        case REC_DISK:
+            if (len == 17) {
+                uint64_t issued;
+                DiskDone d;
+                std::memcpy(&issued, payload.data(), 8);
+                std::memcpy(&d.target, payload.data() + 8, 4);
+                std::memcpy(&d.error, payload.data() + 12, 4);
+                d.cycle   = cycle;
+                d.aborted = payload[16] != 0;
+                disk[issued] = d;
+            }
+            break;
+        case REC_NET_ATTACH:
+            net_attached = true;
+            break;
+        case REC_NET_RX:
+            rx.push_back({ cycle, payload });
+            break;
+        case REC_NET_TX:
+            tx.push_back({ cycle, len && payload[0] });
+            break;
+        case REC_SYNC:
+            if (len == 8) {
+                uint64_t h;
+                std::memcpy(&h, payload.data(), 8);
+                syncs.push_back({ cycle, h });
+            }
+            break;
+        case REC_END:
+            end_cycle = cycle;
+            has_end   = true;
+            break;
+        default:
+            Log::err() << "[REPLAY] Unknown record kind " << (int)(uint8_t)kind
+                       << " at cycle " << cycle << "\n";
+            return false;
+        }
+    }
+
+    if (!has_end)
+        Log::err() << "[REPLAY] Warning: " << p << " has no end record (recording cut short)\n";
+    return true;
+}
+
+bool Replay::start_replay(const std::string& p)
+{
+    if (!cpu || !sched || mode_ != Mode::Off)
+        return false;
+    if (!load(p))
+        return false;
+
+    path  = p;
+    mode_ = Mode::Replay;
+    schedule_replay_sync();
+
+    if (has_end) {
+        sched->schedule_at(end_cycle, [this]() {
+            if (divergence)
+                return;
+            Log::out() << "[REPLAY] Reached the recorded end at cycle " << end_cycle << "\n";
+            if (on_stop)
+                on_stop();
+        });
+    }
+
+    Log::out() << "[REPLAY] Replaying " << p << ": " << disk.size() << " disk completions, "
+               << rx.size() << " frames in, " << tx.size() << " sends, "
+               << syncs.size() << " sync points\n";
+    return true;
+}
+
+void Replay::diverge(const char* what)
+{
+    if (divergence)
+        return;
+    divergence = now() + 1;
+    Log::err() << "[REPLAY] Diverged at cycle " << now() << ": " << what << "\n";
+    if (on_stop)
+        on_stop();
+}
+
+void Replay::schedule_replay_sync()
+{
+    if (syncs.empty())
+        return;
+
+    sched->schedule_at(syncs.front().first, [this]() {
+        const uint64_t want = syncs.front().second;
+        syncs.pop_front();
+        if (cpu_hash() != want) {
+            diverge("CPU registers differ from the recording");
+            return;
+        }
+        schedule_replay_sync();
+    });
+}
+
+uint64_t Replay::disk_completion(uint64_t issued, uint32_t target, uint64_t modelled,
+                                 int32_t& error, bool& aborted)
+{
+    error   = 0;
+    aborted = false;
+    auto it = disk.find(issued);
+    if (it == disk.end() || it->second.target != target) {
+        diverge("disk command not in the recording");
+        return modelled;
+    }
+
+    const uint64_t done = it->second.cycle;
+    error   = it->second.error;
+    aborted = it->second.aborted;
+    disk.erase(it);
+    return done;
+}
+
+size_t Replay::replay_rx(uint8_t* buf, size_t cap)
+{
+    if (rx.empty())
+        return 0;
+
+    const uint64_t t = now();
+    const Frame& f = rx.front();
+    if (f.cycle < t) {
+        diverge("received frame not collected at the recorded cycle");
+        return 0;
+    }
+    if (f.cycle > t)
+        return 0;
+
+    const size_t n = std::min(cap, f.data.size());
+    std::memcpy(buf, f.data.data(), n);
+    rx.pop_front();
+    return n;
+}
+
+bool Replay::replay_tx()
+{
+    if (tx.empty() || tx.front().first != now()) {
+        diverge("transmit at a cycle the recording did not have");
+        return true;
+    }
+    const bool ok = tx.front().second;
+    tx.pop_front();
+    return ok;
+}
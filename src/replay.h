@@ -0,0 +1,163 @@
+// -----------------------------------------------------------
+// replay.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Deterministic record / replay of host inputs
+//
+// Guest time is the instruction count (one cycle per
+// instruction, see scheduler.h), so a run repeats exactly once
+// every input whose timing or content comes from the host is
+// pinned to it. In this machine those are:
+//   - SCSI disk completions: the host finishes the I/O at its
+//     own pace and the interrupt is posted at the modelled time
+//     or when the host is done, whichever is later
+//   - Ethernet: received frames (content, and the poll that
+//     delivered them) and transmit flow control (whether the
+//     host took a frame)
+// CD-ROM reads, DMA, timers and the UART transmitter already run
+// on the guest clock. The console has no input path and there is
+// no RTC yet, so nothing else from the host reaches the guest.
+//
+//   - Recording wraps the network backend and notes each disk
+//     completion as it happens
+//   - Replay feeds them back at the recorded cycles (waiting for
+//     the host where it is slower) and stops the run at the
+//     recorded end
+//   - Every SYNC_CYCLES a hash of the CPU registers is logged
+//     and checked on replay; the first mismatch, or an input the
+//     guest asks for at a different cycle, stops the replay with
+//     the cycle where it diverged
+//
+// Disks must hold the same contents on replay: run each
+// recording and replay on a fresh copy-on-write overlay
+// (tools/cow_tool).
+//
+// Virtual time without a log: SCSIController::set_virtual_time
+// pins disk completions to the modelled time, which makes runs
+// without a network reproducible as they are.
+//
+// File: "RACERRPL", u32 version, u32 reserved, then records of
+//   u8 kind, u64 cycle, u32 length, payload      (host order)
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CPU;
+class Scheduler;
+class NetBackend;
+
+class Replay {
+public:
+    enum class Mode { Off, Record, Replay };
+
+    enum Kind : uint8_t {
+        REC_DISK       = 1,     // payload: u64 issue cycle, u32 target,
+                                //          i32 error (-errno), u8 aborted
+        REC_NET_ATTACH = 2,     // a network backend was plugged in
+        REC_NET_RX     = 3,     // payload: the frame
+        REC_NET_TX     = 4,     // payload: u8 accepted
+        REC_SYNC       = 5,     // payload: u64 register hash
+        REC_END        = 6,
+    };
+
+    static constexpr uint32_t VERSION     = 2;
+    static constexpr uint64_t SYNC_CYCLES = 1950000;    // 10 ms at 195 MHz
+
+    Replay();
+    ~Replay();
+
+    void attach_cpu(CPU* c) { cpu = c; }
+    void attach_scheduler(Scheduler* s) { sched = s; }
+
+    // Replay: run on the CPU thread at the recorded end, or when
+    // the run diverges
+    void set_stop_callback(std::function<void()> fn) { on_stop = std::move(fn); }
+
+    // Before the first instruction
+    bool start_record(const std::string& path);
+    bool start_replay(const std::string& path);
+
+    // Recording: log the end and close the file
+    void finish();
+
+    Mode mode() const      { return mode_; }
+    bool recording() const { return mode_ == Mode::Record; }
+    bool replaying() const { return mode_ == Mode::Replay; }
+    bool diverged() const  { return divergence != 0; }
+
+    // SCSI: completion (now) of the command issued at 'issued',
+    // with the host error (0 or -errno), or dropped after a bus
+    // reset. Replay returns the recorded completion cycle, error
+    // and abort ('modelled', 0, false if it was not recorded).
+    void     record_disk(uint64_t issued, uint32_t target, int32_t error, bool aborted);
+    uint64_t disk_completion(uint64_t issued, uint32_t target, uint64_t modelled,
+                             int32_t& error, bool& aborted);
+
+    // Replay: the run no longer follows the recording; stop it
+    void diverge(const char* what);
+
+    // Network. Recording: wraps 'host' (takes ownership) so what it
+    // delivers is logged. Replay: a backend fed from the log; pass
+    // nullptr. The result is owned by the caller.
+    NetBackend* wrap_network(NetBackend* host);
+
+    // Replay: the recording had a network attached
+    bool log_has_network() const { return net_attached; }
+
+private:
+    friend class ReplayNetBackend;
+
+    struct DiskDone {
+        uint32_t target;
+        uint64_t cycle;
+        int32_t  error;
+        bool     aborted;
+    };
+
+    struct Frame {
+        uint64_t             cycle;
+        std::vector<uint8_t> data;
+    };
+
+    Mode       mode_ = Mode::Off;
+    CPU*       cpu   = nullptr;
+    Scheduler* sched = nullptr;
+    std::function<void()> on_stop;
+    std::string path;
+
+    // Recording
+    std::ofstream out;
+    uint64_t      records = 0;
+
+    // Replay: the whole log, by channel
+    std::unordered_map<uint64_t, DiskDone>         disk;     // by issue cycle
+    std::deque<Frame>                              rx;
+    std::deque<std::pair<uint64_t, bool>>          tx;
+    std::deque<std::pair<uint64_t, uint64_t>>      syncs;
+    uint64_t end_cycle    = 0;
+    bool     has_end      = false;
+    bool     net_attached = false;
+    uint64_t divergence   = 0;      // cycle + 1 once diverged
+
+    uint64_t now() const;
+    uint64_t cpu_hash() const;
+
+    void write_record(Kind k, const void* payload, uint32_t len);
+    bool load(const std::string& path);
+
+    void schedule_record_sync();
+    void schedule_replay_sync();
+
+    // Called by the network wrapper
+    void   record_rx(const uint8_t* frame, size_t len);
+    size_t replay_rx(uint8_t* buf, size_t cap);
+    void   record_tx(bool accepted);
+    bool   replay_tx();
+};
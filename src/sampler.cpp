@@ -0,0 +1,146 @@
+// -----------------------------------------------------------
+// sampler.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Guest PC sampling profiler
+// -----------------------------------------------------------
+
+#include "sampler.h"
+#include "cpu.h"
+#include "scheduler.h"
+#include "symbols.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+GuestSampler::GuestSampler()
+    : ring(RING_SAMPLES)
+{
+}
+
+GuestSampler::~GuestSampler()
+{
+    stop();
+}
+
+// -----------------------------------------------------------
+// Recording
+// -----------------------------------------------------------
+void GuestSampler::start(uint64_t interval_cycles)
+{
+    if (!cpu || !sched)
+        return;
+
+    // Already running (e.g. for the counters' hot table): restart
+    // at the interval asked for now
+    stop();
+    interval = interval_cycles ? interval_cycles : DEFAULT_INTERVAL;
+    schedule_next();
+
+    Log::out() << "[SAMPLE] Sampling guest PC every " << interval << " cycles\n";
+}
+
+void GuestSampler::stop()
+{
+    if (event && sched)
+        sched->cancel(event);
+    event = 0;
+}
+
+void GuestSampler::schedule_next()
+{
+    event = sched->schedule(interval, [this]() {
+        take_sample();
+        schedule_next();
+    });
+}
+
+void GuestSampler::take_sample()
+{
+    const uint64_t pc = cpu->getPC();
+    ring[fill++] = { pc, cpu->read_reg(31) };
+    total++;
+    if (window_on)
+        window[pc]++;
+
+    if (fill == ring.size())
+        drain();
+}
+
+void GuestSampler::drain()
+{
+    for (size_t i = 0; i < fill; i++)
+        sites[{ ring[i].pc, ring[i].ra }]++;
+    fill = 0;
+}
+
+void GuestSampler::take_window(std::unordered_map<uint64_t, uint64_t>& out)
+{
+    out.clear();
+    out.swap(window);
+}
+
+// -----------------------------------------------------------
+// Reports
+// -----------------------------------------------------------
+bool GuestSampler::write_flat(const std::string& path, const SymbolTable& syms)
+{
+    drain();
+
+    std::ofstream out(path);
+    if (!out) {
+        Log::err() << "[SAMPLE] Cannot write " << path << "\n";
+        return false;
+    }
+
+    std::map<std::string, uint64_t> self;
+    for (const auto& s : sites)
+        self[syms.function(s.first.first)] += s.second;
+
+    std::vector<std::pair<std::string, uint64_t>> rows(self.begin(), self.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    char line[64];
+    out << "# " << total << " samples, one every " << interval << " cycles\n";
+    out << "#   samples     self    cumul  function\n";
+    double cumul = 0;
+    for (const auto& r : rows) {
+        const double share = total ? 100.0 * r.second / total : 0.0;
+        cumul += share;
+        std::snprintf(line, sizeof(line), "%11llu  %6.2f%%  %6.2f%%  ",
+                      (unsigned long long)r.second, share, cumul);
+        out << line << r.first << "\n";
+    }
+    return true;
+}
+
+bool GuestSampler::write_folded(const std::string& path, const SymbolTable& syms)
+{
+    drain();
+
+    std::ofstream out(path);
+    if (!out) {
+        Log::err() << "[SAMPLE] Cannot write " << path << "\n";
+        return false;
+    }
+
+    std::map<std::string, uint64_t> stacks;
+    for (const auto& s : sites) {
+        std::string fn = syms.function(s.first.first);
+        const std::string* caller = syms.lookup(s.first.second);
+
+        // $ra still pointing into the same function says nothing
+        if (caller && *caller != fn)
+            stacks[*caller + ";" + fn] += s.second;
+        else
+            stacks[fn] += s.second;
+    }
+
+    for (const auto& s : stacks)
+        out << s.first << " " << s.second << "\n";
+    return true;
+}
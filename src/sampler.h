@@ -0,0 +1,92 @@
+// -----------------------------------------------------------
+// sampler.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Guest PC sampling profiler
+//
+//   - Every N emulated cycles a scheduler event records the
+//     guest PC and $ra into a fixed ring; nothing is added to
+//     the per-instruction path
+//   - A full ring is folded into a (pc, ra) histogram, so long
+//     runs cost memory per distinct site, not per sample
+//   - Reports are symbolised at write time (see symbols.h):
+//       flat    self samples per function, hottest first
+//       folded  "caller;function count" lines for flamegraph.pl
+//   - Optionally a window of recent samples by PC, taken and
+//     reset by live views (perf_counters.h)
+//
+// $ra is only the caller while the sampled function has not
+// reused it (leaf functions and prologues), so the folded stacks
+// are two frames deep and approximate. Samples whose $ra does not
+// resolve are folded as the function alone.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CPU;
+class Scheduler;
+class SymbolTable;
+
+class GuestSampler {
+public:
+    static constexpr uint64_t DEFAULT_INTERVAL = 19500;   // 10 kHz at 195 MHz
+    static constexpr size_t   RING_SAMPLES     = 4096;
+
+    GuestSampler();
+    ~GuestSampler();
+
+    void attach_cpu(CPU* c) { cpu = c; }
+    void attach_scheduler(Scheduler* s) { sched = s; }
+
+    // Restarts at the new interval if already running
+    void start(uint64_t interval_cycles = DEFAULT_INTERVAL);
+    void stop();
+    bool running() const { return event != 0; }
+
+    uint64_t samples() const { return total; }
+
+    // Count samples per PC until take_window() (CPU thread), which
+    // hands them over and starts a new window
+    void enable_window() { window_on = true; }
+    void take_window(std::unordered_map<uint64_t, uint64_t>& out);
+
+    // Reports (drain the ring first). false if 'path' can't be written.
+    bool write_flat(const std::string& path, const SymbolTable& syms);
+    bool write_folded(const std::string& path, const SymbolTable& syms);
+
+private:
+    struct Sample {
+        uint64_t pc;
+        uint64_t ra;
+    };
+
+    struct SiteHash {
+        size_t operator()(const std::pair<uint64_t, uint64_t>& k) const
+        {
+            return std::hash<uint64_t>()(k.first * 0x9E3779B97F4A7C15ULL ^ k.second);
+        }
+    };
+
+    CPU*       cpu   = nullptr;
+    Scheduler* sched = nullptr;
+
+    uint64_t interval = DEFAULT_INTERVAL;
+    uint64_t event    = 0;
+
+    std::vector<Sample> ring;
+    size_t   fill  = 0;
+    uint64_t total = 0;
+
+    std::unordered_map<std::pair<uint64_t, uint64_t>, uint64_t, SiteHash> sites;
+
+    bool window_on = false;
+    std::unordered_map<uint64_t, uint64_t> window;
+
+    void schedule_next();
+    void take_sample();
+    void drain();
+};
@@ -0,0 +1,106 @@
+// -----------------------------------------------------------
+// scheduler.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Cycle-based event queue (binary min-heap)
+// -----------------------------------------------------------
+
+#include "scheduler.h"
+#include <algorithm>
+
+// Heap order: earliest 'when' first, FIFO among equal times
+static bool event_later(const uint64_t aw, const uint64_t aid,
+                        const uint64_t bw, const uint64_t bid)
+{
+    return (aw != bw) ? (aw > bw) : (aid > bid);
+}
+
+Scheduler::Scheduler() {}
+Scheduler::~Scheduler() {}
+
+// -----------------------------------------------------------
+// reset() - drop all events, rewind time
+// -----------------------------------------------------------
+void Scheduler::reset()
+{
+    cycle    = 0;
+    next_due = UINT64_MAX;
+    heap.clear();
+    cancelled.clear();
+}
+
+// -----------------------------------------------------------
+// schedule / schedule_at
+// -----------------------------------------------------------
+Scheduler::EventId Scheduler::schedule(uint64_t delay, Callback fn)
+{
+    return schedule_at(cycle + delay, std::move(fn));
+}
+
+Scheduler::EventId Scheduler::schedule_at(uint64_t when, Callback fn)
+{
+    Event e;
+    e.when = when;
+    e.id   = next_id++;
+    e.fn   = std::move(fn);
+
+    EventId id = e.id;
+
+    heap.push_back(std::move(e));
+    std::push_heap(heap.begin(), heap.end(), [](const Event& a, const Event& b) {
+        return event_later(a.when, a.id, b.when, b.id);
+    });
+
+    update_next_due();
+    return id;
+}
+
+// -----------------------------------------------------------
+// cancel() - lazily removed when the event reaches the top
+// -----------------------------------------------------------
+void Scheduler::cancel(EventId id)
+{
+    if (id != 0)
+        cancelled.push_back(id);
+}
+
+uint64_t Scheduler::cycles_to_next() const
+{
+    if (next_due == UINT64_MAX) return UINT64_MAX;
+    return (next_due > cycle) ? (next_due - cycle) : 0;
+}
+
+// -----------------------------------------------------------
+// run_due() - fire every event whose time has come
+// Callbacks may schedule further events (including at 'now').
+// -----------------------------------------------------------
+void Scheduler::run_due()
+{
+    auto cmp = [](const Event& a, const Event& b) {
+        return event_later(a.when, a.id, b.when, b.id);
+    };
+
+    while (!heap.empty() && heap.front().when <= cycle)
+    {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        Event e = std::move(heap.back());
+        heap.pop_back();
+
+        auto it = std::find(cancelled.begin(), cancelled.end(), e.id);
+        if (it != cancelled.end()) {
+            cancelled.erase(it);
+            continue;
+        }
+
+        e.fn();
+    }
+
+    update_next_due();
+}
+
+void Scheduler::update_next_due()
+{
+    next_due = heap.empty() ? UINT64_MAX : heap.front().when;
+    if (heap.empty())
+        cancelled.clear();
+}
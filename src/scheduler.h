@@ -0,0 +1,64 @@
+// -----------------------------------------------------------
+// scheduler.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Emulator timeline: devices schedule callbacks at a cycle
+// count instead of doing work on the CPU's critical path.
+//
+// Time is measured in emulated CPU cycles. Emulator::run()
+// calls advance() after every step; the check is a single
+// compare until an event actually falls due.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Scheduler {
+public:
+    using EventId  = uint64_t;
+    using Callback = std::function<void()>;
+
+    Scheduler();
+    ~Scheduler();
+
+    void reset();
+
+    // Current emulated time (cycles since reset)
+    uint64_t now() const { return cycle; }
+
+    // Advance the timeline and fire anything that is due
+    inline void advance(uint64_t n)
+    {
+        cycle += n;
+        if (cycle >= next_due)
+            run_due();
+    }
+
+    // Schedule fn to run 'delay' cycles from now.
+    // Returns an id that can be passed to cancel().
+    EventId schedule(uint64_t delay, Callback fn);
+    EventId schedule_at(uint64_t when, Callback fn);
+    void    cancel(EventId id);
+
+    // Cycles until the next pending event (UINT64_MAX if none)
+    uint64_t cycles_to_next() const;
+
+private:
+    struct Event {
+        uint64_t when = 0;
+        EventId  id   = 0;
+        Callback fn;
+    };
+
+    uint64_t cycle    = 0;
+    uint64_t next_due = UINT64_MAX;
+    EventId  next_id  = 1;
+
+    std::vector<Event>   heap;       // min-heap on (when, id)
+    std::vector<EventId> cancelled;  // small; events rarely cancelled
+
+    void run_due();
+    void update_next_due();
+};
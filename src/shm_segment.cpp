@@ -0,0 +1,68 @@
+// -----------------------------------------------------------
+// shm_segment.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Writer side of a POSIX shared memory segment
+// -----------------------------------------------------------
+
+#include "shm_segment.h"
+#include "log.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+ShmSegment::~ShmSegment()
+{
+    close();
+}
+
+bool ShmSegment::create(const std::string& name, size_t size, const char* tag)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        if (errno == EEXIST)
+            Log::err() << "[" << tag << "] " << name << " is already in use (another instance, "
+                       << "or left by one that crashed: remove /dev/shm" << name << ")\n";
+        else
+            Log::err() << "[" << tag << "] shm_open " << name << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    shm_name = name;
+
+    if (ftruncate(fd, (off_t)size) != 0) {
+        Log::err() << "[" << tag << "] ftruncate: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        close();
+        return false;
+    }
+
+    void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);    // the mapping keeps the segment referenced
+    if (m == MAP_FAILED) {
+        Log::err() << "[" << tag << "] mmap: " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+
+    base     = m;
+    map_size = size;
+    return true;
+}
+
+void ShmSegment::close()
+{
+    if (base) {
+        munmap(base, map_size);
+        base     = nullptr;
+        map_size = 0;
+    }
+
+    if (!shm_name.empty()) {
+        shm_unlink(shm_name.c_str());
+        shm_name.clear();
+    }
+}
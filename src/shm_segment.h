@@ -0,0 +1,42 @@
+// -----------------------------------------------------------
+// shm_segment.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Writer side of a POSIX shared memory segment
+//
+//   - create() refuses a name that is already in use: it belongs
+//     to another running instance, or is left over from one that
+//     crashed (remove /dev/shm/<name> by hand)
+//   - The name is owned from shm_open() on, so a later failure
+//     still unlinks what was created
+//   - close() unmaps and unlinks only a segment this object made
+//
+// Used by the framebuffer export and the performance counters.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+class ShmSegment {
+public:
+    ShmSegment() {}
+    ~ShmSegment();
+
+    ShmSegment(const ShmSegment&) = delete;
+    ShmSegment& operator=(const ShmSegment&) = delete;
+
+    // Create /dev/shm/<name> ('/' first) of 'size' bytes and map it
+    // read-write. 'tag' prefixes error messages ("FBSHM").
+    bool create(const std::string& name, size_t size, const char* tag);
+    void close();
+
+    void*  data() const { return base; }
+    size_t size() const { return map_size; }
+    const std::string& name() const { return shm_name; }
+
+private:
+    std::string shm_name;           // non-empty while we own the name
+    void*       base     = nullptr;
+    size_t      map_size = 0;
+};
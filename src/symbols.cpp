@@ -0,0 +1,286 @@
+// -----------------------------------------------------------
+// symbols.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// ELF / text map symbol loading and address lookup
+// -----------------------------------------------------------
+
+#include "symbols.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Untyped labels further than this from the next symbol are
+// not trusted to cover the gap (data, padding, other images)
+static constexpr uint64_t MAX_UNSIZED_SPAN = 1ULL << 20;
+
+static uint64_t sign_extend32(uint64_t v)
+{
+    return (uint64_t)(int64_t)(int32_t)(uint32_t)v;
+}
+
+// -----------------------------------------------------------
+// ELF field access (either byte order, either class)
+// -----------------------------------------------------------
+namespace {
+
+struct ElfReader {
+    const std::vector<uint8_t>& d;
+    bool big;
+    bool is64;
+
+    bool in(uint64_t off, uint64_t n) const { return off <= d.size() && n <= d.size() - off; }
+
+    uint64_t get(uint64_t off, int n) const
+    {
+        if (!in(off, n))
+            return 0;
+        uint64_t v = 0;
+        for (int i = 0; i < n; i++) {
+            int b = big ? i : n - 1 - i;
+            v = (v << 8) | d[off + b];
+        }
+        return v;
+    }
+    uint64_t u16(uint64_t off) const { return get(off, 2); }
+    uint64_t u32(uint64_t off) const { return get(off, 4); }
+    uint64_t word(uint64_t off) const { return get(off, is64 ? 8 : 4); }
+};
+
+} // namespace
+
+// -----------------------------------------------------------
+// load_elf()
+// -----------------------------------------------------------
+bool SymbolTable::load_elf(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        Log::err() << "[SYM] Cannot open " << path << "\n";
+        return false;
+    }
+    std::vector<uint8_t> d((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    if (d.size() < 52 || std::memcmp(d.data(), "\x7f" "ELF", 4) != 0) {
+        Log::err() << "[SYM] Not an ELF file: " << path << "\n";
+        return false;
+    }
+
+    ElfReader e{ d, d[5] == 2, d[4] == 2 };
+
+    const uint64_t shoff     = e.word(e.is64 ? 0x28 : 0x20);
+    const uint64_t shentsize = e.u16(e.is64 ? 0x3A : 0x2E);
+    const uint64_t shnum     = e.u16(e.is64 ? 0x3C : 0x30);
+
+    // Section header fields
+    auto sh = [&](uint64_t i) { return shoff + i * shentsize; };
+    auto sh_type   = [&](uint64_t i) { return e.u32(sh(i) + 4); };
+    auto sh_offset = [&](uint64_t i) { return e.word(sh(i) + (e.is64 ? 0x18 : 0x10)); };
+    auto sh_size   = [&](uint64_t i) { return e.word(sh(i) + (e.is64 ? 0x20 : 0x14)); };
+    auto sh_link   = [&](uint64_t i) { return e.u32(sh(i) + (e.is64 ? 0x28 : 0x18)); };
+
+    if (!shoff || !shnum || !e.in(shoff, shnum * shentsize)) {
+        Log::err() << "[SYM] No section headers in " << path << "\n";
+        return false;
+    }
+
+    // Prefer the full symbol table; stripped binaries keep .dynsym
+    uint64_t symsec = 0;
+    for (uint32_t want : { 2u /* SHT_SYMTAB */, 11u /* SHT_DYNSYM */ }) {
+        for (uint64_t i = 1; i < shnum && !symsec; i++)
+            if (sh_type(i) == want)
+                symsec = i;
+        if (symsec)
+            break;
+    }
+    if (!symsec) {
+        Log::err() << "[SYM] No symbols in " << path << "\n";
+        return false;
+    }
+
+    const uint64_t strsec = sh_link(symsec);
+    if (strsec >= shnum)
+        return false;
+    const uint64_t stroff = sh_offset(strsec);
+    const uint64_t strsz  = sh_size(strsec);
+    if (!e.in(stroff, strsz))
+        return false;
+
+    const uint64_t entsz = e.is64 ? 24 : 16;
+    const uint64_t base  = sh_offset(symsec);
+    const uint64_t count = sh_size(symsec) / entsz;
+    const size_t before  = syms.size();
+
+    for (uint64_t i = 1; i < count; i++) {
+        const uint64_t s = base + i * entsz;
+        if (!e.in(s, entsz))
+            break;
+
+        uint64_t name, value, size;
+        uint8_t  info;
+        uint16_t shndx;
+        if (e.is64) {
+            name  = e.u32(s);
+            info  = d[s + 4];
+            shndx = e.u16(s + 6);
+            value = e.word(s + 8);
+            size  = e.word(s + 16);
+        } else {
+            name  = e.u32(s);
+            value = sign_extend32(e.u32(s + 4));
+            size  = e.u32(s + 8);
+            info  = d[s + 12];
+            shndx = e.u16(s + 14);
+        }
+
+        const uint8_t type = info & 0xF;
+        if (type != 2 /* FUNC */ && type != 0 /* NOTYPE */)
+            continue;
+        if (shndx == 0 || shndx >= 0xFF00 || name >= strsz)
+            continue;
+
+        const char* nm = (const char*)&d[stroff + name];
+        if (!std::memchr(nm, 0, strsz - name))
+            continue;
+        // Local/assembler-internal labels only clutter the profile
+        if (!*nm || *nm == '$' || std::strncmp(nm, ".L", 2) == 0)
+            continue;
+        if (type == 0 && (info >> 4) == 0 /* LOCAL */)
+            continue;
+
+        add(value, size, nm);
+    }
+
+    finish();
+    Log::out() << "[SYM] " << path << ": " << (syms.size() - before) << " symbols\n";
+    return true;
+}
+
+// -----------------------------------------------------------
+// load_map() - "<hex addr> [type] <name>" per line
+// -----------------------------------------------------------
+bool SymbolTable::load_map(const std::string& path)
+{
+    std::ifstream f(path);
+    if (!f) {
+        Log::err() << "[SYM] Cannot open " << path << "\n";
+        return false;
+    }
+
+    const size_t before = syms.size();
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream in(line);
+        std::string a, b, c;
+        in >> a >> b >> c;
+        if (b.empty())
+            continue;
+
+        char* end = nullptr;
+        uint64_t addr = std::strtoull(a.c_str(), &end, 16);
+        if (!end || *end)
+            continue;
+        if (addr <= 0xFFFFFFFFULL)
+            addr = sign_extend32(addr);
+
+        // nm: "addr T name"; plain map: "addr name"
+        add(addr, 0, (c.empty() ? b : c).c_str());
+    }
+
+    finish();
+    Log::out() << "[SYM] " << path << ": " << (syms.size() - before) << " symbols\n";
+    return true;
+}
+
+bool SymbolTable::load(const std::string& path)
+{
+    char magic[4] = {};
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        Log::err() << "[SYM] Cannot open " << path << "\n";
+        return false;
+    }
+    f.read(magic, 4);
+    return std::memcmp(magic, "\x7f" "ELF", 4) == 0 ? load_elf(path) : load_map(path);
+}
+
+// -----------------------------------------------------------
+// Table upkeep and lookup
+// -----------------------------------------------------------
+void SymbolTable::add(uint64_t addr, uint64_t size, const char* name)
+{
+    syms.push_back({ addr, size, name });
+}
+
+void SymbolTable::finish()
+{
+    std::stable_sort(syms.begin(), syms.end(),
+                     [](const Sym& a, const Sym& b) { return a.addr < b.addr; });
+
+    // Aliases at one address: keep the first sized one
+    std::vector<Sym> out;
+    out.reserve(syms.size());
+    for (Sym& s : syms) {
+        if (!out.empty() && out.back().addr == s.addr) {
+            if (!out.back().size && s.size)
+                out.back() = std::move(s);
+            continue;
+        }
+        out.push_back(std::move(s));
+    }
+    syms.swap(out);
+}
+
+const std::string* SymbolTable::lookup(uint64_t addr, uint64_t* offset) const
+{
+    auto it = std::upper_bound(syms.begin(), syms.end(), addr,
+                               [](uint64_t a, const Sym& s) { return a < s.addr; });
+    if (it == syms.begin())
+        return nullptr;
+
+    const Sym& s = *(it - 1);
+    const uint64_t off = addr - s.addr;
+    if (s.size) {
+        if (off >= s.size)
+            return nullptr;
+    } else {
+        const uint64_t span = it != syms.end() ? it->addr - s.addr : MAX_UNSIZED_SPAN;
+        if (off >= std::min(span, MAX_UNSIZED_SPAN))
+            return nullptr;
+    }
+
+    if (offset)
+        *offset = off;
+    return &s.name;
+}
+
+static std::string unknown_page(uint64_t addr)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "[0x%llx]", (unsigned long long)(addr & ~0xFFFULL));
+    return buf;
+}
+
+std::string SymbolTable::describe(uint64_t addr) const
+{
+    uint64_t off = 0;
+    const std::string* name = lookup(addr, &off);
+    if (!name)
+        return unknown_page(addr);
+
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "+0x%llx", (unsigned long long)off);
+    return *name + buf;
+}
+
+std::string SymbolTable::function(uint64_t addr) const
+{
+    const std::string* name = lookup(addr);
+    return name ? *name : unknown_page(addr);
+}
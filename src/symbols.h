@@ -0,0 +1,53 @@
+// -----------------------------------------------------------
+// symbols.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Guest address -> function name, for profiles
+//
+//   - ELF32/ELF64 of either byte order (sash, IRIX unix,
+//     user binaries): .symtab, else .dynsym; functions plus
+//     untyped text labels, which is what hand-written MIPS
+//     assembly in the PROM and kernel exports
+//   - Text maps for the PROM: one "<hex addr> [type] <name>"
+//     per line, i.e. nm output or a hand-written list
+//
+// 32-bit addresses are sign-extended the way the R10000 sees
+// them, so 0x88001234 in an ELF32 kernel matches a sampled PC
+// of 0xFFFFFFFF88001234.
+// -----------------------------------------------------------
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SymbolTable {
+public:
+    // Load by content: ELF if it starts with \x7fELF, else a text map
+    bool load(const std::string& path);
+    bool load_elf(const std::string& path);
+    bool load_map(const std::string& path);
+
+    // Containing symbol, or nullptr. 'offset' gets addr - start.
+    const std::string* lookup(uint64_t addr, uint64_t* offset = nullptr) const;
+
+    // "name+0x1c", or "[0x...]" (page granular) when unknown
+    std::string describe(uint64_t addr) const;
+
+    // Function name, or the "[0x...]" page when unknown
+    std::string function(uint64_t addr) const;
+
+    size_t size() const { return syms.size(); }
+
+private:
+    struct Sym {
+        uint64_t    addr;
+        uint64_t    size;       // 0 = runs to the next symbol
+        std::string name;
+    };
+
+    std::vector<Sym> syms;      // sorted by addr after every load
+
+    void add(uint64_t addr, uint64_t size, const char* name);
+    void finish();
+};
@@ -0,0 +1,197 @@
+// fb_shm_view.cpp
+// Viewer for a Racer framebuffer exported through shared memory.
+// Maps the segment read-only; the emulator does no copying for us.
+//
+// Usage:
+//   fb_shm_view /racer-fb-<pid>            open a window (SDL2)
+//   fb_shm_view /racer-fb-<pid> --info     print segment header
+//   fb_shm_view /racer-fb-<pid> --ppm f    write current frame to f
+//
+// Build (Linux): g++ -O2 -std=c++17 fb_shm_view.cpp ../dev/pixel_convert.cpp `pkg-config --cflags --libs sdl2` -o fb_shm_view -lrt
+
+#include <SDL.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../dev/fb_shm.h"
+#include "../dev/pixel_convert.h"
+
+struct Mapping {
+    const uint8_t*     base = nullptr;
+    size_t             size = 0;
+    const FbShmHeader* hdr  = nullptr;
+    const uint32_t*    tile_seq = nullptr;
+    const uint8_t*     pixels = nullptr;
+};
+
+static bool map_segment(const std::string& name, Mapping& m) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "shm_open " << name << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Header first, to learn the full segment size
+    void* h = mmap(nullptr, 4096, PROT_READ, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED) { close(fd); return false; }
+    const FbShmHeader* hdr = static_cast<const FbShmHeader*>(h);
+    if (hdr->magic != FB_SHM_MAGIC || hdr->version != FB_SHM_VERSION) {
+        std::cerr << "Not a Racer framebuffer segment (magic/version mismatch)\n";
+        munmap(h, 4096);
+        close(fd);
+        return false;
+    }
+    size_t total = hdr->segment_size;
+    munmap(h, 4096);
+
+    void* all = mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (all == MAP_FAILED) return false;
+
+    m.base = static_cast<const uint8_t*>(all);
+    m.size = total;
+    m.hdr = reinterpret_cast<const FbShmHeader*>(m.base);
+    m.tile_seq = reinterpret_cast<const uint32_t*>(m.base + m.hdr->tile_seq_offset);
+    m.pixels = m.base + m.hdr->pixel_offset;
+    return true;
+}
+
+static void print_info(const Mapping& m) {
+    const FbShmHeader* h = m.hdr;
+    std::cout << "writer pid : " << h->writer_pid << "\n"
+              << "size       : " << h->width << "x" << h->height
+              << " pitch " << h->pitch << " format " << h->format << "\n"
+              << "tiles      : " << h->tiles_x << "x" << h->tiles_y
+              << " of " << h->tile_w << "x" << h->tile_h << "\n"
+              << "frame      : " << h->frame
+              << " (sequence " << h->sequence.load() << ")\n";
+}
+
+static bool write_ppm(const Mapping& m, const char* path) {
+    const FbShmHeader* h = m.hdr;
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%u %u\n255\n", h->width, h->height);
+    std::vector<uint32_t> argb(h->width);
+    std::vector<uint8_t> rgb(static_cast<size_t>(h->width) * 3);
+    for (uint32_t y = 0; y < h->height; ++y) {
+        convert_row(static_cast<GuestPixelFormat>(h->format),
+                    m.pixels + static_cast<size_t>(y) * h->pitch, argb.data(), h->width);
+        for (uint32_t x = 0; x < h->width; ++x) {
+            rgb[x*3 + 0] = static_cast<uint8_t>(argb[x] >> 16);
+            rgb[x*3 + 1] = static_cast<uint8_t>(argb[x] >> 8);
+            rgb[x*3 + 2] = static_cast<uint8_t>(argb[x]);
+        }
+        std::fwrite(rgb.data(), 1, rgb.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " /shm-name [--info | --ppm file]\n";
+        return 1;
+    }
+
+    Mapping m;
+    if (!map_segment(argv[1], m)) return 2;
+
+    if (argc >= 3 && std::strcmp(argv[2], "--info") == 0) {
+        print_info(m);
+        return 0;
+    }
+    if (argc >= 4 && std::strcmp(argv[2], "--ppm") == 0) {
+        return write_ppm(m, argv[3]) ? 0 : 3;
+    }
+
+    const FbShmHeader* h = m.hdr;
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
+        return 4;
+    }
+
+    std::string title = std::string("Racer viewer - ") + argv[1];
+    SDL_Window* window = SDL_CreateWindow(title.c_str(),
+                                          SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                          h->width, h->height, SDL_WINDOW_RESIZABLE);
+    SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : nullptr;
+    SDL_Texture* texture = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                        SDL_TEXTUREACCESS_STREAMING,
+                                                        h->width, h->height) : nullptr;
+    if (!texture) {
+        std::cerr << "SDL setup failed: " << SDL_GetError() << "\n";
+        SDL_Quit();
+        return 5;
+    }
+
+    uint32_t seenFrame = 0;
+    bool firstFrame = true;
+    bool running = true;
+
+    while (running) {
+        SDL_Event ev;
+        bool needPresent = false;
+        while (SDL_PollEvent(&ev)) {
+            if (ev.type == SDL_QUIT) running = false;
+            else if (ev.type == SDL_KEYDOWN && ev.key.keysym.sym == SDLK_ESCAPE) running = false;
+            else if (ev.type == SDL_WINDOWEVENT) needPresent = true;
+        }
+
+        // Seqlock read of frame metadata
+        uint64_t s0 = h->sequence.load(std::memory_order_acquire);
+        if ((s0 & 1) || (!firstFrame && static_cast<uint32_t>(h->frame) == seenFrame)) {
+            if (needPresent) {
+                SDL_RenderClear(renderer);
+                SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+                SDL_RenderPresent(renderer);
+            }
+            SDL_Delay(5);
+            continue;
+        }
+        uint32_t frame = static_cast<uint32_t>(h->frame);
+        GuestPixelFormat fmt = static_cast<GuestPixelFormat>(h->format);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h->sequence.load(std::memory_order_relaxed) != s0) continue;
+
+        // Upload every tile that changed after the last frame we showed;
+        // works even if we skipped frames in between.
+        for (uint32_t ty = 0; ty < h->tiles_y; ++ty) {
+            for (uint32_t tx = 0; tx < h->tiles_x; ++tx) {
+                if (!firstFrame && m.tile_seq[ty * h->tiles_x + tx] <= seenFrame) continue;
+
+                uint32_t x = tx * h->tile_w, y = ty * h->tile_h;
+                uint32_t w = h->tile_w, hh = h->tile_h;
+                if (x + w > h->width) w = h->width - x;
+                if (y + hh > h->height) hh = h->height - y;
+
+                SDL_Rect r{ static_cast<int>(x), static_cast<int>(y), static_cast<int>(w), static_cast<int>(hh) };
+                void* dst = nullptr;
+                int dstPitch = 0;
+                if (SDL_LockTexture(texture, &r, &dst, &dstPitch) != 0) continue;
+                convert_rect(fmt, m.pixels + static_cast<size_t>(y) * h->pitch + static_cast<size_t>(x) * 4,
+                             h->pitch, static_cast<uint8_t*>(dst), static_cast<size_t>(dstPitch), w, hh);
+                SDL_UnlockTexture(texture);
+            }
+        }
+
+        seenFrame = frame;
+        firstFrame = false;
+
+        SDL_RenderClear(renderer);
+        SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+        SDL_RenderPresent(renderer);
+    }
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
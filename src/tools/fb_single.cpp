@@ -7,7 +7,7 @@
 //   i -> toggle integer-scaling (pixel-perfect zoom)
 //   v -> toggle vsync (re-creates renderer when changed)
 //
-// Build (Linux): g++ -O2 -std=c++17 fb_single.cpp `pkg-config --cflags --libs sdl2` -o fb_test
+// Build (Linux): g++ -O2 -std=c++17 fb_single.cpp ../dev/pixel_convert.cpp `pkg-config --cflags --libs sdl2` -o fb_test
 // Run: ./fb_test
 //
 // Integrate: copy FramebufferDevice::fill_test_pattern and conversion + rectangle logic into your emulator.
@@ -20,6 +20,7 @@
 #include <iostream>
 #include <atomic>
 #include <cstring>
+#include "../dev/pixel_convert.h"
 
 static constexpr int FB_W = 1280;
 static constexpr int FB_H = 1024;
@@ -73,29 +74,24 @@ struct GuestFramebuffer {
     }
 };
 
-// Convert guest big-endian pixel buffer to host-native ARGB8888 (uint32_t array).
-// hostBuf must hold width*height entries. This conversion is fast (word ops).
-static void convert_guest_be_to_host_argb(const GuestFramebuffer &fb, uint32_t *hostBuf) {
+// Convert guest big-endian pixels straight into the streaming texture.
+// The texture is locked and the shared SIMD kernels (pshufb / AVX2 where
+// available) write host ARGB8888 into it, honouring the texture pitch,
+// so there is no intermediate host buffer.
+static bool upload_guest_be_to_texture(const GuestFramebuffer &fb, SDL_Texture *texture) {
     // The guest stores pixels as 0xAARRGGBB big-endian (bytes in memory: AA RR GG BB).
-    // On little-endian host, we want the uint32 value 0xAARRGGBB in native representation,
-    // so we must convert from big-endian word to host endianness.
-    const size_t pixels = static_cast<size_t>(fb.width) * static_cast<size_t>(fb.height);
-    const uint8_t* src = fb.bytes.data();
-
-#if SDL_BYTEORDER == SDL_LIL_ENDIAN
-    // Host is little-endian: read big-endian word and swap
-    for (size_t i = 0; i < pixels; ++i) {
-        uint32_t be =
-            (static_cast<uint32_t>(src[i*4 + 0]) << 24) |
-            (static_cast<uint32_t>(src[i*4 + 1]) << 16) |
-            (static_cast<uint32_t>(src[i*4 + 2]) << 8) |
-            (static_cast<uint32_t>(src[i*4 + 3]) << 0);
-        hostBuf[i] = SDL_SwapBE32(be); // convert to host order (little)
+    void *dst = nullptr;
+    int dstPitch = 0;
+    if (SDL_LockTexture(texture, nullptr, &dst, &dstPitch) != 0) {
+        std::cerr << "SDL_LockTexture failed: " << SDL_GetError() << "\n";
+        return false;
     }
-#else
-    // Big-endian host: copy bytes into uint32_t directly
-    memcpy(hostBuf, src, pixels * 4);
-#endif
+    convert_rect(GuestPixelFormat::ARGB8888,
+                 fb.bytes.data(), fb.pitch,
+                 static_cast<uint8_t*>(dst), static_cast<size_t>(dstPitch),
+                 fb.width, fb.height);
+    SDL_UnlockTexture(texture);
+    return true;
 }
 
 // Compute destination rectangle preserving aspect ratio (5:4) and optionally integer scale.
@@ -136,7 +132,8 @@ static SDL_Rect compute_dest_rect(int winW, int winH, int fbW, int fbH, bool int
 }
 
 int main(int argc, char** argv) {
-    std::cout << "Racer framebuffer test (single-file)\n";
+    std::cout << "Racer framebuffer test (single-file), pixel conversion: "
+              << pixel_convert_isa() << "\n";
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
         return 1;
@@ -191,16 +188,16 @@ int main(int argc, char** argv) {
         return 4;
     }
 
-    // Host conversion buffer
-    std::vector<uint32_t> hostBuf;
-    hostBuf.resize(static_cast<size_t>(FB_W) * static_cast<size_t>(FB_H));
-
     std::atomic<bool> running(true);
     auto lastFrame = std::chrono::steady_clock::now();
     const std::chrono::microseconds framePeriod(16667); // ~60Hz
 
     std::cout << "Controls: ESC=quit  SPACE=refill pattern  i=toggle integer scale  v=toggle vsync\n";
 
+    // Guest framebuffer changed since last upload / window needs a redraw
+    bool fbDirty = true;
+    bool needPresent = true;
+
     while (running.load()) {
         // Event handling
         SDL_Event ev;
@@ -212,9 +209,11 @@ int main(int argc, char** argv) {
                 if (k == SDLK_ESCAPE) running.store(false);
                 else if (k == SDLK_SPACE) {
                     fb.fill_test_pattern();
+                    fbDirty = true;
                     std::cout << "Refilled test pattern\n";
                 } else if (k == SDLK_i) {
                     integerScale = !integerScale;
+                    needPresent = true;
                     std::cout << "Integer scale: " << (integerScale ? "ON" : "OFF") << "\n";
                 } else if (k == SDLK_v) {
                     useVsync = !useVsync;
@@ -227,20 +226,30 @@ int main(int argc, char** argv) {
                     texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
                                                 SDL_TEXTUREACCESS_STREAMING, FB_W, FB_H);
                     if (!texture) { std::cerr << "CreateTexture failed after vsync toggle\n"; running.store(false); break; }
+                    fbDirty = true; // new texture is empty
                 }
             } else if (ev.type == SDL_WINDOWEVENT) {
-                if (ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-                    // Could respond if needed
+                if (ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
+                    ev.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                    needPresent = true;
                 }
             }
         }
 
-        // Convert guest BE framebuffer -> host ARGB8888 array
-        convert_guest_be_to_host_argb(fb, hostBuf.data());
+        // Nothing changed and nothing to repaint: skip convert, upload and present
+        if (!fbDirty && !needPresent) {
+            SDL_Delay(1);
+            continue;
+        }
 
-        // Update texture
-        // We'll update entire texture each frame (could optimize with dirty rects)
-        SDL_UpdateTexture(texture, nullptr, hostBuf.data(), FB_W * 4);
+        if (fbDirty) {
+            // Convert guest BE framebuffer directly into the locked texture.
+            // The test pattern rewrites the whole buffer, so upload it whole.
+            // The emulator's SDLDisplay uploads only dirty tiles.
+            upload_guest_be_to_texture(fb, texture);
+            fbDirty = false;
+        }
+        needPresent = false;
 
         // get window size and destination rect
         int winW, winH;
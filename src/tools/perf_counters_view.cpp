@@ -0,0 +1,249 @@
+// perf_counters_view.cpp
+// Reader for the live performance counters of a running Racer
+// instance (RACER_COUNTERS_SHM=/name). Maps the page read-only;
+// the emulator is not stopped or slowed down.
+//
+// Usage:
+//   perf_counters_view /racer-perf              live view, one update per interval
+//   perf_counters_view /racer-perf --json       one JSON object: totals, plus rates
+//                                               measured over one interval
+//   perf_counters_view /racer-perf --interval 500 --count 10
+//
+// Build (Linux): g++ -O2 -std=c++17 perf_counters_view.cpp ../perf_counters.cpp ../shm_segment.cpp ../log.cpp -o perf_counters_view -lrt -lpthread
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../perf_counters.h"
+
+static const char* const EXC_NAMES[32] = {
+    "Int",  "Mod",  "TLBL", "TLBS", "AdEL", "AdES", "IBE",  "DBE",
+    "Sys",  "Bp",   "RI",   "CpU",  "Ov",   "Tr",   "VCEI", "FPE",
+    "",     "",     "",     "",     "",     "",     "",     "WATCH",
+    "",     "",     "",     "",     "",     "",     "",     "VCED",
+};
+
+static const PerfShm* map_page(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "shm_open " << name << ": " << std::strerror(errno) << "\n";
+        return nullptr;
+    }
+    void* m = mmap(nullptr, 4096, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return nullptr;
+
+    const PerfShm* p = static_cast<const PerfShm*>(m);
+    if (p->magic != PERF_SHM_MAGIC || p->version != PERF_SHM_VERSION) {
+        std::cerr << "Not a Racer counter page (magic/version mismatch)\n";
+        munmap(m, 4096);
+        return nullptr;
+    }
+    return p;
+}
+
+static bool writer_alive(const PerfShm* p)
+{
+    return kill((pid_t)p->writer_pid, 0) == 0 || errno == EPERM;
+}
+
+// Per second over the published interval; 0 if nothing was published
+static double rate(uint64_t a, uint64_t b, uint64_t ns)
+{
+    return ns ? (double)(b - a) * 1e9 / (double)ns : 0.0;
+}
+
+static uint64_t sum(const uint64_t* v, int n)
+{
+    uint64_t t = 0;
+    for (int i = 0; i < n; i++)
+        t += v[i];
+    return t;
+}
+
+static void print_text(const PerfShm* p, const PerfSnapshot& a, const PerfSnapshot& b)
+{
+    const uint64_t ns = b.host_ns - a.host_ns;
+    const uint64_t tlb = b.tlb_hits + b.tlb_misses;
+
+    std::printf("Racer pid %u%s   up %.1f s   guest %.3f s\n", p->writer_pid,
+                writer_alive(p) ? "" : " (exited)", (b.host_ns - p->start_ns) / 1e9,
+                p->cpu_hz ? (double)b.cycles / (double)p->cpu_hz : 0.0);
+    std::printf("  MIPS       %10.2f   (%.1f%% of real time)\n",
+                rate(a.instructions, b.instructions, ns) / 1e6,
+                p->cpu_hz ? 100.0 * rate(a.cycles, b.cycles, ns) / (double)p->cpu_hz : 0.0);
+    std::printf("  cycles     %20llu\n", (unsigned long long)b.cycles);
+    std::printf("  TLB        %20llu hits  %llu misses  (%.2f%% hit)\n",
+                (unsigned long long)b.tlb_hits, (unsigned long long)b.tlb_misses,
+                tlb ? 100.0 * (double)b.tlb_hits / (double)tlb : 0.0);
+    std::printf("  frames     %20llu presented  %llu vblanks  %.1f fps\n",
+                (unsigned long long)b.frames, (unsigned long long)b.vblanks,
+                rate(a.frames, b.frames, ns));
+    std::printf("  DMA        %20llu B to guest  %llu B from guest  (%.1f KB/s)\n",
+                (unsigned long long)b.dma_to, (unsigned long long)b.dma_from,
+                rate(a.dma_to + a.dma_from, b.dma_to + b.dma_from, ns) / 1024.0);
+    std::printf("  SCSI       %20llu B  (%.1f KB/s)\n", (unsigned long long)b.scsi,
+                rate(a.scsi, b.scsi, ns) / 1024.0);
+    std::printf("  Ethernet   %20llu B out  %llu B in\n",
+                (unsigned long long)b.net_tx, (unsigned long long)b.net_rx);
+    std::printf("  console    %20llu B  (%.0f chars/s)\n", (unsigned long long)b.uart_tx,
+                rate(a.uart_tx, b.uart_tx, ns));
+
+    if (b.hot_window) {
+        std::printf("  hottest functions (%llu samples)\n", (unsigned long long)b.hot_window);
+        for (uint32_t i = 0; i < PERF_HOT_FUNCS && b.hot_samples[i]; i++)
+            std::printf("    %5.1f%%  %s\n", 100.0 * (double)b.hot_samples[i] / (double)b.hot_window,
+                        b.hot_name[i]);
+    }
+
+    std::printf("  exceptions %20llu  (%.0f/s)\n", (unsigned long long)sum(b.exc, 32),
+                rate(sum(a.exc, 32), sum(b.exc, 32), ns));
+    for (int i = 0; i < 32; i++) {
+        if (!b.exc[i])
+            continue;
+        std::printf("    %-8s %20llu  (%.0f/s)\n", EXC_NAMES[i][0] ? EXC_NAMES[i] : "?",
+                    (unsigned long long)b.exc[i], rate(a.exc[i], b.exc[i], ns));
+    }
+
+    std::printf("  MMIO       %20llu reads  %llu writes\n",
+                (unsigned long long)sum(b.mmio_r, PERF_DEV_COUNT),
+                (unsigned long long)sum(b.mmio_w, PERF_DEV_COUNT));
+    for (int d = 0; d < (int)PERF_DEV_COUNT; d++) {
+        if (!b.mmio_r[d] && !b.mmio_w[d])
+            continue;
+        std::printf("    %-8s %20llu r  %12llu w  (%.0f/s)\n", perf_device_name(d),
+                    (unsigned long long)b.mmio_r[d], (unsigned long long)b.mmio_w[d],
+                    rate(a.mmio_r[d] + a.mmio_w[d], b.mmio_r[d] + b.mmio_w[d], ns));
+    }
+    std::fflush(stdout);
+}
+
+static void print_json(const PerfShm* p, const PerfSnapshot& a, const PerfSnapshot& b)
+{
+    const uint64_t ns = b.host_ns - a.host_ns;
+    auto u = [](uint64_t v) { return (unsigned long long)v; };
+
+    std::printf("{\n  \"racer_counters\": %u,\n", PERF_SHM_VERSION);
+    std::printf("  \"pid\": %u,\n  \"running\": %s,\n", p->writer_pid,
+                writer_alive(p) ? "true" : "false");
+    std::printf("  \"uptime_s\": %.3f,\n  \"interval_s\": %.3f,\n",
+                (b.host_ns - p->start_ns) / 1e9, ns / 1e9);
+    std::printf("  \"cpu_hz\": %llu,\n  \"cycles\": %llu,\n  \"instructions\": %llu,\n",
+                u(p->cpu_hz), u(b.cycles), u(b.instructions));
+    std::printf("  \"mips\": %.3f,\n", rate(a.instructions, b.instructions, ns) / 1e6);
+    std::printf("  \"tlb\": { \"hits\": %llu, \"misses\": %llu },\n",
+                u(b.tlb_hits), u(b.tlb_misses));
+
+    std::printf("  \"exceptions\": {");
+    bool first = true;
+    for (int i = 0; i < 32; i++) {
+        if (!EXC_NAMES[i][0] && !b.exc[i])
+            continue;
+        std::printf("%s\n    \"%s\": { \"count\": %llu, \"per_s\": %.1f }", first ? "" : ",",
+                    EXC_NAMES[i][0] ? EXC_NAMES[i] : std::to_string(i).c_str(),
+                    u(b.exc[i]), rate(a.exc[i], b.exc[i], ns));
+        first = false;
+    }
+    std::printf("\n  },\n");
+
+    std::printf("  \"mmio\": {");
+    for (int d = 0; d < (int)PERF_DEV_COUNT; d++) {
+        std::printf("%s\n    \"%s\": { \"reads\": %llu, \"writes\": %llu, \"per_s\": %.1f }",
+                    d ? "," : "", perf_device_name(d), u(b.mmio_r[d]), u(b.mmio_w[d]),
+                    rate(a.mmio_r[d] + a.mmio_w[d], b.mmio_r[d] + b.mmio_w[d], ns));
+    }
+    std::printf("\n  },\n");
+
+    std::printf("  \"frames\": { \"vblanks\": %llu, \"presented\": %llu, \"fps\": %.2f },\n",
+                u(b.vblanks), u(b.frames), rate(a.frames, b.frames, ns));
+
+    std::printf("  \"io_bytes\": {\n");
+    std::printf("    \"dma_to_guest\": %llu,\n    \"dma_from_guest\": %llu,\n",
+                u(b.dma_to), u(b.dma_from));
+    std::printf("    \"scsi\": %llu,\n    \"net_tx\": %llu,\n    \"net_rx\": %llu,\n",
+                u(b.scsi), u(b.net_tx), u(b.net_rx));
+    std::printf("    \"uart_tx\": %llu,\n", u(b.uart_tx));
+    std::printf("    \"dma_per_s\": %.1f,\n    \"scsi_per_s\": %.1f,\n    \"net_per_s\": %.1f,\n",
+                rate(a.dma_to + a.dma_from, b.dma_to + b.dma_from, ns),
+                rate(a.scsi, b.scsi, ns),
+                rate(a.net_tx + a.net_rx, b.net_tx + b.net_rx, ns));
+    std::printf("    \"uart_per_s\": %.1f\n  },\n", rate(a.uart_tx, b.uart_tx, ns));
+
+    std::printf("  \"hot_functions\": { \"samples\": %llu, \"top\": [", u(b.hot_window));
+    for (uint32_t i = 0; i < PERF_HOT_FUNCS && b.hot_samples[i]; i++) {
+        std::string name;
+        for (const char* c = b.hot_name[i]; *c; c++) {
+            if (*c == '"' || *c == '\\')
+                name += '\\';
+            name += (unsigned char)*c < 0x20 ? '?' : *c;
+        }
+        std::printf("%s\n    { \"function\": \"%s\", \"samples\": %llu }", i ? "," : "",
+                    name.c_str(), u(b.hot_samples[i]));
+    }
+    std::printf(" ] }\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: perf_counters_view /name [--json] [--interval ms] [--count n]\n";
+        return 1;
+    }
+
+    const std::string name = argv[1];
+    bool     json     = false;
+    unsigned interval = 1000;
+    unsigned count    = 0;          // live view: 0 = until interrupted
+
+    for (int i = 2; i < argc; i++) {
+        const std::string a = argv[i];
+        if (a == "--json")
+            json = true;
+        else if (a == "--interval" && i + 1 < argc)
+            interval = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--count" && i + 1 < argc)
+            count = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else {
+            std::cerr << "Unknown option: " << a << "\n";
+            return 1;
+        }
+    }
+
+    const PerfShm* p = map_page(name);
+    if (!p)
+        return 1;
+
+    PerfSnapshot prev, cur;
+    PerfCounters::snapshot(p, prev);
+
+    const bool tty = isatty(1);
+    for (unsigned n = 0; json ? n < 1 : (count == 0 || n < count); n++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        PerfCounters::snapshot(p, cur);
+
+        if (json) {
+            print_json(p, prev, cur);
+        } else {
+            if (tty)
+                std::printf("\033[H\033[J");
+            print_text(p, prev, cur);
+        }
+        prev = cur;
+
+        if (!writer_alive(p))
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,516 @@
+// racer_bench.cpp
+// Microbenchmarks for the emulator's hot paths.
+//
+//   cpu.*     synthetic MIPS streams executed through CPU::run
+//             (ALU, load/store sweep, branches, TLB-mapped, COP0)
+//   mem.*     Memory::read32 / write32, sequential and random
+//   mmu.*     MMU::read32, flat and through the TLB
+//   bus.*     MemoryBus::read32 dispatch to ROM, RAM and MMIO
+//   fb.*      guest -> host pixel conversion of a full frame
+//
+// Every benchmark reports ns/op and millions of ops per second
+// (MIPS for cpu.*, Mpixel/s for fb.*): the median of several timed
+// repetitions, each at least --min-ms long.
+//
+// Usage:
+//   racer_bench [--json] [--out <file>] [--filter <substr>] [--min-ms N] [--reps N]
+//
+// --json prints the results as JSON on stdout; the machine's own
+// messages are moved to stderr for the run. --out writes the JSON
+// to a file instead.
+//
+// Build (Linux): g++ -O2 -std=c++17 racer_bench.cpp ../cpu.cpp ../mmu.cpp ../cp0.cpp ../memory.cpp ../profile.cpp ../trace.cpp ../log.cpp ../dev/pixel_convert.cpp -o racer_bench -lpthread
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../cpu.h"
+#include "../cp0.h"
+#include "../mmu.h"
+#include "../memory.h"
+#include "../membus.h"
+#include "../log.h"
+#include "../dev/pixel_convert.h"
+
+// -----------------------------------------------------------
+// Harness
+// -----------------------------------------------------------
+struct Result {
+    std::string name;
+    std::string unit;       // what one op is
+    uint64_t    ops;        // per timed repetition (median run)
+    double      ns_per_op;
+    double      mops;
+};
+
+static uint64_t    min_ns = 200 * 1000000ull;
+static int         reps   = 5;
+static std::string filter;
+static std::vector<Result> results;
+
+// Defeats dead-code elimination of measured loads
+static volatile uint64_t sink;
+
+static double now_ns()
+{
+    using namespace std::chrono;
+    return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// fn(n) performs n ops. n grows until one call takes min_ns, then
+// 'reps' calls of that size are timed and the median kept.
+static void bench(const std::string& name, const std::string& unit,
+                  const std::function<void(uint64_t)>& fn)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    uint64_t n = 1000;
+    for (;;) {
+        double t0 = now_ns();
+        fn(n);
+        double dt = now_ns() - t0;
+        if (dt >= (double)min_ns || n >= (1ull << 40))
+            break;
+        n = dt > 1e6 ? (uint64_t)(n * (min_ns * 1.1 / dt)) : n * 10;
+    }
+
+    std::vector<double> per_op;
+    for (int r = 0; r < reps; r++) {
+        double t0 = now_ns();
+        fn(n);
+        per_op.push_back((now_ns() - t0) / (double)n);
+    }
+    std::sort(per_op.begin(), per_op.end());
+    const double med = per_op[per_op.size() / 2];
+
+    results.push_back({ name, unit, n, med, 1e3 / med });
+    std::fprintf(stderr, "  %-22s %10.2f ns/%-5s %10.1f M%s/s\n",
+                 name.c_str(), med, unit.c_str(), 1e3 / med, unit.c_str());
+}
+
+// -----------------------------------------------------------
+// MIPS assembler helpers
+// -----------------------------------------------------------
+enum Reg : uint32_t {
+    ZERO = 0, T0 = 8, T1, T2, T3, T4, T5, T6, T7,
+    S0 = 16, S1, S2, S3,
+};
+
+static uint32_t R(uint32_t rs, uint32_t rt, uint32_t rd, uint32_t sa, uint32_t fn)
+{
+    return (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | fn;
+}
+static uint32_t I(uint32_t op, uint32_t rs, uint32_t rt, int32_t imm)
+{
+    return (op << 26) | (rs << 21) | (rt << 16) | ((uint32_t)imm & 0xFFFF);
+}
+
+static uint32_t ADDU(uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x21); }
+static uint32_t SUBU(uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x23); }
+static uint32_t AND (uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x24); }
+static uint32_t OR  (uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x25); }
+static uint32_t XOR (uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x26); }
+static uint32_t SLT (uint32_t d, uint32_t s, uint32_t t) { return R(s, t, d, 0, 0x2A); }
+static uint32_t SLL (uint32_t d, uint32_t t, uint32_t sa) { return R(0, t, d, sa, 0x00); }
+static uint32_t ADDIU(uint32_t t, uint32_t s, int32_t imm) { return I(0x09, s, t, imm); }
+static uint32_t ANDI(uint32_t t, uint32_t s, int32_t imm)  { return I(0x0C, s, t, imm); }
+static uint32_t ORI (uint32_t t, uint32_t s, int32_t imm)  { return I(0x0D, s, t, imm); }
+static uint32_t LUI (uint32_t t, int32_t imm)              { return I(0x0F, 0, t, imm); }
+static uint32_t LW  (uint32_t t, int32_t off, uint32_t b)  { return I(0x23, b, t, off); }
+static uint32_t SW  (uint32_t t, int32_t off, uint32_t b)  { return I(0x2B, b, t, off); }
+static uint32_t MFC0(uint32_t t, uint32_t d) { return (0x10u << 26) | (0u << 21) | (t << 16) | (d << 11); }
+static uint32_t MTC0(uint32_t t, uint32_t d) { return (0x10u << 26) | (4u << 21) | (t << 16) | (d << 11); }
+static const uint32_t NOP = 0;
+
+// Guest program under construction; branch helpers resolve
+// offsets relative to the emitted position
+struct Program {
+    std::vector<uint32_t> words;
+
+    size_t here() const { return words.size(); }
+    void   emit(uint32_t w) { words.push_back(w); }
+    void   li(uint32_t r, uint32_t v) { emit(LUI(r, v >> 16)); emit(ORI(r, r, v & 0xFFFF)); }
+
+    void bne(uint32_t s, uint32_t t, size_t target) { emit(I(0x05, s, t, (int32_t)(target - here() - 1))); }
+    // J within the 256 MB region of 'base'
+    void j(uint64_t base, size_t target) { emit((0x02u << 26) | ((uint32_t)((base + target * 4) >> 2) & 0x03FFFFFF)); }
+};
+
+// -----------------------------------------------------------
+// CPU streams
+// -----------------------------------------------------------
+static constexpr uint64_t RAM_SIZE   = 64ull << 20;
+static constexpr uint64_t CODE_PHYS  = 0x1000;
+static constexpr uint64_t KSEG0      = 0xFFFFFFFF80000000ull;
+static constexpr uint64_t DATA_PHYS  = 0x100000;
+static constexpr uint64_t USER_CODE  = 0x00001000;      // TLB-mapped variant
+static constexpr uint64_t USER_DATA  = 0x00400000;
+
+struct Machine {
+    Memory mem;
+    MMU    mmu;
+    CP0    cp0;
+    CPU    cpu;
+
+    Machine()
+    {
+        mem.init(RAM_SIZE);
+        mmu.attach_memory(&mem);
+        mmu.attach_cp0(&cp0);
+        cp0.attach_cpu(&cpu);
+        cpu.attach_mmu(&mmu);
+        cpu.attach_cp0(&cp0);
+        cpu.attach_memory(&mem);
+        cp0.reset();
+        mmu.reset();
+        cpu.reset();
+    }
+
+    void load(const Program& p, uint64_t entry)
+    {
+        // Stored big-endian, as the guest sees it
+        for (size_t i = 0; i < p.words.size(); i++) {
+            uint32_t w = p.words[i];
+            uint8_t be[4] = { (uint8_t)(w >> 24), (uint8_t)(w >> 16), (uint8_t)(w >> 8), (uint8_t)w };
+            mem.load_blob(CODE_PHYS + i * 4, be, 4);
+        }
+        cpu.setPC(entry);
+    }
+};
+
+static void run_cpu(const std::string& name, const Program& p, uint64_t entry,
+                    const std::function<void(Machine&)>& setup = nullptr)
+{
+    Machine m;
+    if (setup)
+        setup(m);
+    m.load(p, entry);
+    // Warm the decode tables and caches outside the timed runs
+    m.cpu.run(10000);
+    bench(name, "instr", [&](uint64_t n) { m.cpu.run(n); });
+}
+
+static void cpu_benches()
+{
+    const uint64_t base = KSEG0 + CODE_PHYS;
+
+    {   // Dependent integer ALU ops
+        Program p;
+        p.li(T1, 3);
+        size_t loop = p.here();
+        p.emit(ADDU(T0, T0, T1));
+        p.emit(XOR(T2, T0, T1));
+        p.emit(SLL(T3, T2, 3));
+        p.emit(OR(T4, T3, T0));
+        p.emit(SUBU(T5, T4, T1));
+        p.emit(SLT(T6, T5, T0));
+        p.emit(ADDIU(T1, T1, 1));
+        p.emit(AND(T7, T6, T4));
+        p.j(base, loop);
+        p.emit(NOP);
+        run_cpu("cpu.alu", p, base);
+    }
+
+    {   // Load/store sweep over 64 KB of kseg0 data
+        Program p;
+        p.li(S0, (uint32_t)(KSEG0 + DATA_PHYS));
+        p.li(S2, 0xFFF0);
+        p.li(S3, (uint32_t)(KSEG0 + DATA_PHYS));
+        size_t loop = p.here();
+        p.emit(LW(T0, 0, S0));
+        p.emit(ADDIU(T0, T0, 1));
+        p.emit(SW(T0, 4, S0));
+        p.emit(LW(T1, 8, S0));
+        p.emit(SW(T1, 12, S0));
+        p.emit(ADDIU(S0, S0, 16));
+        p.emit(AND(S0, S0, S2));
+        p.emit(OR(S0, S0, S3));
+        p.j(base, loop);
+        p.emit(NOP);
+        run_cpu("cpu.loadstore", p, base);
+    }
+
+    {   // Branch heavy: alternating taken / not-taken with delay slots
+        Program p;
+        size_t loop = p.here();
+        p.emit(ADDIU(T0, T0, 1));
+        p.emit(ANDI(T1, T0, 1));
+        size_t b1 = p.here();
+        p.emit(NOP);                    // patched: beq t1, zero, skip
+        p.emit(NOP);
+        p.emit(ADDIU(T2, T2, 1));
+        size_t skip = p.here();
+        p.words[b1] = I(0x04, T1, ZERO, (int32_t)(skip - b1 - 1));
+        p.emit(ANDI(T3, T0, 2));
+        p.bne(T3, ZERO, loop);
+        p.emit(ADDIU(T4, T4, 1));       // delay slot
+        p.j(base, loop);
+        p.emit(NOP);
+        run_cpu("cpu.branch", p, base);
+    }
+
+    {   // Everything through the TLB: code page + 16 data pages
+        Program p;
+        p.li(S0, (uint32_t)USER_DATA);
+        p.li(S2, 0xFFF0);
+        p.li(S3, (uint32_t)USER_DATA);
+        size_t loop = p.here();
+        p.emit(LW(T0, 0, S0));
+        p.emit(SW(T0, 4, S0));
+        p.emit(ADDIU(S0, S0, 1024));
+        p.emit(AND(S0, S0, S2));
+        p.emit(OR(S0, S0, S3));
+        p.j(USER_CODE, loop);
+        p.emit(NOP);
+        run_cpu("cpu.tlb", p, USER_CODE, [](Machine& m) {
+            TLBEntry e;
+            e.valid = true;
+            e.vpn2  = USER_CODE >> 12;
+            e.pfn   = CODE_PHYS >> 12;
+            m.mmu.write_tlb(0, e);
+            for (int i = 0; i < 16; i++) {
+                e.vpn2 = (USER_DATA >> 12) + i;
+                e.pfn  = (DATA_PHYS >> 12) + i;
+                m.mmu.write_tlb(1 + i, e);
+            }
+            m.mmu.set_tlb_enabled(true);
+        });
+    }
+
+    {   // COP0 register traffic (Count/Compare/Status)
+        Program p;
+        size_t loop = p.here();
+        p.emit(MFC0(T0, 9));
+        p.emit(ADDIU(T0, T0, 100));
+        p.emit(MTC0(T0, 11));
+        p.emit(MFC0(T1, 12));
+        p.emit(MTC0(T1, 12));
+        p.j(base, loop);
+        p.emit(NOP);
+        run_cpu("cpu.cop0", p, base);
+    }
+}
+
+// -----------------------------------------------------------
+// Memory / MMU / bus
+// -----------------------------------------------------------
+static inline uint64_t lcg(uint64_t& s)
+{
+    s = s * 6364136223846793005ull + 1442695040888963407ull;
+    return s >> 33;
+}
+
+static void memory_benches()
+{
+    Memory mem;
+    mem.init(RAM_SIZE);
+    const uint64_t mask = (RAM_SIZE - 1) & ~3ull;
+
+    bench("mem.read32.seq", "op", [&](uint64_t n) {
+        uint64_t acc = 0, a = 0;
+        for (uint64_t i = 0; i < n; i++, a = (a + 4) & mask)
+            acc += mem.read32(a);
+        sink = acc;
+    });
+    bench("mem.read32.rand", "op", [&](uint64_t n) {
+        uint64_t acc = 0, s = 1;
+        for (uint64_t i = 0; i < n; i++)
+            acc += mem.read32((lcg(s) << 2) & mask);
+        sink = acc;
+    });
+    bench("mem.write32.seq", "op", [&](uint64_t n) {
+        uint64_t a = 0;
+        for (uint64_t i = 0; i < n; i++, a = (a + 4) & mask)
+            mem.write32(a, (uint32_t)i);
+    });
+    bench("mem.write32.rand", "op", [&](uint64_t n) {
+        uint64_t s = 1;
+        for (uint64_t i = 0; i < n; i++)
+            mem.write32((lcg(s) << 2) & mask, (uint32_t)i);
+    });
+
+    MMU mmu;
+    CP0 cp0;
+    mmu.attach_memory(&mem);
+    mmu.attach_cp0(&cp0);
+    mmu.reset();
+
+    bench("mmu.read32.flat", "op", [&](uint64_t n) {
+        uint64_t acc = 0, a = 0;
+        for (uint64_t i = 0; i < n; i++, a = (a + 4) & 0xFFFFF)
+            acc += mmu.read32(KSEG0 + a);
+        sink = acc;
+    });
+
+    for (int i = 0; i < 64; i++) {
+        TLBEntry e;
+        e.valid = true;
+        e.vpn2  = (USER_DATA >> 12) + i;
+        e.pfn   = (DATA_PHYS >> 12) + i;
+        mmu.write_tlb(i, e);
+    }
+    mmu.set_tlb_enabled(true);
+
+    bench("mmu.read32.tlb", "op", [&](uint64_t n) {
+        uint64_t acc = 0, s = 1;
+        for (uint64_t i = 0; i < n; i++)
+            acc += mmu.read32(USER_DATA + ((lcg(s) << 2) & 0x3FFFC));
+        sink = acc;
+    });
+}
+
+static void bus_benches()
+{
+    MemoryBus bus;
+    bus.add_rom(0x1FC00000, std::vector<uint8_t>(1 << 20, 0x5A));
+    bus.add_ram(0x00000000, 16u << 20);
+    uint32_t reg = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        MMIOHandler h;
+        h.read32  = [&reg](uint32_t off) { return reg + off; };
+        h.write32 = [&reg](uint32_t, uint32_t v) { reg = v; };
+        bus.add_mmio(0x1F000000 + i * 0x100000, 0x10000, h);
+    }
+
+    bench("bus.read32.rom", "op", [&](uint64_t n) {
+        uint64_t acc = 0;
+        for (uint64_t i = 0; i < n; i++)
+            acc += bus.read32(0x1FC00000 + ((uint32_t)(i << 2) & 0xFFFFC));
+        sink = acc;
+    });
+    bench("bus.read32.ram", "op", [&](uint64_t n) {
+        uint64_t acc = 0;
+        for (uint64_t i = 0; i < n; i++)
+            acc += bus.read32((uint32_t)(i << 2) & 0xFFFFFC);
+        sink = acc;
+    });
+    bench("bus.read32.mmio", "op", [&](uint64_t n) {
+        uint64_t acc = 0;
+        for (uint64_t i = 0; i < n; i++)
+            acc += bus.read32(0x1F300000 + ((uint32_t)(i << 2) & 0xFFFC));
+        sink = acc;
+    });
+}
+
+static void fb_benches()
+{
+    const uint32_t w = 1280, h = 1024;
+    std::vector<uint8_t>  src((size_t)w * h * 4, 0x3C);
+    std::vector<uint32_t> dst((size_t)w * h);
+
+    struct { const char* name; GuestPixelFormat fmt; } fmts[] = {
+        { "fb.convert.argb8888", GuestPixelFormat::ARGB8888 },
+        { "fb.convert.abgr8888", GuestPixelFormat::ABGR8888 },
+        { "fb.convert.rgb565",   GuestPixelFormat::RGB565 },
+    };
+
+    for (const auto& f : fmts) {
+        const size_t pitch = (size_t)w * guest_pixel_bytes(f.fmt);
+        // One op = one pixel: whole frames, then the leftover rows
+        bench(f.name, "pix", [&](uint64_t n) {
+            uint64_t rows = n / w;
+            for (; rows >= h; rows -= h)
+                convert_rect(f.fmt, src.data(), pitch, (uint8_t*)dst.data(), w * 4, w, h);
+            if (rows)
+                convert_rect(f.fmt, src.data(), pitch, (uint8_t*)dst.data(), w * 4, w, (uint32_t)rows);
+            sink = dst[0];
+        });
+    }
+}
+
+// -----------------------------------------------------------
+// Output
+// -----------------------------------------------------------
+static std::string json_escape(const std::string& s)
+{
+    std::string o;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            o += '\\';
+        o += c;
+    }
+    return o;
+}
+
+static void print_json(FILE* f)
+{
+    std::ostringstream o;
+    o << "{\n  \"racer_bench\": 1,\n";
+    o << "  \"compiler\": \"" << json_escape(__VERSION__) << "\",\n";
+    o << "  \"pixel_isa\": \"" << pixel_convert_isa() << "\",\n";
+    o << "  \"min_ms\": " << min_ns / 1000000 << ",\n  \"reps\": " << reps << ",\n";
+    o << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        char num[96];
+        std::snprintf(num, sizeof(num), "\"ns_per_op\": %.4f, \"mops\": %.3f", r.ns_per_op, r.mops);
+        o << (i ? ",\n" : "\n") << "    { \"name\": \"" << r.name << "\", \"unit\": \"" << r.unit
+          << "\", \"ops\": " << r.ops << ", " << num << " }";
+    }
+    o << "\n  ]\n}\n";
+    std::fputs(o.str().c_str(), f);
+}
+
+static int usage()
+{
+    std::cerr << "usage: racer_bench [--json] [--out <file>] [--filter <substr>] [--min-ms N] [--reps N]\n";
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--json")
+            json = true;
+        else if (a == "--out" && i + 1 < argc)
+            out_path = argv[++i];
+        else if (a == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (a == "--min-ms" && i + 1 < argc)
+            min_ns = std::strtoull(argv[++i], nullptr, 10) * 1000000ull;
+        else if (a == "--reps" && i + 1 < argc)
+            reps = std::max(1, std::atoi(argv[++i]));
+        else
+            return usage();
+    }
+
+    FILE* json_out = nullptr;
+    if (out_path) {
+        json_out = std::fopen(out_path, "w");
+        if (!json_out) {
+            std::perror(out_path);
+            return 1;
+        }
+    } else if (json) {
+        // The log writes straight to fd 1; keep the document alone on
+        // the real stdout and send everything else to stderr
+        std::fflush(stdout);
+        json_out = fdopen(dup(1), "w");
+        dup2(2, 1);
+    }
+
+    cpu_benches();
+    memory_benches();
+    bus_benches();
+    fb_benches();
+
+    if (json_out) {
+        Log::flush();
+        print_json(json_out);
+        std::fclose(json_out);
+    }
+    return 0;
+}
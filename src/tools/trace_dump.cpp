@@ -0,0 +1,141 @@
+// trace_dump.cpp
+// Decode binary instruction traces (ring dumps and streams, see
+// trace.h) into text.
+//
+// Usage:
+//   trace_dump [-s] [-t N] <trace>
+//     -s    summary only: events by kind, exceptions, hottest PCs
+//     -t N  print only the last N events
+//
+// Build (Linux): g++ -O2 -std=c++17 trace_dump.cpp ../trace.cpp ../log.cpp -o trace_dump -lpthread
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../trace.h"
+
+static int usage()
+{
+    std::cerr << "usage: trace_dump [-s] [-t N] <trace>\n";
+    return 1;
+}
+
+static void print(const Tracer::Event& e)
+{
+    switch (e.kind) {
+    case Tracer::EV_INSN:
+        std::printf("%016llx  %08x\n", (unsigned long long)e.a, e.c);
+        break;
+    case Tracer::EV_REG:
+        std::printf("                    r%-2u = %016llx\n", e.arg, (unsigned long long)e.b);
+        break;
+    case Tracer::EV_LOAD:
+    case Tracer::EV_STORE:
+        std::printf("                    %s%u [%016llx] %s %llx\n",
+                    e.kind == Tracer::EV_LOAD ? "ld" : "st", e.arg * 8,
+                    (unsigned long long)e.a, e.kind == Tracer::EV_LOAD ? "->" : "<-",
+                    (unsigned long long)e.b);
+        break;
+    case Tracer::EV_EXC:
+        std::printf("  ** exception %u at %016llx\n", e.arg, (unsigned long long)e.a);
+        break;
+    case Tracer::EV_MMIO_R:
+    case Tracer::EV_MMIO_W:
+        std::printf("  ** unknown MMIO %s %08llx %s %llx\n",
+                    e.kind == Tracer::EV_MMIO_R ? "read" : "write",
+                    (unsigned long long)e.a, e.kind == Tracer::EV_MMIO_R ? "->" : "<-",
+                    (unsigned long long)e.b);
+        break;
+    }
+}
+
+static void summary(Tracer::Reader& r)
+{
+    static const char* const KIND[] = { "?", "insn", "reg", "load", "store",
+                                        "exception", "mmio read", "mmio write" };
+    uint64_t by_kind[8] = {};
+    uint64_t exc[32] = {};
+    std::unordered_map<uint64_t, uint64_t> pcs;
+
+    Tracer::Event e;
+    while (r.next(e)) {
+        by_kind[e.kind & 7]++;
+        if (e.kind == Tracer::EV_INSN)
+            pcs[e.a]++;
+        else if (e.kind == Tracer::EV_EXC)
+            exc[e.arg & 31]++;
+    }
+
+    for (int k = 1; k < 8; k++)
+        std::printf("%-11s %14llu\n", KIND[k], (unsigned long long)by_kind[k]);
+
+    for (int i = 0; i < 32; i++)
+        if (exc[i])
+            std::printf("  ExcCode %-2d %12llu\n", i, (unsigned long long)exc[i]);
+
+    std::vector<std::pair<uint64_t, uint64_t>> hot(pcs.begin(), pcs.end());
+    const size_t top = std::min<size_t>(20, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + top, hot.end(),
+                      [](const auto& a, const auto& b) { return a.second > b.second; });
+    if (top)
+        std::printf("hottest PCs:\n");
+    for (size_t i = 0; i < top; i++)
+        std::printf("  %016llx %12llu\n", (unsigned long long)hot[i].first,
+                    (unsigned long long)hot[i].second);
+}
+
+int main(int argc, char** argv)
+{
+    bool   sum  = false;
+    size_t tail = 0;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "-s")
+            sum = true;
+        else if (a == "-t" && i + 1 < argc)
+            tail = std::strtoull(argv[++i], nullptr, 10);
+        else if (a[0] == '-' || path)
+            return usage();
+        else
+            path = argv[i];
+    }
+    if (!path)
+        return usage();
+
+    Tracer::Reader r;
+    if (!r.open(path))
+        return 1;
+
+    std::printf("# %s: %llu events%s\n", path, (unsigned long long)r.count(),
+                (r.flags() & Tracer::FLAG_RING) ? " (ring dump)" : "");
+
+    if (sum) {
+        summary(r);
+        return 0;
+    }
+
+    Tracer::Event e;
+    if (!tail) {
+        while (r.next(e))
+            print(e);
+        return 0;
+    }
+
+    std::deque<Tracer::Event> last;
+    while (r.next(e)) {
+        last.push_back(e);
+        if (last.size() > tail)
+            last.pop_front();
+    }
+    for (const auto& x : last)
+        print(x);
+    return 0;
+}
@@ -3,15 +3,36 @@
 // -----------------------------------------------------------
 // Racer Emulator (SGI Octane1)
 // Text-based UI launcher with configurable RAM
+//
+// While the emulator runs, the TUI shows a status view fed from
+// the live performance counters (see perf_counters.h): the CPU
+// runs on its own thread and is never paused for the display.
+// Console output goes to racer-console.log meanwhile; press q
+// to stop the machine.
 // -----------------------------------------------------------
 
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 #include "../src/emulator.h"
+#include "../src/perf_counters.h"
+#include "../src/dev/uart.h"
 
 static uint64_t selected_ram_mb = 512;   // default 512 MB
 static std::string prom_path = "ip30prom.rev4.9.bin";
+static std::string console_log = "racer-console.log";
+
+static constexpr int      REFRESH_MS   = 250;
+static constexpr uint64_t MIN_RATE_NS  = 200000000;   // rate window, host time
+static constexpr uint32_t SHOW_HOT     = 5;
 
 // -----------------------------------------------------------
 // TUI: Settings Menu
@@ -51,6 +72,86 @@ void menu_settings()
     }
 }
 
+// -----------------------------------------------------------
+// Status view
+// -----------------------------------------------------------
+
+// Single keys without Enter while the status view is up
+struct RawKeyboard {
+    termios saved;
+    bool    active = false;
+
+    RawKeyboard()
+    {
+        if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved) != 0)
+            return;
+        termios t = saved;
+        t.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &t);
+        active = true;
+    }
+
+    ~RawKeyboard()
+    {
+        if (active)
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+
+    // Next key within timeout_ms, or 0
+    char poll_key(int timeout_ms)
+    {
+        if (!active) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return 0;
+        }
+        pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        char c = 0;
+        if (::poll(&pfd, 1, timeout_ms) > 0 && ::read(STDIN_FILENO, &c, 1) != 1)
+            c = 0;
+        return c;
+    }
+};
+
+static double per_second(uint64_t a, uint64_t b, uint64_t ns)
+{
+    return ns ? (double)(b - a) * 1e9 / (double)ns : 0.0;
+}
+
+// a, b: snapshots at least MIN_RATE_NS apart (host time of publish)
+void draw_status(const PerfShm* page, const PerfSnapshot& a, const PerfSnapshot& b, bool running)
+{
+    const uint64_t ns   = b.host_ns - a.host_ns;
+    const double   hz   = per_second(a.cycles, b.cycles, ns);
+    const uint64_t hits = b.tlb_hits - a.tlb_hits;
+    const uint64_t miss = b.tlb_misses - a.tlb_misses;
+
+    std::printf("\033[H\033[J");
+    std::printf("Racer Emulator (SGI Octane1) - %s\n", running ? "running" : "stopped");
+    std::printf("---------------------------------\n");
+    std::printf("Guest time      %10.2f s   (RAM %llu MB)\n",
+                (double)b.cycles / (double)page->cpu_hz, (unsigned long long)selected_ram_mb);
+    std::printf("Emulated clock  %10.2f MHz\n", hz / 1e6);
+    std::printf("Instructions    %10.2f MIPS\n", per_second(a.instructions, b.instructions, ns) / 1e6);
+    std::printf("Real time       %10.1f %%\n", 100.0 * hz / (double)page->cpu_hz);
+    if (hits + miss)
+        std::printf("TLB miss rate   %10.3f %%   (%llu lookups)\n",
+                    100.0 * (double)miss / (double)(hits + miss), (unsigned long long)(hits + miss));
+    else
+        std::printf("TLB miss rate           -     (TLB off)\n");
+    std::printf("Console (UART)  %10.0f chars/s\n", per_second(a.uart_tx, b.uart_tx, ns));
+    std::printf("Frames          %10.1f fps\n", per_second(a.frames, b.frames, ns));
+
+    std::printf("\nHottest guest functions\n");
+    if (!b.hot_window)
+        std::printf("  (no samples yet)\n");
+    for (uint32_t i = 0; i < SHOW_HOT && i < PERF_HOT_FUNCS && b.hot_samples[i]; i++)
+        std::printf("  %5.1f%%  %s\n", 100.0 * (double)b.hot_samples[i] / (double)b.hot_window,
+                    b.hot_name[i]);
+
+    std::printf("\nConsole output: %s    q) Stop\n", console_log.c_str());
+    std::fflush(stdout);
+}
+
 // -----------------------------------------------------------
 // Launch Emulator
 // -----------------------------------------------------------
@@ -66,18 +167,70 @@ void launch_emulator()
         return;
     }
 
+    // Headless framebuffer: frames are counted, the terminal
+    // stays ours
+    emu.attach_framebuffer(0x1F600000ULL, 0x10000000ULL);
+    emu.start_headless();
+
     if (!emu.load_prom(prom_path))
     {
         std::cerr << "[TUI] Failed to load PROM.\n";
         return;
     }
 
+    // The status view owns the terminal; guest console to a file
+    if (!emu.uart_ref().open_sink(UART::Sink::File, console_log))
+        return;
+
+    if (!emu.export_counters("/racer-tui-" + std::to_string(getpid())))
+    {
+        std::cerr << "[TUI] Live counters unavailable.\n";
+        return;
+    }
+    const PerfShm* page = emu.counters();
+
     std::cout << "\n[TUI] Launching SGI Octane...\n";
     std::cout << "[TUI] RAM: " << selected_ram_mb << " MB\n";
 
-    // Run unlimited cycles (or a big number for now)
-    // PROM loops forever anyway.
-    emu.run(200000000); 
+    // Runs until stopped (PROM loops forever anyway)
+    std::atomic<bool> running{true};
+    std::string failure;
+    std::thread cpu_thread([&]() {
+        try {
+            emu.run(~0ULL);
+        } catch (const std::exception& ex) {
+            failure = ex.what();
+        }
+        running = false;
+    });
+
+    {
+        RawKeyboard kbd;
+        PerfSnapshot base, cur, shown_a, shown_b;
+        PerfCounters::snapshot(page, base);
+        shown_a = shown_b = base;
+
+        // Counters are published every 10 ms of guest time; rates
+        // are taken over at least MIN_RATE_NS of host time so a slow
+        // guest still gets a steady reading
+        while (running) {
+            if (kbd.poll_key(REFRESH_MS) == 'q')
+                emu.request_stop();
+
+            PerfCounters::snapshot(page, cur);
+            if (cur.host_ns - base.host_ns >= MIN_RATE_NS) {
+                shown_a = base;
+                shown_b = cur;
+                base = cur;
+            }
+            draw_status(page, shown_a, shown_b, running);
+        }
+        draw_status(page, shown_a, shown_b, false);
+    }
+
+    cpu_thread.join();
+    if (!failure.empty())
+        std::cerr << "[TUI] Emulator stopped: " << failure << "\n";
 }
 
 // -----------------------------------------------------------
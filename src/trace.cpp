@@ -0,0 +1,463 @@
+// -----------------------------------------------------------
+// trace.cpp
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Binary instruction trace: ring, stream, crash dump, reader
+//
+// Record encoding (after the 24-byte header), one kind byte then:
+//   INSN        zigzag(pc - (prev pc + 4)), word (4 bytes BE)
+//   REG         reg, zigzag(value - previous value of reg)
+//   LOAD/STORE  size, zigzag(vaddr - prev vaddr), value
+//   EXC         code, zigzag(pc - prev pc)
+//   MMIO_R/W    phys, value
+// Numbers are LEB128 varints. Delta state starts at zero at the
+// top of every file.
+// -----------------------------------------------------------
+
+#include "trace.h"
+#include "log.h"
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char TRACE_MAGIC[8] = { 'R', 'A', 'C', 'E', 'R', 'T', 'R', 'C' };
+
+static inline uint64_t zigzag(uint64_t delta)
+{
+    return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t v)
+{
+    return (v >> 1) ^ (0 - (v & 1));
+}
+
+// Crash handler state (one owner per process)
+static const Tracer* crash_tracer = nullptr;
+static char          crash_path[512];
+
+// Signal stack of this thread, taken down before it is freed
+struct AltStack {
+    std::vector<uint8_t> mem;
+
+    ~AltStack()
+    {
+        if (mem.empty())
+            return;
+        stack_t ss = {};
+        ss.ss_flags = SS_DISABLE;
+        sigaltstack(&ss, nullptr);
+    }
+};
+static thread_local AltStack alt_stack;
+
+Tracer::Tracer()
+{
+}
+
+Tracer::~Tracer()
+{
+    stop();
+    if (crash_tracer == this)
+        crash_tracer = nullptr;
+}
+
+// -----------------------------------------------------------
+// Destination register of an instruction
+// -----------------------------------------------------------
+uint32_t Tracer::dest_reg(uint32_t ins)
+{
+    // SPECIAL functs that write rd (not JR, SYSCALL, BREAK, SYNC,
+    // MTHI/MTLO, multiply/divide, traps)
+    static constexpr uint64_t SPECIAL_RD =
+        (1ULL << 0)  | (1ULL << 1)  | (1ULL << 2)  | (1ULL << 3)  |
+        (1ULL << 4)  | (1ULL << 6)  | (1ULL << 7)  | (1ULL << 9)  |
+        (1ULL << 10) | (1ULL << 11) | (1ULL << 16) | (1ULL << 18) |
+        (1ULL << 20) | (1ULL << 22) | (1ULL << 23) |
+        (0xFFULL << 32) | (0x3FULL << 42) |
+        (1ULL << 56) | (1ULL << 58) | (1ULL << 59) | (1ULL << 60) |
+        (1ULL << 62) | (1ULL << 63);
+
+    // Primary opcodes that write rt: immediate ALU, loads, LL/SC
+    static constexpr uint64_t MAIN_RT =
+        (0xFFULL << 8) | (0xFULL << 24) | (0xFFULL << 32) |
+        (1ULL << 48) | (1ULL << 52) | (1ULL << 55) | (1ULL << 56) | (1ULL << 60);
+
+    const uint32_t op = ins >> 26;
+    const uint32_t rs = (ins >> 21) & 31;
+    const uint32_t rt = (ins >> 16) & 31;
+    const uint32_t rd = (ins >> 11) & 31;
+
+    switch (op) {
+    case 0x00: return (SPECIAL_RD >> (ins & 63)) & 1 ? rd : 0;
+    case 0x01: return (rt >= 16 && rt <= 19) ? 31 : 0;     // BLTZAL..BGEZALL
+    case 0x03: return 31;                                   // JAL
+    case 0x10: return (rs == 0 || rs == 1) ? rt : 0;        // MFC0 / DMFC0
+    default:   return (MAIN_RT >> op) & 1 ? rt : 0;
+    }
+}
+
+// -----------------------------------------------------------
+// Start / stop
+// -----------------------------------------------------------
+bool Tracer::start_ring(size_t events)
+{
+    stop();
+
+    size_t n = 1024;
+    while (n < events)
+        n <<= 1;
+
+    ring = new (std::nothrow) Event[n];
+    if (!ring) {
+        Log::err() << "[TRACE] Cannot allocate " << n << " events\n";
+        return false;
+    }
+    std::memset(ring, 0, n * sizeof(Event));
+    dump_enc = new Encoder();
+    mask = n - 1;
+    head.store(0, std::memory_order_release);
+
+    Log::out() << "[TRACE] Keeping the last " << n << " events ("
+               << (n * sizeof(Event)) / (1024 * 1024) << " MB)\n";
+    return true;
+}
+
+bool Tracer::start_file(const std::string& path)
+{
+    stop();
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        Log::err() << "[TRACE] Cannot create " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    if (!write_header(fd, 0, 0)) {
+        ::close(fd);
+        return false;
+    }
+
+    stream = new Encoder();
+    stream->fd = fd;
+    stream->reset_state();
+    head.store(0, std::memory_order_release);
+
+    Log::out() << "[TRACE] Streaming to " << path << "\n";
+    return true;
+}
+
+void Tracer::stop()
+{
+    if (stream) {
+        stream->flush();
+
+        // Event count goes into the header once known
+        uint8_t cnt[8];
+        const uint64_t n = events();
+        for (int i = 0; i < 8; i++)
+            cnt[i] = (uint8_t)(n >> (8 * i));
+        if (::pwrite(stream->fd, cnt, 8, 16) != 8)
+            Log::err() << "[TRACE] Could not finish trace header\n";
+
+        ::close(stream->fd);
+        delete stream;
+        stream = nullptr;
+    }
+
+    if (ring && crash_tracer == this)
+        crash_tracer = nullptr;
+    delete[] ring;
+    delete dump_enc;
+    ring = nullptr;
+    dump_enc = nullptr;
+    mask = 0;
+}
+
+// -----------------------------------------------------------
+// Encoder
+// -----------------------------------------------------------
+void Tracer::Encoder::reset_state()
+{
+    len = 0;
+    last_pc = 0;
+    last_addr = 0;
+    std::memset(last_reg, 0, sizeof(last_reg));
+}
+
+bool Tracer::Encoder::flush()
+{
+    size_t off = 0;
+    while (off < len) {
+        ssize_t n = ::write(fd, buf + off, len - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            len = 0;
+            return false;
+        }
+        off += (size_t)n;
+    }
+    len = 0;
+    return true;
+}
+
+void Tracer::Encoder::varint(uint64_t v)
+{
+    while (v >= 0x80) {
+        buf[len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    buf[len++] = (uint8_t)v;
+}
+
+void Tracer::Encoder::encode(const Event& e)
+{
+    // Largest record: kind + arg + two 10-byte varints
+    if (len > sizeof(buf) - 32)
+        flush();
+
+    buf[len++] = e.kind;
+    switch (e.kind) {
+    case EV_INSN:
+        varint(zigzag(e.a - (last_pc + 4)));
+        last_pc = e.a;
+        buf[len++] = (uint8_t)(e.c >> 24);
+        buf[len++] = (uint8_t)(e.c >> 16);
+        buf[len++] = (uint8_t)(e.c >> 8);
+        buf[len++] = (uint8_t)e.c;
+        break;
+    case EV_REG:
+        buf[len++] = e.arg;
+        varint(zigzag(e.b - last_reg[e.arg & 31]));
+        last_reg[e.arg & 31] = e.b;
+        break;
+    case EV_LOAD:
+    case EV_STORE:
+        buf[len++] = e.arg;
+        varint(zigzag(e.a - last_addr));
+        last_addr = e.a;
+        varint(e.b);
+        break;
+    case EV_EXC:
+        buf[len++] = e.arg;
+        varint(zigzag(e.a - last_pc));
+        break;
+    default:
+        varint(e.a);
+        varint(e.b);
+        break;
+    }
+}
+
+// -----------------------------------------------------------
+// Ring dump
+// -----------------------------------------------------------
+bool Tracer::write_header(int fd, uint32_t flags, uint64_t count) const
+{
+    uint8_t h[HEADER_SIZE];
+    std::memcpy(h, TRACE_MAGIC, 8);
+    for (int i = 0; i < 4; i++) {
+        h[8 + i]  = (uint8_t)(VERSION >> (8 * i));
+        h[12 + i] = (uint8_t)(flags >> (8 * i));
+    }
+    for (int i = 0; i < 8; i++)
+        h[16 + i] = (uint8_t)(count >> (8 * i));
+    return ::write(fd, h, sizeof(h)) == (ssize_t)sizeof(h);
+}
+
+// Async-signal-safe: no allocation, write(2) only. The encoder
+// belongs to this tracer, so machines can dump concurrently.
+bool Tracer::dump_fd(int fd) const
+{
+    if (!ring)
+        return false;
+
+    Encoder& enc = *dump_enc;
+
+    const uint64_t end   = head.load(std::memory_order_acquire);
+    const uint64_t size  = mask + 1;
+    const uint64_t begin = end > size ? end - size : 0;
+
+    if (!write_header(fd, FLAG_RING, end - begin))
+        return false;
+
+    enc.fd = fd;
+    enc.reset_state();
+    for (uint64_t i = begin; i < end; i++)
+        enc.encode(ring[i & mask]);
+    return enc.flush();
+}
+
+bool Tracer::dump(const std::string& path) const
+{
+    if (!ring) {
+        Log::err() << "[TRACE] dump: ring not running\n";
+        return false;
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        Log::err() << "[TRACE] Cannot create " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    bool ok = dump_fd(fd);
+    ::close(fd);
+
+    if (ok)
+        Log::out() << "[TRACE] Ring written to " << path << "\n";
+    return ok;
+}
+
+// -----------------------------------------------------------
+// Crash dump
+// -----------------------------------------------------------
+void Tracer::crash_handler(int sig)
+{
+    if (crash_tracer) {
+        int fd = ::open(crash_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            crash_tracer->dump_fd(fd);
+            ::close(fd);
+            static const char msg[] = "[TRACE] Crashed; last events written to ";
+            (void)!::write(2, msg, sizeof(msg) - 1);
+            (void)!::write(2, crash_path, std::strlen(crash_path));
+            (void)!::write(2, "\n", 1);
+        }
+    }
+
+    // SA_RESETHAND restored the default action
+    ::raise(sig);
+}
+
+void Tracer::install_crash_dump(const std::string& path)
+{
+    std::strncpy(crash_path, path.c_str(), sizeof(crash_path) - 1);
+    crash_tracer = this;
+    protect_thread();
+
+    struct sigaction sa = {};
+    sa.sa_handler = crash_handler;
+    sa.sa_flags   = SA_RESETHAND | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    for (int sig : { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT })
+        sigaction(sig, &sa, nullptr);
+}
+
+// Own stack, so a guest-induced host stack overflow still dumps
+void Tracer::protect_thread()
+{
+    if (!alt_stack.mem.empty())
+        return;
+
+    alt_stack.mem.resize(64 * 1024);
+    stack_t ss = {};
+    ss.ss_sp   = alt_stack.mem.data();
+    ss.ss_size = alt_stack.mem.size();
+    sigaltstack(&ss, nullptr);
+}
+
+// -----------------------------------------------------------
+// Reader
+// -----------------------------------------------------------
+bool Tracer::Reader::open(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        Log::err() << "[TRACE] Cannot open " << path << "\n";
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), TRACE_MAGIC, 8) != 0) {
+        Log::err() << "[TRACE] Not a trace file: " << path << "\n";
+        return false;
+    }
+
+    uint32_t version = 0;
+    for (int i = 3; i >= 0; i--) {
+        version   = (version << 8) | data[8 + i];
+        hdr_flags = (hdr_flags << 8) | data[12 + i];
+    }
+    for (int i = 7; i >= 0; i--)
+        hdr_count = (hdr_count << 8) | data[16 + i];
+
+    if (version != VERSION) {
+        Log::err() << "[TRACE] Unsupported trace version " << version << "\n";
+        return false;
+    }
+
+    pos = HEADER_SIZE;
+    return true;
+}
+
+bool Tracer::Reader::varint(uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= data.size())
+            return false;
+        uint8_t b = data[pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool Tracer::Reader::next(Event& e)
+{
+    if (pos >= data.size())
+        return false;
+
+    e = {};
+    e.kind = data[pos++];
+
+    uint64_t v;
+    switch (e.kind) {
+    case EV_INSN:
+        if (!varint(v) || pos + 4 > data.size())
+            return false;
+        e.a = last_pc + 4 + unzigzag(v);
+        last_pc = e.a;
+        e.c = ((uint32_t)data[pos] << 24) | ((uint32_t)data[pos + 1] << 16) |
+              ((uint32_t)data[pos + 2] << 8) | data[pos + 3];
+        pos += 4;
+        return true;
+    case EV_REG:
+        if (pos >= data.size())
+            return false;
+        e.arg = data[pos++] & 31;
+        if (!varint(v))
+            return false;
+        e.b = last_reg[e.arg] + unzigzag(v);
+        last_reg[e.arg] = e.b;
+        return true;
+    case EV_LOAD:
+    case EV_STORE:
+        if (pos >= data.size())
+            return false;
+        e.arg = data[pos++];
+        if (!varint(v))
+            return false;
+        e.a = last_addr + unzigzag(v);
+        last_addr = e.a;
+        return varint(e.b);
+    case EV_EXC:
+        if (pos >= data.size())
+            return false;
+        e.arg = data[pos++];
+        if (!varint(v))
+            return false;
+        e.a = last_pc + unzigzag(v);
+        return true;
+    case EV_MMIO_R:
+    case EV_MMIO_W:
+        e.arg = 4;
+        return varint(e.a) && varint(e.b);
+    default:
+        Log::err() << "[TRACE] Corrupt record at offset " << (pos - 1) << "\n";
+        return false;
+    }
+}
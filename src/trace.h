@@ -0,0 +1,187 @@
+// -----------------------------------------------------------
+// trace.h
+// -----------------------------------------------------------
+// Racer SGI Octane1 Emulator
+// Binary instruction trace
+//
+//   - Events: instruction (PC + word), register write, guest
+//     load/store, exception, unknown MMIO access
+//   - Ring mode keeps the last N events in memory: one 24-byte
+//     store per event, single producer (the CPU thread), no
+//     locks. The ring is written out on request and from the
+//     crash handler (SIGSEGV/SIGBUS/SIGILL/SIGFPE/SIGABRT).
+//   - File mode streams every event, delta compressed (PC, address
+//     and per-register value deltas as zigzag varints), through a
+//     64 KB buffer
+//   - Both produce the same file format; tools/trace_dump decodes it
+//
+// The TRACE_* hooks only exist in builds with -DRACER_TRACE;
+// otherwise they expand to nothing. Compiled in but not started,
+// each hook is one predictable null-pointer test.
+// -----------------------------------------------------------
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Tracer {
+public:
+    enum Kind : uint8_t {
+        EV_INSN   = 1,  // a = pc, c = instruction word
+        EV_REG    = 2,  // arg = register, b = new value
+        EV_LOAD   = 3,  // arg = size, a = vaddr, b = value
+        EV_STORE  = 4,  // arg = size, a = vaddr, b = value
+        EV_EXC    = 5,  // arg = ExcCode, a = pc
+        EV_MMIO_R = 6,  // unknown MMIO: a = phys, b = value
+        EV_MMIO_W = 7,
+    };
+
+    struct Event {
+        uint64_t a;
+        uint64_t b;
+        uint32_t c;
+        uint8_t  kind;
+        uint8_t  arg;
+        uint16_t pad;
+    };
+
+    // File header: "RACERTRC", version, flags, events in the file
+    static constexpr uint32_t VERSION       = 1;
+    static constexpr uint32_t FLAG_RING     = 1;    // ring dump, not a stream
+    static constexpr size_t   HEADER_SIZE   = 24;
+
+    Tracer();
+    ~Tracer();
+
+    // Keep the last 'events' events (rounded up to a power of two)
+    bool start_ring(size_t events);
+
+    // Stream everything to 'path'
+    bool start_file(const std::string& path);
+
+    void stop();
+
+    // Write the ring (oldest first) to 'path'
+    bool dump(const std::string& path) const;
+
+    // Dump the ring to 'path' if the process crashes. One tracer
+    // per process can own the crash handler.
+    //
+    // A signal stack is per thread: the handler survives a host
+    // stack overflow only in threads that called protect_thread()
+    // (this does it for the caller, Emulator::run for the CPU
+    // thread). Other crashes dump from any thread.
+    void install_crash_dump(const std::string& path);
+
+    // Give the calling thread its own signal stack
+    static void protect_thread();
+
+    uint64_t events() const { return head.load(std::memory_order_relaxed); }
+
+    // -------------------------------------------------------
+    // Hooks
+    // -------------------------------------------------------
+    inline void insn(uint64_t pc, uint32_t ins) { put(EV_INSN, 0, pc, 0, ins); }
+
+    // After the instruction: record its destination register
+    inline void retire(uint32_t ins, const uint64_t* regs)
+    {
+        const uint32_t r = dest_reg(ins);
+        if (r)
+            put(EV_REG, (uint8_t)r, 0, regs[r], 0);
+    }
+
+    inline void load(uint64_t vaddr, uint64_t value, uint8_t size)  { put(EV_LOAD, size, vaddr, value, 0); }
+    inline void store(uint64_t vaddr, uint64_t value, uint8_t size) { put(EV_STORE, size, vaddr, value, 0); }
+    inline void exception(int code, uint64_t pc) { put(EV_EXC, (uint8_t)(code & 31), pc, 0, 0); }
+    inline void mmio(bool write, uint64_t phys, uint64_t value)
+    {
+        put(write ? EV_MMIO_W : EV_MMIO_R, 4, phys, value, 0);
+    }
+
+    // GPR an instruction writes, 0 if none (or HI/LO/CP0 only)
+    static uint32_t dest_reg(uint32_t ins);
+
+    // -------------------------------------------------------
+    // Reading trace files (tools/trace_dump)
+    // -------------------------------------------------------
+    class Reader {
+    public:
+        bool open(const std::string& path);
+        bool next(Event& e);
+
+        uint32_t flags() const { return hdr_flags; }
+        uint64_t count() const { return hdr_count; }
+
+    private:
+        std::vector<uint8_t> data;
+        size_t   pos = 0;
+        uint32_t hdr_flags = 0;
+        uint64_t hdr_count = 0;
+        uint64_t last_pc   = 0;
+        uint64_t last_addr = 0;
+        uint64_t last_reg[32] = {};
+
+        bool varint(uint64_t& v);
+    };
+
+private:
+    // Delta encoder, writing with write(2) only so the crash
+    // handler can use it
+    struct Encoder {
+        int      fd = -1;
+        uint8_t  buf[65536];
+        size_t   len       = 0;
+        uint64_t last_pc   = 0;
+        uint64_t last_addr = 0;
+        uint64_t last_reg[32];
+
+        void reset_state();
+        void encode(const Event& e);
+        bool flush();
+        void varint(uint64_t v);
+    };
+
+    Event*   ring = nullptr;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> head{0};
+
+    Encoder* stream = nullptr;
+    Encoder* dump_enc = nullptr;    // ring mode: for dump_fd, allocated up front
+
+    inline void put(uint8_t kind, uint8_t arg, uint64_t a, uint64_t b, uint32_t c)
+    {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (ring) {
+            Event& e = ring[h & mask];
+            e.a = a; e.b = b; e.c = c; e.kind = kind; e.arg = arg;
+        } else if (stream) {
+            stream->encode({ a, b, c, kind, arg, 0 });
+        }
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    bool write_header(int fd, uint32_t flags, uint64_t count) const;
+    bool dump_fd(int fd) const;
+
+    static void crash_handler(int sig);
+};
+
+#ifdef RACER_TRACE
+#define TRACE_INSN(t, pc, ins)          do { if (t) (t)->insn(pc, ins); } while (0)
+#define TRACE_RETIRE(t, ins, regs)      do { if (t) (t)->retire(ins, regs); } while (0)
+#define TRACE_LOAD(t, va, v, size)      do { if (t) (t)->load(va, v, size); } while (0)
+#define TRACE_STORE(t, va, v, size)     do { if (t) (t)->store(va, v, size); } while (0)
+#define TRACE_EXC(t, code, pc)          do { if (t) (t)->exception(code, pc); } while (0)
+#define TRACE_MMIO(t, write, pa, v)     do { if (t) (t)->mmio(write, pa, v); } while (0)
+#else
+#define TRACE_INSN(t, pc, ins)          ((void)0)
+#define TRACE_RETIRE(t, ins, regs)      ((void)0)
+#define TRACE_LOAD(t, va, v, size)      ((void)0)
+#define TRACE_STORE(t, va, v, size)     ((void)0)
+#define TRACE_EXC(t, code, pc)          ((void)0)
+#define TRACE_MMIO(t, write, pa, v)     ((void)0)
+#endif